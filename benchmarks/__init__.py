@@ -0,0 +1,4 @@
+#
+# __init__.py - Benchmarks for the libroboticscape Python bindings
+# Copyright (C) 2017 Torsten Kurbad <beaglebone@tk-webart.de>
+#
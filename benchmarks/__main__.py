@@ -0,0 +1,50 @@
+#
+# __main__.py - Command line entry point of the binding benchmarks
+# Copyright (C) 2017 Torsten Kurbad <beaglebone@tk-webart.de>
+#
+# Usage: python3 -m benchmarks [--json FILE] [--samples N] [--filter TEXT]
+#
+
+import argparse
+import json
+import sys
+
+from benchmarks import suite
+
+def main(argv = None):
+    parser = argparse.ArgumentParser(prog = 'python3 -m benchmarks',
+        description = 'Measure the per-call overhead of every _roboticscape binding.')
+    parser.add_argument('--json', metavar = 'FILE',
+        help = 'write machine-readable results to FILE ("-" for stdout)')
+    parser.add_argument('--samples', type = int, default = 20000,
+        help = 'calls per binding (default: %(default)s)')
+    parser.add_argument('--filter', metavar = 'TEXT',
+        help = 'only run bindings whose name contains TEXT')
+    options = parser.parse_args(argv)
+
+    report = suite.run(options.samples, options.filter)
+
+    if options.json == '-':
+        json.dump(report, sys.stdout, indent = 2, sort_keys = True)
+        print()
+    else:
+        print('%-34s %10s %10s %10s %10s %8s' %
+              ('binding', 'ns/call', 'p50', 'p99', 'p99.9', 'alloc B'))
+        for name, result in report['results'].items():
+            print('%-34s %10.1f %10d %10d %10d %8d' %
+                  (name, result['ns_per_call'], result['p50_ns'], result['p99_ns'],
+                   result['p999_ns'], result['alloc_bytes_per_call']))
+        if report['skipped']:
+            print('skipped (not safe on hardware): %s' % ', '.join(report['skipped']))
+        if options.json:
+            with open(options.json, 'w') as f:
+                json.dump(report, f, indent = 2, sort_keys = True)
+
+    if report['uncovered']:
+        print('bindings without benchmark: %s' % ', '.join(report['uncovered']),
+              file = sys.stderr)
+        return 1
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main())
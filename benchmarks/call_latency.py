@@ -0,0 +1,30 @@
+#!/usr/bin/env python3
+#
+# call_latency.py - Per-call latency micro-benchmark for the
+# libroboticscape Python bindings
+# Copyright (C) 2017 Torsten Kurbad <beaglebone@tk-webart.de>
+#
+
+import timeit
+
+import _roboticscape as rc
+
+# (label, statement) pairs; every statement is a single binding call
+CALLS = (
+    ('rcGetState()',                        'rc.rcGetState()'),
+    ('rcSetMotor(1, 0.5)',                  'rc.rcSetMotor(1, 0.5)'),
+    ('rcGetEncoderPos(1)',                  'rc.rcGetEncoderPos(1)'),
+    ('rcADCRaw(0)',                         'rc.rcADCRaw(0)'),
+    ('rcSendServoPulseUs(1, 1500)',         'rc.rcSendServoPulseUs(1, 1500)'),
+    ('rcSendServoPulseNormalized(1, 0.5)',  'rc.rcSendServoPulseNormalized(1, 0.5)'),
+    ('rcBlinkLED(0, 1.0, 1.0)',             'rc.rcBlinkLED(0, 1.0, 1.0)'),
+)
+
+def main(number = 200000, repeat = 5):
+    for label, statement in CALLS:
+        timer = timeit.Timer(statement, globals = {'rc': rc})
+        best = min(timer.repeat(repeat = repeat, number = number))
+        print('%-40s %8.1f ns/call' % (label, best / number * 1e9))
+
+if __name__ == '__main__':
+    main()
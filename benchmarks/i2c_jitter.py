@@ -0,0 +1,59 @@
+#!/usr/bin/env python3
+#
+# i2c_jitter.py - Control loop jitter while another thread performs
+# blocking I²C transactions
+# Copyright (C) 2017 Torsten Kurbad <beaglebone@tk-webart.de>
+#
+
+import threading
+import time
+
+import _roboticscape as rc
+
+def control_loop(hz, duration, stop):
+    """ Fixed rate loop; returns the absolute wakeup errors in seconds. """
+    period = 1.0 / hz
+    errors = []
+    deadline = time.monotonic() + period
+    end = time.monotonic() + duration
+    while time.monotonic() < end:
+        delay = deadline - time.monotonic()
+        if delay > 0:
+            time.sleep(delay)
+        errors.append(abs(time.monotonic() - deadline))
+        rc.rcGetEncoderPos(1)
+        deadline += period
+    stop.set()
+    return errors
+
+def sensor_loop(stop):
+    """ Hammer the barometer and a raw register read on bus 2. """
+    while not stop.is_set():
+        rc.rcReadBarometer()
+        rc.rcReadI2CByte(2, 0x75)
+
+def run(hz, duration, with_sensor):
+    stop = threading.Event()
+    sensor = None
+    if with_sensor:
+        sensor = threading.Thread(target = sensor_loop, args = (stop,))
+        sensor.start()
+    errors = sorted(control_loop(hz, duration, stop))
+    if sensor is not None:
+        sensor.join()
+    return errors
+
+def report(label, errors):
+    def pct(p):
+        return errors[min(len(errors) - 1, int(len(errors) * p))] * 1e6
+    print('%-16s p50 %8.1f us  p99 %8.1f us  max %8.1f us' %
+          (label, pct(0.50), pct(0.99), errors[-1] * 1e6))
+
+def main(hz = 1000, duration = 5.0):
+    rc.rcInitializeI2C(2, 0x68)
+    report('idle', run(hz, duration, False))
+    report('sensor thread', run(hz, duration, True))
+    rc.rcCloseI2C(2)
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,409 @@
+#
+# suite.py - Per-call overhead benchmark of every binding in
+# _roboticscape
+# Copyright (C) 2017 Torsten Kurbad <beaglebone@tk-webart.de>
+#
+
+import array
+import atexit
+import os
+import platform
+import sys
+import tempfile
+import time
+import timeit
+import tracemalloc
+
+import _roboticscape as rc
+
+SIMULATION = bool(getattr(rc, 'RC_SIMULATION', 0))
+
+
+class Bench(object):
+    """ One benchmarked call: func(*args, **kwargs). setup runs once
+        before, teardown after every single call (untimed). Calls that
+        block, change hardware state for a long time or need user
+        interaction on a real board are marked sim_only.
+    """
+    def __init__(self, name, args = (), kwargs = None, setup = None,
+                 teardown = None, sim_only = False, samples = None):
+        self.name = name
+        self.args = args
+        self.kwargs = kwargs or {}
+        self.setup = setup
+        self.teardown = teardown
+        self.sim_only = sim_only
+        self.samples = samples
+
+
+def _stop_loop_after_one_tick(inputs):
+    rc.rcStopLoop()
+
+def _ignore_frame(channels):
+    pass
+
+def _ignore_sample(sample):
+    pass
+
+_i2c_buf = bytearray(14)
+_i2c_words = array.array('H', [0] * 7)
+_spi_tx = bytes(24)
+_spi_rx = bytearray(24)
+_uart_line = b'$GPGGA,,,,,,0,,,,,,,,*66\n'
+_uart_rx = bytearray(len(_uart_line))
+_controller = rc.Controller(0.001, kp = 0.5, ki = 0.1, kd = 0.01, tau = 0.005)
+# Bound controllers drive motor 1 in a closed loop
+if SIMULATION:
+    _controller.bind(1, 1, velocity = True)
+atexit.register(_controller.stop)
+_filter = rc.DiscreteFilter.butterworth(4, 0.001, 50.0)
+_filter_in = array.array('d', [0.5] * 1000)
+_filter_out = array.array('f', [0.0] * 1000)
+_gps_sentence = b'$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47\r\n'
+_adc_out = array.array('f', [0.0] * 64)
+_encoders = array.array('l', [0] * 4)
+_duties = array.array('f', [0.0] * 4)
+_dsm_frame = array.array('d', [0.0] * 12)
+_setpoints = array.array('f', [0.0] * 8)
+_bmp_out = array.array('f', [0.0] * 96)
+_imu_sample = array.array('f', [0.0] * 16)
+_encoder_estimates = array.array('d', [0.0] * 12)
+_imu_out = array.array('f', [0.0] * 256)
+_imu_fifo = array.array('f', [0.0] * 6 * 42)
+
+def _start_encoder_estimator():
+    if not rc.rcGetEncoderEstimatorStatus()[0]:
+        rc.rcStartEncoderEstimator(1000.0)
+        time.sleep(0.01)
+
+def _start_adc_sampler():
+    if not rc.rcGetADCSamplerStatus()[0]:
+        rc.rcStartADCSampler([0, 1], 1000.0)
+
+def _start_servo_service():
+    if not rc.rcGetServoServiceStatus()[0]:
+        rc.rcStartServoService(50.0, 0)
+
+def _start_barometer_service():
+    if not rc.rcGetBarometerServiceStatus()[0]:
+        rc.rcStartBarometerService()
+
+def _start_gps_service():
+    if not rc.rcGetGPSServiceStatus()[0]:
+        rc.rcStartGPSService(2, 115200)
+        rc.rcSendUARTBytes(2, _gps_sentence)
+        time.sleep(0.05)
+
+def _start_imu_fifo():
+    if not rc.rcGetIMUFIFOStatus()[0]:
+        rc.rcStartIMUFIFO()
+
+def _start_imu_dmp():
+    if not rc.rcGetIMUServiceStatus()[0]:
+        rc._rcInitializeIMUDMP(1, 2, 1, 1, 1, 200, 136, 5.0, 256)
+        time.sleep(0.02)
+
+def _stop_imu_dmp():
+    # DMP mode owns the I²C bus the barometer and I²C benches use
+    if rc.rcGetIMUServiceStatus()[0]:
+        rc.rcPowerOffIMU()
+
+def _start_dsm():
+    rc.rcInitializeDSM()
+    time.sleep(0.05)
+
+_dsm_recording = os.path.join(tempfile.gettempdir(), 'rc-bench-%d.dsm' % os.getpid())
+atexit.register(lambda: os.path.exists(_dsm_recording) and os.remove(_dsm_recording))
+
+def _start_dsm_recording():
+    rc.rcStartDSMRecording(_dsm_recording)
+
+def _prepare_dsm_replay():
+    rc.rcStopDSMRecording()
+    _start_dsm()
+    _start_dsm_recording()
+    time.sleep(0.1)
+    rc.rcStopDSMRecording()
+    rc.rcStopDSMService()
+
+def _start_dsm_replay():
+    rc.rcStartDSMReplay(_dsm_recording, realtime = False)
+
+# Setup order matters: buses, barometer and DSM are brought up first,
+# functions tearing things down come last.
+BENCHES = (
+    Bench('rcInitialize', samples = 100),
+    Bench('rcGetState'),
+    Bench('rcSetState', (1,)),
+    Bench('rcGetLED', (0,)),
+    Bench('rcSetLED', (0, 1)),
+    Bench('rcBlinkLED', (0, 10.0, 0.1), sim_only = True, samples = 100),
+    Bench('rcGetButton', (0,)),
+    Bench('rcEnableMotors'),
+    Bench('rcSetMotor', (1, 0.5), sim_only = True),
+    Bench('rcSetMotorAll', (0.25,), sim_only = True),
+    Bench('rcSetMotors', (_duties,)),
+    Bench('rcSetMotorFreeSpin', (1,)),
+    Bench('rcSetMotorFreeSpinAll'),
+    Bench('rcSetMotorBrake', (1,)),
+    Bench('rcSetMotorBrakeAll'),
+    Bench('rcGetEncoderPos', (1,)),
+    Bench('rcGetEncoderPosAll', kwargs = {'out': _encoders}),
+    Bench('rcSetEncoderPos', (1, 0)),
+    Bench('rcStartEncoderEstimator', (1000.0,), teardown = rc.rcStopEncoderEstimator, samples = 200),
+    Bench('rcGetEncoderEstimates', kwargs = {'out': _encoder_estimates}, setup = _start_encoder_estimator),
+    Bench('rcGetEncoderEstimatorStatus'),
+    Bench('rcStopEncoderEstimator', teardown = _start_encoder_estimator, samples = 200),
+    Bench('rcBatteryVoltage'),
+    Bench('rcDCJackVoltage'),
+    Bench('rcADCRaw', (0,)),
+    Bench('rcADCVolt', (0,)),
+    Bench('rcStartADCSampler', ([0, 1], 1000.0), teardown = rc.rcStopADCSampler, samples = 100),
+    Bench('rcReadADCSamples', (_adc_out,), setup = _start_adc_sampler),
+    Bench('rcGetADCSamplerStatus'),
+    Bench('rcStopADCSampler', teardown = _start_adc_sampler, samples = 100),
+    Bench('rcEnableServoPowerRail', sim_only = True),
+    Bench('rcSendServoPulseUs', (1, 1500), sim_only = True),
+    Bench('rcSendServoPulseUsAll', (1500,), sim_only = True),
+    Bench('rcSendServoPulseNormalized', (1, 0.5), sim_only = True),
+    Bench('rcSendServoPulseNormalizedAll', (0.5,), sim_only = True),
+    Bench('rcSendESCPulseNormalized', (1, 0.5), sim_only = True),
+    Bench('rcSendESCPulseNormalizedAll', (0.5,), sim_only = True),
+    Bench('rcSendOneshotPulseNormalized', (1, 0.5), sim_only = True),
+    Bench('rcSendOneshotPulseNormalizedAll', (0.5,), sim_only = True),
+    Bench('rcSendServoPulseNormalizedVector', (_setpoints,), sim_only = True),
+    Bench('rcSendESCPulseNormalizedVector', (_setpoints,), sim_only = True),
+    Bench('rcSendOneshotPulseNormalizedVector', (_setpoints,), sim_only = True),
+    Bench('rcStartServoService', (50.0, 0), teardown = rc.rcStopServoService, sim_only = True, samples = 100),
+    Bench('rcSetServoSetpoints', (_setpoints,), setup = _start_servo_service, sim_only = True),
+    Bench('rcGetServoServiceStatus'),
+    Bench('rcStopServoService', teardown = _start_servo_service, sim_only = True, samples = 100),
+    Bench('rcDisableServoPowerRail'),
+    Bench('rcRunLoop', (_stop_loop_after_one_tick, 10000.0), samples = 100),
+    Bench('rcStopLoop'),
+    Bench('rcGetLoopStats'),
+    Bench('rcInitializeDSM', setup = _start_dsm),
+    Bench('rcGetDSMChRaw', (1,)),
+    Bench('rcGetDSMChNormalized', (1,)),
+    Bench('rcIsDSMNewData'),
+    Bench('rcIsDSMActive'),
+    Bench('rcNanosSinceLastDSMPacket'),
+    Bench('rcGetDSMResolution'),
+    Bench('rcNumDSMChannels'),
+    Bench('rcWaitDSMFrame', (0.0,), setup = _start_dsm),
+    Bench('rcGetDSMFrame', kwargs = {'out': _dsm_frame}),
+    Bench('rcSetDSMCallback', (_ignore_frame,), teardown = lambda: rc.rcSetDSMCallback(None), samples = 100),
+    Bench('rcBindDSM', sim_only = True),
+    Bench('rcCalibrateDSMRoutine', sim_only = True),
+    Bench('rcStartDSMRecording', (_dsm_recording,), teardown = rc.rcStopDSMRecording, samples = 50),
+    Bench('rcStopDSMRecording', setup = _start_dsm_recording, teardown = _start_dsm_recording, samples = 50),
+    Bench('rcStopDSMService', teardown = rc.rcInitializeDSM, samples = 50),
+    Bench('rcStartDSMReplay', (_dsm_recording,), {'realtime': False}, setup = _prepare_dsm_replay,
+          teardown = rc.rcStopDSMReplay, samples = 50),
+    Bench('rcStopDSMReplay', setup = _start_dsm_replay, teardown = _start_dsm_replay, samples = 50),
+    Bench('_rcInitializeIMU', (1, 2, 1, 1, 1), samples = 200),
+    Bench('rcReadAccelData', samples = 2000),
+    Bench('rcReadGyroData', samples = 2000),
+    Bench('rcReadMagData', samples = 2000),
+    Bench('rcReadIMUTemp', samples = 2000),
+    Bench('rcIsGyroCalibrated'),
+    Bench('rcIsMagCalibrated'),
+    Bench('rcWasLastIMUReadSuccessful'),
+    Bench('rcStartIMUFIFO', teardown = rc.rcStopIMUFIFO, samples = 100),
+    Bench('rcReadIMUFIFO', (_imu_fifo,), setup = _start_imu_fifo, samples = 2000),
+    Bench('rcGetIMUFIFOStatus', samples = 2000),
+    Bench('rcStopIMUFIFO', teardown = _start_imu_fifo, samples = 100),
+    Bench('rcCalibrateGyroRoutine', sim_only = True, samples = 3),
+    Bench('rcCalibrateMagRoutine', sim_only = True, samples = 3),
+    Bench('_rcInitializeIMUDMP', (1, 2, 1, 1, 1, 200, 136, 5.0, 256), teardown = rc.rcPowerOffIMU, samples = 20),
+    Bench('rcNanosSinceLastIMUInterrupt', setup = _start_imu_dmp),
+    Bench('rcGetIMUSample', kwargs = {'out': _imu_sample}),
+    Bench('rcReadIMUSamples', (_imu_out,)),
+    Bench('rcSetIMUCallback', (_ignore_sample,), teardown = lambda: rc.rcSetIMUCallback(None), samples = 100),
+    Bench('rcGetIMUServiceStatus'),
+    Bench('rcPowerOffIMU', teardown = _start_imu_dmp, samples = 20),
+    Bench('_rcInitializeBarometer', (4, 0, 3, 0.5, 0.05), setup = _stop_imu_dmp, samples = 200),
+    Bench('rcReadBarometer', samples = 2000),
+    Bench('rcGetBMPTemperature'),
+    Bench('rcGetBMPPressurePa'),
+    Bench('rcGetBMPAltitudeM'),
+    Bench('rcGetBMPFilteredAltitudeM'),
+    Bench('rcGetBMPVerticalSpeedMS'),
+    Bench('rcSetBMPSeaLevelPressurePa', (101325.0,)),
+    Bench('rcStartBarometerService', teardown = rc.rcStopBarometerService, samples = 100),
+    Bench('rcGetBarometerSample', setup = _start_barometer_service),
+    Bench('rcReadBarometerSamples', (_bmp_out,)),
+    Bench('rcGetBarometerServiceStatus'),
+    Bench('rcStopBarometerService', teardown = _start_barometer_service, samples = 100),
+    Bench('rcPowerOffBarometer', teardown = lambda: rc._rcInitializeBarometer(4, 0), samples = 200),
+    Bench('rcInitializeI2C', (2, 0x68), samples = 200),
+    Bench('rcSetI2CDeviceAddress', (2, 0x68), samples = 200),
+    Bench('rcClaimI2CBus', (2,)),
+    Bench('rcGetI2CBusInUse', (2,)),
+    Bench('rcReleaseI2CBus', (2,)),
+    Bench('rcReadI2CByte', (2, 0x75), samples = 2000),
+    Bench('rcReadI2CBytes', (2, 0x3b, _i2c_buf), samples = 2000),
+    Bench('rcReadI2CWord', (2, 0x3b), samples = 2000),
+    Bench('rcReadI2CWords', (2, 0x3b, _i2c_words), samples = 2000),
+    Bench('rcReadI2CBit', (2, 0x75, 0), samples = 2000),
+    Bench('rcWriteI2CByte', (2, 0x6b, 0x00), samples = 2000),
+    Bench('rcWriteI2CBytes', (2, 0x6b, b'\x00\x00'), samples = 2000),
+    Bench('rcWriteI2CWord', (2, 0x6b, 0x0000), samples = 2000),
+    Bench('rcWriteI2CWords', (2, 0x6b, array.array('H', [0, 0])), samples = 2000),
+    Bench('rcWriteI2CBit', (2, 0x6b, 7, 0), samples = 2000),
+    Bench('rcSendI2CByte', (2, 0x00), samples = 2000),
+    Bench('rcSendI2CBytes', (2, 2, b'\x00\x00'), samples = 2000),
+    Bench('rcCloseI2C', (2,), teardown = lambda: rc.rcInitializeI2C(2, 0x68), samples = 200),
+    Bench('rcInitializeSPI', (0, 0, 1000000, 1), samples = 200),
+    Bench('rcGetSPIFd', (1,)),
+    Bench('rcSendSPIBytes', (1, b'\x00\x00'), samples = 2000),
+    Bench('rcReadSPIBytes', (1, _spi_rx), samples = 2000),
+    Bench('rcTransferSPI', (1, _spi_tx, _spi_rx), {'transfers': 8}, samples = 2000),
+    Bench('rcSelectSPISlave', (2,), setup = lambda: rc.rcInitializeSPI(1, 0, 1000000, 2)),
+    Bench('rcDeselectSPISlave', (2,)),
+    Bench('rcCloseSPI', (1,), teardown = lambda: rc.rcInitializeSPI(0, 0, 1000000, 1), samples = 200),
+    Bench('rcInitializeUART', (1, 4000000, 0.1), samples = 200),
+    Bench('rcGetUARTFd', (1,)),
+    Bench('rcSendUARTBytes', (1, _uart_line), samples = 400),
+    Bench('rcUARTBytesAvailable', (1,)),
+    Bench('rcReadUARTLine', (1, _uart_rx), samples = 200),
+    Bench('rcReadUARTBytes', (1, _uart_rx), {'timeout': 0}, samples = 200),
+    Bench('rcSendUARTByte', (1, 0x24), samples = 400),
+    Bench('rcFlushUART', (1,), samples = 200),
+    Bench('rcCloseUART', (1,), teardown = lambda: rc.rcInitializeUART(1, 4000000, 0.1), samples = 200),
+    Bench('rcStartGPSService', (2, 115200), teardown = rc.rcStopGPSService, samples = 20),
+    Bench('rcGetGPSFix', setup = _start_gps_service),
+    Bench('rcGetGPSServiceStatus'),
+    Bench('rcStopGPSService', teardown = _start_gps_service, samples = 20),
+    Bench('Controller', (0.001,), {'kp': 0.5, 'ki': 0.1}),
+    Bench('Controller.transfer_function', ([0.5, 0.5], [1.0, -0.9], 0.001)),
+    Bench('Controller.step', (_controller, 0.25)),
+    Bench('Controller.reset', (_controller,)),
+    Bench('Controller.bind', (_controller, 1, 1), {'velocity': True}, sim_only = True),
+    Bench('Controller.start', (_controller,), teardown = _controller.stop, sim_only = True, samples = 200),
+    Bench('Controller.status', (_controller,)),
+    Bench('Controller.stop', (_controller,), teardown = _controller.start, sim_only = True, samples = 200),
+    Bench('DiscreteFilter', ([0.5, 0.5], [1.0, -0.9], 0.001)),
+    Bench('DiscreteFilter.butterworth', (4, 0.001, 50.0)),
+    Bench('DiscreteFilter.lowpass', (0.001, 0.05)),
+    Bench('DiscreteFilter.highpass', (0.001, 0.05)),
+    Bench('DiscreteFilter.march', (_filter, 0.5)),
+    Bench('DiscreteFilter.apply', (_filter, _filter_in, _filter_out), samples = 2000),
+    Bench('DiscreteFilter.prefill', (_filter, 0.5)),
+    Bench('DiscreteFilter.reset', (_filter,)),
+    Bench('rcSetCPUFreq', (0,), sim_only = True),
+    Bench('rcGetCPUFreq'),
+    Bench('rcGetBBModel'),
+    Bench('rcEnableStats', (0,)),
+    Bench('rcGetStats'),
+    Bench('rcResetStats'),
+    Bench('rcDisableMotors'),
+    Bench('rcCleanup', samples = 100),
+)
+
+
+def _percentile(sorted_values, fraction):
+    return sorted_values[min(len(sorted_values) - 1, int(len(sorted_values) * fraction))]
+
+def _timer_overhead():
+    clock = time.perf_counter_ns
+    samples = []
+    for i in range(10000):
+        start = clock()
+        samples.append(clock() - start)
+    samples.sort()
+    return _percentile(samples, 0.5)
+
+def run_bench(bench, samples, overhead):
+    """ Measure one binding; returns a dict of results. Methods of the
+        module's types are named 'Type.method' and get the instance as
+        first argument.
+    """
+    func = rc
+    for name in bench.name.split('.'):
+        func = getattr(func, name)
+    args = bench.args
+    kwargs = bench.kwargs
+    clock = time.perf_counter_ns
+    number = bench.samples or samples
+
+    if bench.setup is not None:
+        bench.setup()
+
+    # Warm up and measure transient allocations of a single call
+    func(*args, **kwargs)
+    if bench.teardown is not None:
+        bench.teardown()
+    tracemalloc.start()
+    tracemalloc.reset_peak()
+    base = tracemalloc.get_traced_memory()[0]
+    func(*args, **kwargs)
+    alloc_bytes = tracemalloc.get_traced_memory()[1] - base
+    tracemalloc.stop()
+    if bench.teardown is not None:
+        bench.teardown()
+
+    # Individual calls for the latency distribution; latencies live in
+    # a preallocated array so only the binding changes the block count
+    latencies = array.array('q', bytes(8 * number))
+    blocks = sys.getallocatedblocks()
+    for i in range(number):
+        start = clock()
+        func(*args, **kwargs)
+        latencies[i] = max(0, clock() - start - overhead)
+        if bench.teardown is not None:
+            bench.teardown()
+    leaked = (sys.getallocatedblocks() - blocks) / float(number)
+    latencies = sorted(latencies)
+
+    # Back-to-back calls for the mean cost without timer overhead. The
+    # call is compiled as written in user code, without *args unpacking.
+    if bench.teardown is None:
+        names = dict(('a%d' % i, arg) for i, arg in enumerate(args))
+        names.update(kwargs)
+        names['func'] = func
+        statement = 'func(%s)' % ', '.join(
+            ['a%d' % i for i in range(len(args))] +
+            ['%s=%s' % (key, key) for key in kwargs])
+        timer = timeit.Timer(statement, globals = names)
+        ns_per_call = timer.timeit(number) * 1e9 / number
+    else:
+        ns_per_call = sum(latencies) / float(number)
+
+    return {
+        'ns_per_call': round(ns_per_call, 1),
+        'p50_ns': _percentile(latencies, 0.5),
+        'p99_ns': _percentile(latencies, 0.99),
+        'p999_ns': _percentile(latencies, 0.999),
+        'alloc_bytes_per_call': alloc_bytes,
+        'leaked_blocks_per_call': round(leaked, 3),
+        'samples': number,
+    }
+
+def run(samples = 20000, pattern = None):
+    """ Run all benchmarks whose name contains pattern. """
+    overhead = _timer_overhead()
+    results = {}
+    skipped = []
+    for bench in BENCHES:
+        if pattern is not None and pattern not in bench.name:
+            continue
+        if bench.sim_only and not SIMULATION:
+            skipped.append(bench.name)
+            continue
+        results[bench.name] = run_bench(bench, samples, overhead)
+
+    covered = set(bench.name for bench in BENCHES)
+    uncovered = sorted(name for name in dir(rc)
+                       if name.startswith(('rc', '_rc')) and callable(getattr(rc, name))
+                       and name not in covered)
+
+    return {
+        'python': platform.python_version(),
+        'machine': platform.machine(),
+        'simulation': SIMULATION,
+        'timer_overhead_ns': overhead,
+        'results': results,
+        'skipped': skipped,
+        'uncovered': uncovered,
+    }
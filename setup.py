@@ -1,10 +1,25 @@
 #!/usr/bin/env python3
 
+import os
+
 try:
     from setuptools import find_packages, setup, Extension
 except ImportError:
     from distutils.core import find_packages, setup, Extension
 
+# Set ROBOTICSCAPE_SIMULATION=1 to build against the simulated
+# libroboticscape in src/roboticscape/sim instead of the installed library,
+# e.g. to build, test and benchmark on a machine other than a BeagleBone.
+if os.environ.get('ROBOTICSCAPE_SIMULATION', '0') not in ('', '0'):
+    sources = ['src/roboticscape/_roboticscapemodule.c',
+               'src/roboticscape/sim/rc_sim.c']
+    compile_args = ['-Isrc/roboticscape/sim', '-Isrc/roboticscape']
+    link_args = ['-lpthread', '-lm']
+else:
+    sources = ['src/roboticscape/_roboticscapemodule.c']
+    compile_args = ['-Isrc/roboticscape']
+    link_args = ['-lroboticscape', '-lpthread']
+
 setup(
     name = 'roboticscape',
 	version = '0.1',
@@ -19,7 +34,7 @@ setup(
     packages=find_packages(where="src"),
 	ext_modules = [
         Extension('_roboticscape',
-                  ['src/roboticscape/_roboticscapemodule.c'],
-                  extra_compile_args = ['-Isrc/roboticscape'],
-                  extra_link_args = ['-lroboticscape'])],
+                  sources,
+                  extra_compile_args = compile_args,
+                  extra_link_args = link_args)],
 )
@@ -7,6 +7,7 @@ import atexit
 from enum import IntEnum
 
 from _roboticscape import *
+from _roboticscape import _rcInitializeIMU, _rcInitializeIMUDMP
 from _roboticscape import _rcInitializeBarometer
 
 # Meta definitions
@@ -54,6 +55,63 @@ class ButtonState(MyIntEnum):
     PRESSED         = 1
 
 
+class ServoMode(MyIntEnum):
+    """ Enumeration of pulse types sent by rcStartServoService(). """
+    SERVO           = 0     # normalized range -1.5 ~ 1.5
+    ESC             = 1     # normalized range -0.1 ~ 1.0
+    ONESHOT         = 2     # normalized range -0.1 ~ 1.0
+
+
+class AccelFSR(MyIntEnum):
+    """ Enumeration of accelerometer full scale ranges. """
+    A_FSR_2G        = 0
+    A_FSR_4G        = 1
+    A_FSR_8G        = 2
+    A_FSR_16G       = 3
+
+
+class GyroFSR(MyIntEnum):
+    """ Enumeration of gyroscope full scale ranges. """
+    G_FSR_250DPS    = 0
+    G_FSR_500DPS    = 1
+    G_FSR_1000DPS   = 2
+    G_FSR_2000DPS   = 3
+
+
+class AccelDLPF(MyIntEnum):
+    """ Enumeration of accelerometer low pass filter bandwidths. """
+    ACCEL_DLPF_OFF  = 0
+    ACCEL_DLPF_184  = 1     # 184 Hz
+    ACCEL_DLPF_92   = 2
+    ACCEL_DLPF_41   = 3
+    ACCEL_DLPF_20   = 4
+    ACCEL_DLPF_10   = 5
+    ACCEL_DLPF_5    = 6
+
+
+class GyroDLPF(MyIntEnum):
+    """ Enumeration of gyroscope low pass filter bandwidths. """
+    GYRO_DLPF_OFF   = 0
+    GYRO_DLPF_184   = 1     # 184 Hz
+    GYRO_DLPF_92    = 2
+    GYRO_DLPF_41    = 3
+    GYRO_DLPF_20    = 4
+    GYRO_DLPF_10    = 5
+    GYRO_DLPF_5     = 6
+
+
+class IMUOrientation(MyIntEnum):
+    """ Enumeration of board orientations for the DMP. """
+    ORIENTATION_Z_UP        = 136
+    ORIENTATION_Z_DOWN      = 396
+    ORIENTATION_X_UP        = 14
+    ORIENTATION_X_DOWN      = 266
+    ORIENTATION_Y_UP        = 112
+    ORIENTATION_Y_DOWN      = 336
+    ORIENTATION_X_FORWARD   = 133
+    ORIENTATION_X_BACK      = 161
+
+
 class BMPOversample(MyIntEnum):
     """ Enumeration of BMP280 oversample settings. """
     BMP_OVERSAMPLE_1    = 4     # update rate 182 HZ
@@ -72,6 +130,30 @@ class BMPFilter(MyIntEnum):
     BMP_FILTER_16       = 16
 
 
+class AltitudeFilter(MyIntEnum):
+    """ Enumeration of native altitude filters for the barometer. """
+    NONE            = 0
+    LOWPASS         = 1     # timeConstant
+    ALPHA_BETA      = 2     # alpha, beta
+    KALMAN          = 3     # accelNoise, altitudeNoise
+
+
+class SSMode(MyIntEnum):
+    """ Enumeration of SPI slave select modes for rcInitializeSPI(). """
+    SS_MODE_AUTO    = 0     # driver toggles slave select per transfer
+    SS_MODE_MANUAL  = 1     # rcSelectSPISlave/rcDeselectSPISlave
+
+
+class GPSFixQuality(MyIntEnum):
+    """ Enumeration of GPSFix.quality values (as in NMEA GGA). """
+    GPS_FIX_NONE        = 0
+    GPS_FIX_GNSS        = 1
+    GPS_FIX_DGNSS       = 2
+    GPS_FIX_RTK         = 4
+    GPS_FIX_RTK_FLOAT   = 5
+    GPS_FIX_ESTIMATED   = 6     # dead reckoning
+
+
 class CPUFreq(MyIntEnum):
     """ Enumeration of possible CPU frequencies. """
     FREQ_ONDEMAND   = 0
@@ -130,15 +212,84 @@ def rcGetPauseButton():
     """ Get state of pause button as Enum. """
     return ButtonState(rcGetButton(Button.PAUSE.value))
 
+def _rcIMUConfig(accelFSR, gyroFSR, accelDLPF, gyroDLPF, enableMagnetometer):
+    """ Check the common IMU settings and return them as tuple. """
+    if not AccelFSR.has_value(accelFSR):
+        raise(ValueError('accel range value %d not allowed' % accelFSR))
+    if not GyroFSR.has_value(gyroFSR):
+        raise(ValueError('gyro range value %d not allowed' % gyroFSR))
+    if not AccelDLPF.has_value(accelDLPF):
+        raise(ValueError('accel filter value %d not allowed' % accelDLPF))
+    if not GyroDLPF.has_value(gyroDLPF):
+        raise(ValueError('gyro filter value %d not allowed' % gyroDLPF))
+    return (accelFSR, gyroFSR, accelDLPF, gyroDLPF, int(bool(enableMagnetometer)))
+
+def rcInitializeIMU(
+    accelFSR = AccelFSR.A_FSR_4G.value,
+    gyroFSR = GyroFSR.G_FSR_1000DPS.value,
+    accelDLPF = AccelDLPF.ACCEL_DLPF_184.value,
+    gyroDLPF = GyroDLPF.GYRO_DLPF_184.value,
+    enableMagnetometer = False):
+    """ Initialize and power on the IMU for polled reads with
+        rcReadAccelData, rcReadGyroData, rcReadMagData and rcReadIMUTemp.
+    """
+    return _rcInitializeIMU(*_rcIMUConfig(accelFSR, gyroFSR, accelDLPF,
+                                          gyroDLPF, enableMagnetometer))
+
+def rcInitializeIMUDMP(
+    sampleRate = 100,
+    orientation = IMUOrientation.ORIENTATION_Z_UP.value,
+    enableMagnetometer = False,
+    compassTimeConstant = 5.0,
+    capacity = 256,
+    accelFSR = AccelFSR.A_FSR_4G.value,
+    gyroFSR = GyroFSR.G_FSR_1000DPS.value,
+    accelDLPF = AccelDLPF.ACCEL_DLPF_184.value,
+    gyroDLPF = GyroDLPF.GYRO_DLPF_184.value):
+    """ Initialize and power on the IMU in DMP interrupt mode. Every
+        sample is buffered natively (up to capacity, see
+        rcReadIMUSamples), is available from rcGetIMUSample and is passed
+        to the callback set by rcSetIMUCallback. sampleRate (Hz) has to
+        divide 200.
+    """
+    if not IMUOrientation.has_value(orientation):
+        raise(ValueError('orientation value %d not allowed' % orientation))
+    return _rcInitializeIMUDMP(*_rcIMUConfig(accelFSR, gyroFSR, accelDLPF,
+                                             gyroDLPF, enableMagnetometer),
+                               sampleRate, orientation, compassTimeConstant,
+                               capacity)
+
 def rcInitializeBarometer(
     bmpOversample = BMPOversample.BMP_OVERSAMPLE_1.value,
-    bmpFilter = BMPFilter.BMP_FILTER_OFF.value):
-    """ Initialize and power on barometer. """
+    bmpFilter = BMPFilter.BMP_FILTER_OFF.value,
+    altitudeFilter = AltitudeFilter.NONE.value,
+    timeConstant = 0.5,
+    alpha = 0.3,
+    beta = 0.05,
+    accelNoise = 0.5,
+    altitudeNoise = 0.05):
+    """ Initialize and power on barometer. Every reading, by
+        rcReadBarometer or the barometer service, is also passed through
+        altitudeFilter; the result is available from
+        rcGetBMPFilteredAltitudeM and rcGetBMPVerticalSpeedMS.
+        LOWPASS uses timeConstant (s), ALPHA_BETA alpha and beta, KALMAN
+        the variances accelNoise (m^2/s^4) and altitudeNoise (m^2).
+    """
     if not BMPOversample.has_value(bmpOversample):
         raise(ValueError('oversample value %d not allowed' % bmpOversample))
     if not BMPFilter.has_value(bmpFilter):
         raise(ValueError('filter value %d not allowed' % bmpFilter))
-    return _rcInitializeBarometer(bmpOversample, bmpFilter)
+    if not AltitudeFilter.has_value(altitudeFilter):
+        raise(ValueError('altitude filter value %d not allowed' % altitudeFilter))
+    if altitudeFilter == AltitudeFilter.LOWPASS:
+        params = (timeConstant, 0.0)
+    elif altitudeFilter == AltitudeFilter.ALPHA_BETA:
+        params = (alpha, beta)
+    elif altitudeFilter == AltitudeFilter.KALMAN:
+        params = (accelNoise, altitudeNoise)
+    else:
+        params = (0.0, 0.0)
+    return _rcInitializeBarometer(bmpOversample, bmpFilter, altitudeFilter, *params)
 
 def rcSetCPUFreqEnum(frequency):
     """ Set the CPU frequency of the BeagleBone using values provided by
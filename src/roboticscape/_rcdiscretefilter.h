@@ -0,0 +1,189 @@
+/*
+ * _rcdiscretefilter.h - Discrete SISO transfer function core used by the
+ * native controllers and filters of the libroboticscape Python bindings
+ *
+ * Copyright (C) 2017 Torsten Kurbad <beaglebone@tk-webart.de>
+ *
+ */
+
+#ifndef _RCDISCRETEFILTER_H
+#define _RCDISCRETEFILTER_H
+
+#include <complex.h>
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+#define DFILTER_MAX_ORDER	10
+
+/*
+ * H(z) = (num[0] + num[1] z^-1 + ...) / (1 + den[1] z^-1 + ...), kept in
+ * direct form I: in[i] is the input and out[i] the output i steps ago,
+ * in[0] and out[0] the most recent ones. Outputs are clamped to
+ * [min, max] before they are fed back, so a saturated filter does not
+ * wind up.
+ */
+typedef struct discrete_filter_t {
+    int order;
+    double num[DFILTER_MAX_ORDER + 1];
+    double den[DFILTER_MAX_ORDER + 1];
+    double in[DFILTER_MAX_ORDER + 1];
+    double out[DFILTER_MAX_ORDER + 1];
+    double min;
+    double max;
+} discrete_filter_t;
+
+/*
+ * Set up filter from num_len numerator and den_len denominator
+ * coefficients, highest power of z first. The coefficients are
+ * normalized to den[0] = 1. Returns -1 if the filter is not proper or
+ * too long, or den[0] is 0.
+ */
+static inline int dfilter_init(discrete_filter_t *filter, const double *num, int num_len,
+                               const double *den, int den_len, double min, double max) {
+    int i;
+
+    if ((num_len < 1) || (den_len < num_len) || (den_len > DFILTER_MAX_ORDER + 1) || (den[0] == 0.0))
+        return -1;
+
+    memset(filter, 0, sizeof(*filter));
+    filter->order = den_len - 1;
+
+    // Align numerator and denominator on the highest power of z
+    for (i = 0; i < num_len; i++)
+        filter->num[den_len - num_len + i] = num[i] / den[0];
+    for (i = 0; i < den_len; i++)
+        filter->den[i] = den[i] / den[0];
+
+    filter->min = min;
+    filter->max = max;
+
+    return 0;
+}
+
+static inline void dfilter_reset(discrete_filter_t *filter) {
+    memset(filter->in, 0, sizeof(filter->in));
+    memset(filter->out, 0, sizeof(filter->out));
+}
+
+/*
+ * Fill the history as if input x had been applied forever, so the filter
+ * starts in steady state rather than ramping up from 0. Returns -1 if
+ * the filter has no finite DC gain.
+ */
+static inline int dfilter_prefill(discrete_filter_t *filter, double x) {
+    double num_sum = 0.0;
+    double den_sum = 0.0;
+    double y;
+    int i;
+
+    for (i = 0; i <= filter->order; i++) {
+        num_sum += filter->num[i];
+        den_sum += filter->den[i];
+    }
+
+    if (fabs(den_sum) < 1e-12)
+        return -1;
+
+    y = x * num_sum / den_sum;
+    if (y > filter->max)
+        y = filter->max;
+    else if (y < filter->min)
+        y = filter->min;
+
+    for (i = 0; i <= filter->order; i++) {
+        filter->in[i] = x;
+        filter->out[i] = y;
+    }
+
+    return 0;
+}
+
+/*
+ * Design a Butterworth low- or highpass of order for sample time dt (s)
+ * and cutoff frequency (Hz) by the bilinear transform, prewarped so the
+ * cutoff is exact. Gain is 1 at DC (lowpass) or Nyquist (highpass).
+ * Returns -1 unless 1 <= order <= DFILTER_MAX_ORDER and the cutoff is
+ * between 0 and the Nyquist frequency.
+ */
+static inline int dfilter_butterworth(discrete_filter_t *filter, int order, double dt,
+                                      double cutoff, int highpass) {
+    double complex den[DFILTER_MAX_ORDER + 1];
+    double complex pole;
+    double num[DFILTER_MAX_ORDER + 1];
+    double real_den[DFILTER_MAX_ORDER + 1];
+    double sign;
+    double wc;
+    double num_gain = 0.0;
+    double den_gain = 0.0;
+    int i;
+    int k;
+
+    if ((order < 1) || (order > DFILTER_MAX_ORDER) || !(dt > 0.0) ||
+        !((cutoff > 0.0) && (cutoff < 0.5 / dt)))
+        return -1;
+
+    wc = 2.0 / dt * tan(M_PI * cutoff * dt);
+
+    // Poles: the analog ones on the left half circle of radius wc,
+    // mapped by the bilinear transform and multiplied out in z^-1
+    den[0] = 1.0;
+    for (k = 0; k < order; k++) {
+        pole = wc * cexp(I * M_PI * (2 * k + order + 1) / (2.0 * order));
+        pole = (1.0 + pole * dt / 2.0) / (1.0 - pole * dt / 2.0);
+        den[k + 1] = 0.0;
+        for (i = k + 1; i > 0; i--)
+            den[i] -= pole * den[i - 1];
+    }
+
+    // Zeros: all at z = -1 (lowpass) or z = 1 (highpass)
+    sign = highpass ? -1.0 : 1.0;
+    num[0] = 1.0;
+    for (k = 0; k < order; k++) {
+        num[k + 1] = 0.0;
+        for (i = k + 1; i > 0; i--)
+            num[i] += sign * num[i - 1];
+    }
+
+    // Unity gain at z = 1 (lowpass) or z = -1 (highpass)
+    for (i = 0; i <= order; i++) {
+        real_den[i] = creal(den[i]);
+        num_gain += ((i & 1) ? sign : 1.0) * num[i];
+        den_gain += ((i & 1) ? sign : 1.0) * real_den[i];
+    }
+    for (i = 0; i <= order; i++)
+        num[i] *= den_gain / num_gain;
+
+    return dfilter_init(filter, num, order + 1, real_den, order + 1, -INFINITY, INFINITY);
+}
+
+/*
+ * Feed input x and return the new (saturated) output.
+ */
+static inline double dfilter_march(discrete_filter_t *filter, double x) {
+    double y;
+    int i;
+
+    for (i = filter->order; i > 0; i--) {
+        filter->in[i] = filter->in[i - 1];
+        filter->out[i] = filter->out[i - 1];
+    }
+    filter->in[0] = x;
+
+    y = 0.0;
+    for (i = 0; i <= filter->order; i++)
+        y += filter->num[i] * filter->in[i];
+    for (i = 1; i <= filter->order; i++)
+        y -= filter->den[i] * filter->out[i];
+
+    if (y > filter->max)
+        y = filter->max;
+    else if (y < filter->min)
+        y = filter->min;
+
+    filter->out[0] = y;
+
+    return y;
+}
+
+#endif /* _RCDISCRETEFILTER_H */
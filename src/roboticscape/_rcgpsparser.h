@@ -0,0 +1,318 @@
+/*
+ * _rcgpsparser.h - Incremental NMEA 0183 / u-blox UBX parser used by the
+ * native GPS service of the libroboticscape Python bindings
+ *
+ * Copyright (C) 2017 Torsten Kurbad <beaglebone@tk-webart.de>
+ *
+ */
+
+#ifndef _RCGPSPARSER_H
+#define _RCGPSPARSER_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GPS_NMEA_MAX_LEN	96	// NMEA allows 82 characters, some receivers exceed it
+#define GPS_NMEA_MAX_FIELDS	24
+#define GPS_UBX_MAX_PAYLOAD	100	// longest UBX message decoded (NAV-PVT: 92)
+#define GPS_KNOTS_TO_MS		0.514444
+
+// Fix qualities, as in the NMEA GGA sentence
+#define GPS_FIX_NONE		0
+#define GPS_FIX_GNSS		1
+#define GPS_FIX_DGNSS		2
+#define GPS_FIX_RTK		4
+#define GPS_FIX_RTK_FLOAT	5
+#define GPS_FIX_ESTIMATED	6	// dead reckoning
+
+typedef struct gps_fix_t {
+    uint64_t nanos;             // CLOCK_MONOTONIC time the last sentence completed, 0 = none yet
+    double latitude;            // °, north positive, NaN without fix
+    double longitude;           // °, east positive, NaN without fix
+    float altitude_m;           // above mean sea level, NaN without fix
+    float speed_ms;             // over ground, NaN if unknown
+    float heading;              // course over ground in ° from true north, NaN if unknown
+    int quality;                // GPS_FIX_*
+    int satellites;             // used in the solution
+} gps_fix_t;
+
+/*
+ * State of one byte stream. NMEA sentences are collected from '$' up to
+ * the line end, UBX messages from their 0xb5 0x62 sync; anything else in
+ * between is skipped. fix accumulates what the sentences report, since
+ * no single NMEA sentence carries all of it.
+ */
+typedef struct gps_parser_t {
+    enum {
+        GPS_IDLE,
+        GPS_NMEA,
+        GPS_UBX_SYNC,
+        GPS_UBX_HEADER,
+        GPS_UBX_PAYLOAD,
+        GPS_UBX_CHECKSUM
+    } state;
+    char nmea[GPS_NMEA_MAX_LEN + 1];
+    int length;
+    uint8_t ubx[4 + GPS_UBX_MAX_PAYLOAD + 2];   // class, id, length, payload, checksum
+    int ubx_length;
+    gps_fix_t fix;
+    uint64_t messages;          // sentences and messages with a valid checksum
+    uint64_t errors;            // checksum failures and overlong sentences
+} gps_parser_t;
+
+static inline void gps_parser_init(gps_parser_t *parser) {
+    memset(parser, 0, sizeof(*parser));
+    parser->state = GPS_IDLE;
+    parser->fix.latitude = NAN;
+    parser->fix.longitude = NAN;
+    parser->fix.altitude_m = NAN;
+    parser->fix.speed_ms = NAN;
+    parser->fix.heading = NAN;
+}
+
+static inline int gps_hex_digit(char c) {
+    if ((c >= '0') && (c <= '9'))
+        return c - '0';
+    if ((c >= 'A') && (c <= 'F'))
+        return c - 'A' + 10;
+    if ((c >= 'a') && (c <= 'f'))
+        return c - 'a' + 10;
+    return -1;
+}
+
+/*
+ * (d)ddmm.mmmm plus hemisphere to signed degrees, NaN if empty.
+ */
+static inline double gps_nmea_degrees(const char *value, const char *hemisphere) {
+    double raw;
+    double degrees;
+
+    if ((value[0] == '\0') || (hemisphere[0] == '\0'))
+        return NAN;
+
+    raw = strtod(value, NULL);
+    degrees = floor(raw / 100.0);
+    degrees += (raw - degrees * 100.0) / 60.0;
+
+    return ((hemisphere[0] == 'S') || (hemisphere[0] == 'W')) ? -degrees : degrees;
+}
+
+static inline double gps_nmea_number(const char *value) {
+    return (value[0] == '\0') ? NAN : strtod(value, NULL);
+}
+
+/*
+ * Decode a checksum verified sentence between '$' and '*'. Returns 1 if
+ * it updated fix, 0 if the sentence type is not used.
+ */
+static inline int gps_parse_nmea(gps_parser_t *parser, char *sentence) {
+    char *fields[GPS_NMEA_MAX_FIELDS];
+    int count = 0;
+    char *c;
+
+    fields[count++] = sentence;
+    for (c = sentence; *c != '\0'; c++) {
+        if (*c == ',') {
+            *c = '\0';
+            if (count == GPS_NMEA_MAX_FIELDS)
+                break;
+            fields[count++] = c + 1;
+        }
+    }
+
+    // Any talker (GP, GN, GL, ...) is accepted
+    if (strlen(fields[0]) != 5)
+        return 0;
+
+    if ((strcmp(fields[0] + 2, "GGA") == 0) && (count >= 10)) {
+        parser->fix.quality = atoi(fields[6]);
+        parser->fix.satellites = atoi(fields[7]);
+        if (parser->fix.quality == GPS_FIX_NONE) {
+            parser->fix.latitude = NAN;
+            parser->fix.longitude = NAN;
+            parser->fix.altitude_m = NAN;
+        } else {
+            parser->fix.latitude = gps_nmea_degrees(fields[2], fields[3]);
+            parser->fix.longitude = gps_nmea_degrees(fields[4], fields[5]);
+            parser->fix.altitude_m = (float)gps_nmea_number(fields[9]);
+        }
+        return 1;
+    }
+
+    if ((strcmp(fields[0] + 2, "RMC") == 0) && (count >= 9)) {
+        if (fields[2][0] == 'A') {
+            parser->fix.latitude = gps_nmea_degrees(fields[3], fields[4]);
+            parser->fix.longitude = gps_nmea_degrees(fields[5], fields[6]);
+            parser->fix.speed_ms = (float)(gps_nmea_number(fields[7]) * GPS_KNOTS_TO_MS);
+            parser->fix.heading = (float)gps_nmea_number(fields[8]);
+        } else {
+            parser->fix.speed_ms = NAN;
+            parser->fix.heading = NAN;
+        }
+        return 1;
+    }
+
+    return 0;
+}
+
+static inline int32_t gps_ubx_i4(const uint8_t *p) {
+    return (int32_t)((uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+}
+
+/*
+ * Decode a checksum verified UBX message. Returns 1 if it updated fix,
+ * 0 if the message is not used. Only NAV-PVT is decoded: it carries the
+ * whole fix at once.
+ */
+static inline int gps_parse_ubx(gps_parser_t *parser, uint8_t cls, uint8_t id,
+                                const uint8_t *payload, int length) {
+    uint8_t fix_type;
+    uint8_t flags;
+
+    if ((cls != 0x01) || (id != 0x07) || (length < 92))
+        return 0;
+
+    fix_type = payload[20];
+    flags = payload[21];
+
+    // Map onto the GGA fix qualities used for NMEA
+    if (flags & 0x01) {
+        if ((flags >> 6) == 2)
+            parser->fix.quality = GPS_FIX_RTK;
+        else if ((flags >> 6) == 1)
+            parser->fix.quality = GPS_FIX_RTK_FLOAT;
+        else if (flags & 0x02)
+            parser->fix.quality = GPS_FIX_DGNSS;
+        else
+            parser->fix.quality = GPS_FIX_GNSS;
+    } else {
+        parser->fix.quality = (fix_type == 1) ? GPS_FIX_ESTIMATED : GPS_FIX_NONE;
+    }
+    parser->fix.satellites = payload[23];
+
+    if (parser->fix.quality == GPS_FIX_NONE) {
+        parser->fix.latitude = NAN;
+        parser->fix.longitude = NAN;
+        parser->fix.altitude_m = NAN;
+        parser->fix.speed_ms = NAN;
+        parser->fix.heading = NAN;
+    } else {
+        parser->fix.longitude = gps_ubx_i4(payload + 24) * 1e-7;
+        parser->fix.latitude = gps_ubx_i4(payload + 28) * 1e-7;
+        parser->fix.altitude_m = (float)(gps_ubx_i4(payload + 36) * 1e-3);
+        parser->fix.speed_ms = (float)(gps_ubx_i4(payload + 60) * 1e-3);
+        parser->fix.heading = (float)(gps_ubx_i4(payload + 64) * 1e-5);
+    }
+
+    return 1;
+}
+
+/*
+ * Feed one byte of the stream. Returns 1 if it completed a sentence or
+ * message that updated fix, else 0.
+ */
+static inline int gps_parser_feed(gps_parser_t *parser, uint8_t byte) {
+    uint8_t ck_a = 0;
+    uint8_t ck_b = 0;
+    int checksum;
+    char *star;
+    int i;
+
+    switch (parser->state) {
+    case GPS_IDLE:
+        if (byte == '$') {
+            parser->length = 0;
+            parser->state = GPS_NMEA;
+        } else if (byte == 0xb5) {
+            parser->state = GPS_UBX_SYNC;
+        }
+        return 0;
+
+    case GPS_NMEA:
+        if (byte == '$') {
+            // Sentence cut off, resynchronize on the new one
+            parser->errors++;
+            parser->length = 0;
+            return 0;
+        }
+        if ((byte != '\r') && (byte != '\n')) {
+            if (parser->length == GPS_NMEA_MAX_LEN) {
+                parser->errors++;
+                parser->state = GPS_IDLE;
+            } else {
+                parser->nmea[parser->length++] = (char)byte;
+            }
+            return 0;
+        }
+
+        parser->state = GPS_IDLE;
+        parser->nmea[parser->length] = '\0';
+        star = memchr(parser->nmea, '*', parser->length);
+        if ((star == NULL) || (star + 3 != parser->nmea + parser->length) ||
+            (gps_hex_digit(star[1]) < 0) || (gps_hex_digit(star[2]) < 0)) {
+            parser->errors++;
+            return 0;
+        }
+
+        checksum = 0;
+        for (i = 0; parser->nmea + i < star; i++)
+            checksum ^= (uint8_t)parser->nmea[i];
+        if (checksum != ((gps_hex_digit(star[1]) << 4) | gps_hex_digit(star[2]))) {
+            parser->errors++;
+            return 0;
+        }
+
+        parser->messages++;
+        *star = '\0';
+        return gps_parse_nmea(parser, parser->nmea);
+
+    case GPS_UBX_SYNC:
+        parser->ubx_length = 0;
+        parser->state = (byte == 0x62) ? GPS_UBX_HEADER : GPS_IDLE;
+        return 0;
+
+    case GPS_UBX_HEADER:
+        parser->ubx[parser->ubx_length++] = byte;
+        if (parser->ubx_length < 4)
+            return 0;
+        if ((parser->ubx[2] | (parser->ubx[3] << 8)) > GPS_UBX_MAX_PAYLOAD) {
+            // Not decoded; skipping it byte by byte is safe since a
+            // sync found inside still has to pass the checksum
+            parser->state = GPS_IDLE;
+            return 0;
+        }
+        parser->state = (parser->ubx[2] | parser->ubx[3]) ? GPS_UBX_PAYLOAD : GPS_UBX_CHECKSUM;
+        return 0;
+
+    case GPS_UBX_PAYLOAD:
+        parser->ubx[parser->ubx_length++] = byte;
+        if (parser->ubx_length == 4 + (parser->ubx[2] | (parser->ubx[3] << 8)))
+            parser->state = GPS_UBX_CHECKSUM;
+        return 0;
+
+    case GPS_UBX_CHECKSUM:
+        parser->ubx[parser->ubx_length++] = byte;
+        if (parser->ubx_length < 4 + (parser->ubx[2] | (parser->ubx[3] << 8)) + 2)
+            return 0;
+
+        parser->state = GPS_IDLE;
+        for (i = 0; i < parser->ubx_length - 2; i++) {
+            ck_a += parser->ubx[i];
+            ck_b += ck_a;
+        }
+        if ((ck_a != parser->ubx[i]) || (ck_b != parser->ubx[i + 1])) {
+            parser->errors++;
+            return 0;
+        }
+
+        parser->messages++;
+        return gps_parse_ubx(parser, parser->ubx[0], parser->ubx[1], parser->ubx + 4,
+                             parser->ubx_length - 6);
+    }
+
+    return 0;
+}
+
+#endif /* _RCGPSPARSER_H */
@@ -0,0 +1,101 @@
+/*
+ * _rcringbuffer.h - Single-producer/single-consumer lock-free ring
+ * buffer used by the native sampling threads of the libroboticscape
+ * Python bindings
+ *
+ * Copyright (C) 2017 Torsten Kurbad <beaglebone@tk-webart.de>
+ *
+ */
+
+#ifndef _RCRINGBUFFER_H
+#define _RCRINGBUFFER_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Fixed size records are stored in a flat array. head and tail count
+ * records ever written/read; their difference is the fill level, so no
+ * slot has to be sacrificed to tell a full from an empty buffer. Only
+ * the producer writes head, only the consumer writes tail.
+ */
+typedef struct spsc_ring_t {
+    uint8_t *data;
+    size_t record_size;
+    size_t capacity;
+    _Atomic uint64_t head;
+    _Atomic uint64_t tail;
+    _Atomic uint64_t overruns;
+} spsc_ring_t;
+
+static inline int spsc_ring_alloc(spsc_ring_t *ring, size_t record_size, size_t capacity) {
+    ring->data = calloc(capacity, record_size);
+    if (ring->data == NULL)
+        return -1;
+
+    ring->record_size = record_size;
+    ring->capacity = capacity;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->overruns, 0);
+
+    return 0;
+}
+
+static inline void spsc_ring_free(spsc_ring_t *ring) {
+    free(ring->data);
+    ring->data = NULL;
+    ring->capacity = 0;
+}
+
+/*
+ * Producer side: append one record. If the consumer fell behind and the
+ * buffer is full, the record is dropped and counted as overrun.
+ */
+static inline int spsc_ring_push(spsc_ring_t *ring, const void *record) {
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    if (head - tail >= ring->capacity) {
+        atomic_fetch_add_explicit(&ring->overruns, 1, memory_order_relaxed);
+        return -1;
+    }
+
+    memcpy(ring->data + (head % ring->capacity) * ring->record_size, record, ring->record_size);
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+
+    return 0;
+}
+
+/*
+ * Consumer side: number of records ready to be popped.
+ */
+static inline size_t spsc_ring_available(spsc_ring_t *ring) {
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    return (size_t)(head - tail);
+}
+
+/*
+ * Consumer side: pointer to the i-th oldest unread record. Only valid
+ * for i < spsc_ring_available() and until spsc_ring_consume().
+ */
+static inline const void *spsc_ring_peek(spsc_ring_t *ring, size_t i) {
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    return ring->data + ((tail + i) % ring->capacity) * ring->record_size;
+}
+
+/*
+ * Consumer side: release count records back to the producer.
+ */
+static inline void spsc_ring_consume(spsc_ring_t *ring, size_t count) {
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    atomic_store_explicit(&ring->tail, tail + count, memory_order_release);
+}
+
+#endif /* _RCRINGBUFFER_H */
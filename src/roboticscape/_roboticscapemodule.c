@@ -9,20 +9,552 @@
 #include <Python.h>
 #include "_roboticscapemodule.h"
 
+/*
+ * One lock per I²C bus (index = bus number). Transactions run with the
+ * GIL released, so other Python threads keep running while a slow
+ * device is being talked to; the lock keeps concurrent threads from
+ * interleaving on the same bus.
+ */
+static pthread_mutex_t i2c_bus_lock[3] = {
+    PTHREAD_MUTEX_INITIALIZER,
+    PTHREAD_MUTEX_INITIALIZER,
+    PTHREAD_MUTEX_INITIALIZER
+};
+
+/*
+ * Both SPI slaves share one bus; same scheme as the I²C locks.
+ */
+static pthread_mutex_t spi_bus_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * UARTs are full duplex, so every bus has one lock per direction: a
+ * reader waiting for data never holds up a writer. Init, close and
+ * flush take both.
+ */
+static pthread_mutex_t uart_rx_lock[UART_BUSES] = {
+    PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER,
+    PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER
+};
+static pthread_mutex_t uart_tx_lock[UART_BUSES] = {
+    PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER,
+    PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER
+};
+
+/*
+ * Background ADC sampler. The sampling thread is the only producer and
+ * the Python thread calling rcReadADCSamples the only consumer of ring.
+ * stopping is set (with the GIL held) while rcStopADCSamplerThread joins
+ * the thread and frees ring with the GIL released; no new sampler may
+ * start meanwhile.
+ */
+static struct {
+    pthread_t thread;
+    _Atomic int running;
+    int stopping;
+    int num_channels;
+    int channels[ADC_CHANNELS];
+    uint64_t period_ns;
+    spsc_ring_t ring;
+} adc_sampler;
+
+/*
+ * Encoder velocity estimator. The sampling thread keeps the per-channel
+ * tracking state and is the only writer of estimate, which it publishes
+ * through the seqlock seq like gps_service.fix. rcSetEncoderPos bumps
+ * the channel's jumps counter before and after setting the position, so
+ * it is odd meanwhile; a sample taken while it is odd or has moved on
+ * restarts the track, so the jump is not taken for motion.
+ * stopping is set (with the GIL held) while rcStopEncoderEstimatorThread
+ * joins the thread; no new estimator may start meanwhile.
+ */
+static struct {
+    pthread_t thread;
+    _Atomic int running;
+    int stopping;
+    uint64_t period_ns;
+    double cutoff_hz;
+    int period_counts;
+    _Atomic uint64_t jumps[4];
+    _Atomic uint64_t seq;
+    encoder_estimate_t estimate;
+    _Atomic uint64_t samples;
+    _Atomic uint64_t overruns;
+} encoder_estimator;
+
+static PyTypeObject *EncoderEstimateType;
+
+/*
+ * Background barometer service, same scheme as the ADC sampler. Every
+ * reading (service thread or rcReadBarometer) also lands in latest
+ * (guarded by latest_lock) for callers that only want the current one.
+ * oversample is remembered by _rcInitializeBarometer, 0 = powered off.
+ * filter is only touched with i2c_bus_lock[BMP_I2C_BUS] held. stopping
+ * works as for the ADC sampler.
+ */
+static struct {
+    pthread_t thread;
+    _Atomic int running;
+    int stopping;
+    int oversample;
+    uint64_t period_ns;
+    spsc_ring_t ring;
+    altitude_filter_t filter;
+    pthread_mutex_t latest_lock;
+    bmp_sample_t latest;
+} bmp_service = {
+    .latest_lock = PTHREAD_MUTEX_INITIALIZER
+};
+
+/*
+ * Native GPS service. The service thread owns the UART bus while running
+ * (Python reads on it are refused) and is the only user of parser and
+ * the only writer of fix, which it publishes through the seqlock seq:
+ * seq is odd while fix is being written, readers copy fix and retry if
+ * seq was odd or has moved on meanwhile. stopping is set (with the GIL
+ * held) while rcStopGPSServiceThread joins the thread and closes bus,
+ * which stays owned by the service until then.
+ */
+static struct {
+    pthread_t thread;
+    _Atomic int running;
+    int stopping;
+    int bus;
+    gps_parser_t parser;
+    _Atomic uint64_t seq;
+    gps_fix_t fix;
+    _Atomic uint64_t messages;
+    _Atomic uint64_t errors;
+} gps_service;
+
+static PyTypeObject *GPSFixType;
+
+/*
+ * Controllers currently stepped by their own timer thread. Every running
+ * controller holds a reference to itself and sits in this list until it
+ * is stopped, so rcCleanup can stop them all. Only touched with the GIL
+ * held.
+ */
+static ControllerObject *running_controllers;
+
+static PyTypeObject *ControllerType;
+static PyTypeObject *DiscreteFilterType;
+
+/*
+ * Servo pulse service. Setpoints are double buffered: rcSetServoSetpoints
+ * fills setpoints[(front + 1) & 1] and publishes it by incrementing front,
+ * the pulse thread copies setpoints[front & 1] and retries should front
+ * have moved on while copying. NaN setpoints send no pulse. stopping
+ * works as for the ADC sampler.
+ */
+static struct {
+    pthread_t thread;
+    _Atomic int running;
+    int stopping;
+    int mode;
+    uint64_t period_ns;
+    float setpoints[2][SERVO_CHANNELS];
+    _Atomic uint64_t front;
+    _Atomic uint64_t frames;
+    _Atomic uint64_t overruns;
+} servo_service;
+
+/*
+ * DSM frame notification. rcDSMDataFunc is registered with the library
+ * by rcInitializeDSM and runs on its DSM thread: it snapshots the frame,
+ * counts it and wakes rcWaitDSMFrame callers and the callback thread, so
+ * the radio is never held up by the GIL. cond uses CLOCK_MONOTONIC
+ * (PyInit). The snapshot frame (nanos: CLOCK_MONOTONIC time it arrived)
+ * is published through the seqlock seq like gps_service.fix, since the
+ * library updates its channels one by one.
+ * While running, unread replaces the library's new data flag, since
+ * taking the snapshot reads (and so clears) every frame.
+ * stopping is set (with the GIL held) while rcStopDSMCallbackThread
+ * joins the callback thread; no new callback is accepted meanwhile.
+ */
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    _Atomic int running;
+    _Atomic int unread;
+    uint64_t frames;
+    _Atomic uint64_t seq;
+    dsm_record_t frame;
+    pthread_t thread;
+    _Atomic int dispatching;
+    int stopping;
+    PyObject *callback;
+} dsm_service = {
+    .lock = PTHREAD_MUTEX_INITIALIZER
+};
+
+/*
+ * DSM recorder. rcDSMDataFunc pushes one dsm_record_t per frame into
+ * ring (with dsm_service.lock held, so recording can be switched off
+ * safely), the recorder thread appends them to file. Records are stored
+ * in native byte order after the DSM_RECORD_MAGIC header. stopping is
+ * set (with the GIL held) while rcStopDSMRecorderThread joins the thread
+ * and closes file; no new recording may start meanwhile.
+ */
+static struct {
+    pthread_t thread;
+    _Atomic int recording;
+    int stopping;
+    FILE *file;
+    uint64_t start_ns;
+    uint64_t written;
+    int error;
+    spsc_ring_t ring;
+} dsm_recorder;
+
+/*
+ * DSM replay. While active, the rcGetDSM*, rcIsDSM* and rcNanosSince*
+ * functions serve current, which the replay thread advances through
+ * records; published records are never modified until replay stops.
+ * stopping is set (with the GIL held) for the whole of
+ * rcStopDSMReplayThread, which frees records; no callback thread may
+ * start meanwhile.
+ */
+static struct {
+    pthread_t thread;
+    _Atomic int active;
+    int stopping;
+    _Atomic int stop;
+    _Atomic int finished;
+    int realtime;
+    dsm_record_t *records;
+    size_t count;
+    _Atomic(const dsm_record_t *) current;
+    _Atomic uint64_t published_ns;
+    _Atomic size_t replayed;
+} dsm_replay;
+
+static PyTypeObject *DSMFrameType;
+
+/*
+ * IMU DMP sample delivery. rcIMUInterruptFunc runs on the library's
+ * interrupt thread after it has filled data: it converts data to one
+ * imu_sample_t, pushes it into ring (rcReadIMUSamples is the consumer)
+ * and publishes it as latest, waking the callback thread. Polled reads
+ * use data as well, with i2c_bus_lock[IMU_I2C_BUS] held, and are refused
+ * while running, like any other transfer on that bus (rcCheckI2COwner).
+ * config is the one the IMU was last initialized with.
+ * stopping is set (with the GIL held) while rcStopIMUCallbackThread
+ * joins the callback thread; no new callback is accepted meanwhile.
+ */
+static struct {
+    rc_imu_data_t data;
+    _Atomic int running;
+    rc_imu_config_t config;
+    spsc_ring_t ring;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint64_t samples;
+    imu_sample_t latest;
+    pthread_t thread;
+    _Atomic int dispatching;
+    int stopping;
+    PyObject *callback;
+} imu_service = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER
+};
+
+static PyTypeObject *IMUSampleType;
+
+/*
+ * Raw MPU-9250 FIFO streaming in polled mode. Only touched with
+ * i2c_bus_lock[IMU_I2C_BUS] held; initialized tells whether the IMU has
+ * been set up for polled reads.
+ */
+static struct {
+    int initialized;
+    int running;
+    int divider;
+    uint64_t overflows;
+} imu_fifo;
+
+/*
+ * Fixed rate control loop run by rcRunLoop. callback, array and the
+ * exception slots are only touched with the GIL held; stats is shared
+ * with rcGetLoopStats through stats_lock.
+ */
+static struct {
+    pthread_t thread;
+    _Atomic int stop;
+    uint64_t period_ns;
+    int num_adc_channels;
+    int adc_channels[ADC_CHANNELS];
+    double samples[5 + ADC_CHANNELS];
+    PyObject *callback;
+    PyObject *array;
+    Py_buffer inputs;
+    PyObject *exc_type;
+    PyObject *exc_value;
+    PyObject *exc_traceback;
+    pthread_mutex_t stats_lock;
+    loop_stats_t stats;
+} control_loop = {
+    .stats_lock = PTHREAD_MUTEX_INITIALIZER
+};
+
+/*
+ * Per-function call statistics. Every module function is registered
+ * through one of the rcTimed* trampolines, which only read the clock
+ * while stats_enabled is set. Counters are updated with relaxed atomics
+ * since calls releasing the GIL may run concurrently.
+ */
+static _Atomic int stats_enabled;
+static method_stats_t method_stats[NUM_METHODS];
+static PyMethodDef timed_methods[NUM_METHODS];
+
+/*
+ * Copy up to maxlen floats from a buffer (array('f'), array('d'),
+ * memoryview, raw native float bytes) or from any sequence of numbers
+ * into values. Sets a ValueError and returns -1 on failure.
+ */
+static int rcFloatsFromObject(PyObject *obj, float *values, Py_ssize_t maxlen, Py_ssize_t *length) {
+    Py_ssize_t i;
+    Py_ssize_t count;
+    Py_buffer view;
+    PyObject *seq;
+
+    if (PyObject_CheckBuffer(obj)) {
+        if (PyObject_GetBuffer(obj, &view, PyBUF_FORMAT | PyBUF_C_CONTIGUOUS) < 0)
+            return -1;
+
+        if ((view.format == NULL) || (strcmp(view.format, "B") == 0)) {
+            count = view.len / (Py_ssize_t)sizeof(float);
+            if (count * (Py_ssize_t)sizeof(float) != view.len) {
+                PyBuffer_Release(&view);
+                PyErr_SetString(PyExc_ValueError, "Byte buffer length has to be a multiple of 4 (native float32).");
+                return -1;
+            }
+        } else if ((strcmp(view.format, "f") == 0) || (strcmp(view.format, "d") == 0)) {
+            count = view.len / view.itemsize;
+        } else {
+            PyBuffer_Release(&view);
+            PyErr_SetString(PyExc_ValueError, "Buffer has to contain float ('f') or double ('d') values.");
+            return -1;
+        }
+
+        if ((count < 1) || (count > maxlen)) {
+            PyBuffer_Release(&view);
+            PyErr_Format(PyExc_ValueError, "Between 1 and %zd values required.", maxlen);
+            return -1;
+        }
+
+        if ((view.format != NULL) && (strcmp(view.format, "d") == 0)) {
+            for (i = 0; i < count; i++)
+                values[i] = (float)((double *)view.buf)[i];
+        } else {
+            memcpy(values, view.buf, count * sizeof(float));
+        }
+
+        PyBuffer_Release(&view);
+        *length = count;
+        return 0;
+    }
+
+    seq = PySequence_Fast(obj, "Sequence or buffer of float values required.");
+    if (seq == NULL) {
+        PyErr_SetString(PyExc_ValueError, "Sequence or buffer of float values required.");
+        return -1;
+    }
+
+    count = PySequence_Fast_GET_SIZE(seq);
+    if ((count < 1) || (count > maxlen)) {
+        Py_DECREF(seq);
+        PyErr_Format(PyExc_ValueError, "Between 1 and %zd values required.", maxlen);
+        return -1;
+    }
+
+    for (i = 0; i < count; i++) {
+        values[i] = (float)PyFloat_AsDouble(PySequence_Fast_GET_ITEM(seq, i));
+        if ((values[i] == -1.0f) && PyErr_Occurred()) {
+            Py_DECREF(seq);
+            PyErr_SetString(PyExc_ValueError, "Sequence has to contain float values only.");
+            return -1;
+        }
+    }
+
+    Py_DECREF(seq);
+    *length = count;
+    return 0;
+}
+
+/*
+ * Store count long values into a writable buffer of C int ('i'),
+ * long ('l') or long long ('q') items in native byte order. Items are
+ * written by their size rather than their letter, since standard size
+ * formats ('=l') differ from the native ones. Sets a ValueError and
+ * returns -1 on failure.
+ */
+static int rcLongsToBuffer(PyObject *out, const long *values, Py_ssize_t count) {
+    Py_ssize_t i;
+    Py_buffer view;
+    char format;
+
+    if (PyObject_GetBuffer(out, &view, PyBUF_FORMAT | PyBUF_C_CONTIGUOUS | PyBUF_WRITABLE) < 0) {
+        PyErr_SetString(PyExc_ValueError, "Writable buffer required.");
+        return -1;
+    }
+
+    format = (view.format == NULL) ? 'B' : view.format[0];
+    if ((format == '@') || (format == '='))
+        format = view.format[1];
+
+    if (((format != 'i') && (format != 'l') && (format != 'q')) ||
+        ((view.itemsize != 4) && (view.itemsize != 8)) ||
+        (view.len / view.itemsize < count)) {
+        PyBuffer_Release(&view);
+        PyErr_Format(PyExc_ValueError, "Buffer has to hold at least %zd integer ('i', 'l' or 'q') values.", count);
+        return -1;
+    }
+
+    for (i = 0; i < count; i++) {
+        if (view.itemsize == 4)
+            ((int32_t *)view.buf)[i] = (int32_t)values[i];
+        else
+            ((int64_t *)view.buf)[i] = (int64_t)values[i];
+    }
+
+    PyBuffer_Release(&view);
+    return 0;
+}
+
+/*
+ * Current CLOCK_MONOTONIC time in nanoseconds.
+ */
+static uint64_t rcNanosMonotonic(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/*
+ * Sleep until the given CLOCK_MONOTONIC time in nanoseconds.
+ */
+static void rcSleepUntil(uint64_t nanos) {
+    struct timespec ts;
+
+    ts.tv_sec = (time_t)(nanos / 1000000000ULL);
+    ts.tv_nsec = (long)(nanos % 1000000000ULL);
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+        ;
+}
+
+/*
+ * Convert a single METH_FASTCALL argument to a C int. Returns -1 with
+ * an exception set on failure.
+ */
+static int rcArgToInt(PyObject *arg, int *value) {
+    long result;
+
+    result = PyLong_AsLong(arg);
+    if ((result == -1) && PyErr_Occurred())
+        return -1;
+
+    if ((result < INT_MIN) || (result > INT_MAX)) {
+        PyErr_SetString(PyExc_OverflowError, "Integer argument out of range.");
+        return -1;
+    }
+
+    *value = (int)result;
+    return 0;
+}
+
+/*
+ * Convert a single METH_FASTCALL argument to a C float. Returns -1 with
+ * an exception set on failure.
+ */
+static int rcArgToFloat(PyObject *arg, float *value) {
+    double result;
+
+    result = PyFloat_AsDouble(arg);
+    if ((result == -1.0) && PyErr_Occurred())
+        return -1;
+
+    *value = (float)result;
+    return 0;
+}
+
+/*
+ * Map the positional and keyword arguments of a METH_FASTCALL |
+ * METH_KEYWORDS call onto the NULL terminated kwlist. Arguments not
+ * passed leave their slot in values untouched, so callers preset the
+ * defaults. Sets a ValueError and returns -1 on failure.
+ */
+static int rcUnpackArgs(PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames,
+                        const char *const *kwlist, PyObject **values) {
+    Py_ssize_t i;
+    Py_ssize_t k;
+    Py_ssize_t nkw;
+    Py_ssize_t nparams = 0;
+    PyObject *name;
+
+    while (kwlist[nparams] != NULL)
+        nparams++;
+
+    if (nargs > nparams) {
+        PyErr_Format(PyExc_ValueError, "At most %zd arguments expected.", nparams);
+        return -1;
+    }
+
+    for (i = 0; i < nargs; i++)
+        values[i] = args[i];
+
+    nkw = (kwnames == NULL) ? 0 : PyTuple_GET_SIZE(kwnames);
+    for (i = 0; i < nkw; i++) {
+        name = PyTuple_GET_ITEM(kwnames, i);
+        for (k = 0; k < nparams; k++) {
+            if (PyUnicode_CompareWithASCIIString(name, kwlist[k]) == 0)
+                break;
+        }
+
+        if (k == nparams) {
+            PyErr_Format(PyExc_ValueError, "Unexpected keyword argument '%U'.", name);
+            return -1;
+        }
+
+        if (k < nargs) {
+            PyErr_Format(PyExc_ValueError, "Argument '%s' given by name and position.", kwlist[k]);
+            return -1;
+        }
+
+        values[k] = args[nargs + i];
+    }
+
+    return 0;
+}
+
 static PyObject *rcInitialize(PyObject *self, PyObject *args) {
     int retval;
 
     retval = rc_initialize();
 
-    return Py_BuildValue("i", retval);
+    return PyLong_FromLong(retval);
 }
 
 static PyObject *rcCleanup(PyObject *self, PyObject *args) {
     int retval;
 
+    rcStopADCSamplerThread();
+    rcStopEncoderEstimatorThread();
+    rcStopServoServiceThread();
+    rcStopDSMCallbackThread();
+    rcStopDSMRecorderThread();
+    rcStopDSMReplayThread();
+    rcStopIMUService();
+    rcStopBarometerThread();
+    rcStopGPSServiceThread();
+    rcStopControllers();
+
     retval = rc_cleanup();
 
-    return Py_BuildValue("i", retval);
+    return PyLong_FromLong(retval);
 }
 
 static PyObject *rcGetState(PyObject *self, PyObject *args) {
@@ -30,14 +562,14 @@ static PyObject *rcGetState(PyObject *self, PyObject *args) {
 
     state = (int)rc_get_state();
 
-    return Py_BuildValue("i", state);
+    return PyLong_FromLong(state);
 }
 
-static PyObject *rcSetState(PyObject *self, PyObject *args) {
+static PyObject *rcSetState(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
     int state;
     int retval;
 
-    if (!PyArg_ParseTuple(args, "i", &state)) {
+    if ((nargs != 1) || (rcArgToInt(args[0], &state) < 0)) {
         PyErr_SetString(PyExc_ValueError, "Integer argument (state to set) required.");
         return NULL;
     }
@@ -49,14 +581,14 @@ static PyObject *rcSetState(PyObject *self, PyObject *args) {
 
     retval = rc_set_state(state);
 
-    return Py_BuildValue("i", retval);
+    return PyLong_FromLong(retval);
 }
 
-static PyObject *rcGetLED(PyObject *self, PyObject *args) {
+static PyObject *rcGetLED(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
     int state;
     int led;
 
-    if (!PyArg_ParseTuple(args, "i", &led)) {
+    if ((nargs != 1) || (rcArgToInt(args[0], &led) < 0)) {
         PyErr_SetString(PyExc_ValueError, "Integer argument (green or red LED) required.");
         return NULL;
     }
@@ -73,15 +605,16 @@ static PyObject *rcGetLED(PyObject *self, PyObject *args) {
 		state = rc_gpio_get_value_mmap(RED_LED);
     }
 
-    return Py_BuildValue("i", state);
+    return PyLong_FromLong(state);
 }
 
-static PyObject *rcSetLED(PyObject *self, PyObject *args) {
+static PyObject *rcSetLED(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
     int retval;
     int led;
     int state;
 
-    if (!PyArg_ParseTuple(args, "ii", &led, &state)) {
+    if ((nargs != 2) || (rcArgToInt(args[0], &led) < 0) ||
+        (rcArgToInt(args[1], &state) < 0)) {
         PyErr_SetString(PyExc_ValueError, "Two integer arguments (green or red LED, on or off) required.");
         return NULL;
     }
@@ -97,16 +630,17 @@ static PyObject *rcSetLED(PyObject *self, PyObject *args) {
     }
     retval = rc_set_led(led, state);
 
-    return Py_BuildValue("i", retval);
+    return PyLong_FromLong(retval);
 }
 
-static PyObject *rcBlinkLED(PyObject *self, PyObject *args) {
+static PyObject *rcBlinkLED(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
     int retval;
     int led;
     float hz;
     float period;
 
-    if (!PyArg_ParseTuple(args, "iff", &led, &hz, &period)) {
+    if ((nargs != 3) || (rcArgToInt(args[0], &led) < 0) ||
+        (rcArgToFloat(args[1], &hz) < 0) || (rcArgToFloat(args[2], &period) < 0)) {
         PyErr_SetString(PyExc_ValueError, "One integer and two float arguments (green or red LED, frequency, time period) required.");
         return NULL;
     }
@@ -128,14 +662,14 @@ static PyObject *rcBlinkLED(PyObject *self, PyObject *args) {
 
     retval = rc_blink_led(led, hz, period);
 
-    return Py_BuildValue("i", retval);
+    return PyLong_FromLong(retval);
 }
 
-static PyObject *rcGetButton(PyObject *self, PyObject *args) {
+static PyObject *rcGetButton(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
     int state;
     int button;
 
-    if (!PyArg_ParseTuple(args, "i", &button)) {
+    if ((nargs != 1) || (rcArgToInt(args[0], &button) < 0)) {
         PyErr_SetString(PyExc_ValueError, "Integer argument (pause or mode button) required.");
         return NULL;
     }
@@ -150,7 +684,7 @@ static PyObject *rcGetButton(PyObject *self, PyObject *args) {
     else
         state = rc_get_mode_button();
 
-    return Py_BuildValue("i", state);
+    return PyLong_FromLong(state);
 }
 
 static PyObject *rcEnableMotors(PyObject *self, PyObject *args) {
@@ -158,7 +692,7 @@ static PyObject *rcEnableMotors(PyObject *self, PyObject *args) {
 
     retval = rc_enable_motors();
 
-    return Py_BuildValue("i", retval);
+    return PyLong_FromLong(retval);
 }
 
 static PyObject *rcDisableMotors(PyObject *self, PyObject *args) {
@@ -166,15 +700,16 @@ static PyObject *rcDisableMotors(PyObject *self, PyObject *args) {
 
     retval = rc_disable_motors();
 
-    return Py_BuildValue("i", retval);
+    return PyLong_FromLong(retval);
 }
 
-static PyObject *rcSetMotor(PyObject *self, PyObject *args) {
+static PyObject *rcSetMotor(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
     int retval;
     int motor;
     float duty;
 
-    if (!PyArg_ParseTuple(args, "if", &motor, &duty)) {
+    if ((nargs != 2) || (rcArgToInt(args[0], &motor) < 0) ||
+        (rcArgToFloat(args[1], &duty) < 0)) {
         PyErr_SetString(PyExc_ValueError, "Integer and float argument (motor number, duty cycle) required.");
         return NULL;
     }
@@ -191,14 +726,14 @@ static PyObject *rcSetMotor(PyObject *self, PyObject *args) {
 
     retval = rc_set_motor(motor, duty);
 
-    return Py_BuildValue("i", retval);
+    return PyLong_FromLong(retval);
 }
 
-static PyObject *rcSetMotorAll(PyObject *self, PyObject *args) {
+static PyObject *rcSetMotorAll(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
     int retval;
     float duty;
 
-    if (!PyArg_ParseTuple(args, "f", &duty)) {
+    if ((nargs != 1) || (rcArgToFloat(args[0], &duty) < 0)) {
         PyErr_SetString(PyExc_ValueError, "Float argument (duty cycle) required.");
         return NULL;
     }
@@ -210,14 +745,47 @@ static PyObject *rcSetMotorAll(PyObject *self, PyObject *args) {
 
     retval = rc_set_motor_all(duty);
 
-    return Py_BuildValue("i", retval);
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcSetMotors(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int retval = 0;
+    int i;
+    Py_ssize_t count;
+    PyObject *duties;
+    float duty[4];
+
+    if (nargs != 1) {
+        PyErr_SetString(PyExc_ValueError, "Sequence or buffer argument (up to 4 duty cycles) required.");
+        return NULL;
+    }
+
+    duties = args[0];
+
+    if (rcFloatsFromObject(duties, duty, 4, &count) < 0)
+        return NULL;
+
+    // Validate all duty cycles before touching any motor
+    for (i = 0; i < count; i++) {
+        if (!((duty[i] >= -1.0) && (duty[i] <= 1.0))) {
+            PyErr_SetString(PyExc_ValueError, "Duty cycle has to be >= -1.0 and <= 1.0.");
+            return NULL;
+        }
+    }
+
+    for (i = 0; i < count; i++) {
+        if (rc_set_motor(i + 1, duty[i]) < 0)
+            retval = -1;
+    }
+
+    return PyLong_FromLong(retval);
 }
 
-static PyObject *rcSetMotorFreeSpin(PyObject *self, PyObject *args) {
+static PyObject *rcSetMotorFreeSpin(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
     int retval;
     int motor;
 
-    if (!PyArg_ParseTuple(args, "i", &motor)) {
+    if ((nargs != 1) || (rcArgToInt(args[0], &motor) < 0)) {
         PyErr_SetString(PyExc_ValueError, "Integer argument (motor number) required.");
         return NULL;
     }
@@ -229,7 +797,7 @@ static PyObject *rcSetMotorFreeSpin(PyObject *self, PyObject *args) {
 
     retval = rc_set_motor_free_spin(motor);
 
-    return Py_BuildValue("i", retval);
+    return PyLong_FromLong(retval);
 }
 
 static PyObject *rcSetMotorFreeSpinAll(PyObject *self, PyObject *args) {
@@ -237,14 +805,14 @@ static PyObject *rcSetMotorFreeSpinAll(PyObject *self, PyObject *args) {
 
     retval = rc_set_motor_free_spin_all();
 
-    return Py_BuildValue("i", retval);
+    return PyLong_FromLong(retval);
 }
 
-static PyObject *rcSetMotorBrake(PyObject *self, PyObject *args) {
+static PyObject *rcSetMotorBrake(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
     int retval;
     int motor;
 
-    if (!PyArg_ParseTuple(args, "i", &motor)) {
+    if ((nargs != 1) || (rcArgToInt(args[0], &motor) < 0)) {
         PyErr_SetString(PyExc_ValueError, "Integer argument (motor number) required.");
         return NULL;
     }
@@ -256,7 +824,7 @@ static PyObject *rcSetMotorBrake(PyObject *self, PyObject *args) {
 
     retval = rc_set_motor_brake(motor);
 
-    return Py_BuildValue("i", retval);
+    return PyLong_FromLong(retval);
 }
 
 static PyObject *rcSetMotorBrakeAll(PyObject *self, PyObject *args) {
@@ -264,14 +832,14 @@ static PyObject *rcSetMotorBrakeAll(PyObject *self, PyObject *args) {
 
     retval = rc_set_motor_brake_all();
 
-    return Py_BuildValue("i", retval);
+    return PyLong_FromLong(retval);
 }
 
-static PyObject *rcGetEncoderPos(PyObject *self, PyObject *args) {
+static PyObject *rcGetEncoderPos(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
     long position;
     int channel;
 
-    if (!PyArg_ParseTuple(args, "i", &channel)) {
+    if ((nargs != 1) || (rcArgToInt(args[0], &channel) < 0)) {
         PyErr_SetString(PyExc_ValueError, "Integer argument (encoder channel number) required.");
         return NULL;
     }
@@ -283,15 +851,43 @@ static PyObject *rcGetEncoderPos(PyObject *self, PyObject *args) {
 
     position = (long)rc_get_encoder_pos(channel);
 
-    return Py_BuildValue("l", position);
+    return PyLong_FromLong(position);
+}
+
+static PyObject *rcGetEncoderPosAll(PyObject *self, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames) {
+    static const char *const kwlist[] = {"out", NULL};
+    long position[4];
+    uint64_t nanos;
+    int channel;
+    PyObject *out = Py_None;
+
+    if (rcUnpackArgs(args, nargs, kwnames, kwlist, &out) < 0) {
+        PyErr_SetString(PyExc_ValueError, "Optional buffer argument (out) expected.");
+        return NULL;
+    }
+
+    // Sample all channels back-to-back so they refer to the same instant
+    nanos = rcNanosMonotonic();
+    for (channel = 1; channel <= 4; channel++)
+        position[channel - 1] = (long)rc_get_encoder_pos(channel);
+
+    if (out == Py_None)
+        return Py_BuildValue("(llll)K", position[0], position[1],
+                             position[2], position[3], (unsigned long long)nanos);
+
+    if (rcLongsToBuffer(out, position, 4) < 0)
+        return NULL;
+
+    return Py_BuildValue("OK", out, (unsigned long long)nanos);
 }
 
-static PyObject *rcSetEncoderPos(PyObject *self, PyObject *args) {
+static PyObject *rcSetEncoderPos(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
     int retval;
     int position;
     int channel;
 
-    if (!PyArg_ParseTuple(args, "ii", &channel, &position)) {
+    if ((nargs != 2) || (rcArgToInt(args[0], &channel) < 0) ||
+        (rcArgToInt(args[1], &position) < 0)) {
         PyErr_SetString(PyExc_ValueError, "Two integer arguments (encoder channel number, position) required.");
         return NULL;
     }
@@ -301,9 +897,298 @@ static PyObject *rcSetEncoderPos(PyObject *self, PyObject *args) {
         return NULL;
     }
 
+    atomic_fetch_add(&encoder_estimator.jumps[channel - 1], 1);
     retval = rc_set_encoder_pos(channel, position);
+    atomic_fetch_add(&encoder_estimator.jumps[channel - 1], 1);
+
+    return PyLong_FromLong(retval);
+}
+
+/*
+ * (Re)start tracking channel at position, keeping its velocity.
+ */
+static void rcEncoderTrackReset(encoder_track_t *track, long position, uint64_t nanos) {
+    track->position = position;
+    track->edge_position = position;
+    track->edge_nanos = nanos;
+}
+
+/*
+ * Raw velocity of track for a new sample (counts/s). Moving at least
+ * period_counts counts per sample, the finite difference over the sample
+ * interval dt is used. Slower, it is counts over the time between the
+ * last two count changes; without a change the estimate may not exceed
+ * one count over the time since the last change, so it decays towards 0
+ * at standstill instead of holding its last value.
+ */
+static double rcEncoderTrackVelocity(encoder_track_t *track, long position, uint64_t nanos,
+                                     double dt, int period_counts) {
+    long delta = position - track->position;
+    double bound;
+
+    if (delta != 0) {
+        track->period_velocity = (double)(position - track->edge_position) /
+                                 ((double)(nanos - track->edge_nanos) * 1e-9);
+        track->edge_position = position;
+        track->edge_nanos = nanos;
+    } else {
+        bound = 1.0 / ((double)(nanos - track->edge_nanos) * 1e-9);
+        if (track->period_velocity > bound)
+            track->period_velocity = bound;
+        else if (track->period_velocity < -bound)
+            track->period_velocity = -bound;
+    }
+    track->position = position;
+
+    if (labs(delta) >= period_counts)
+        return (double)delta / dt;
+
+    return track->period_velocity;
+}
+
+static void *rcEncoderEstimatorThread(void *arg) {
+    encoder_track_t tracks[4];
+    encoder_estimate_t estimate;
+    uint64_t jumps[4];
+    int jumped[4];
+    long position[4];
+    const double one = 1.0;
+    double dt;
+    double velocity;
+    uint64_t seq;
+    uint64_t last = 0;
+    uint64_t next;
+    uint64_t now;
+    int i;
+
+    dt = (double)encoder_estimator.period_ns * 1e-9;
+    memset(tracks, 0, sizeof(tracks));
+    for (i = 0; i < 4; i++) {
+        // Unfiltered estimates pass through an identity filter
+        if ((encoder_estimator.cutoff_hz == 0.0) ||
+            (dfilter_butterworth(&tracks[i].velocity_filter, 2, dt, encoder_estimator.cutoff_hz, 0) < 0)) {
+            dfilter_init(&tracks[i].velocity_filter, &one, 1, &one, 1, -INFINITY, INFINITY);
+        }
+        tracks[i].acceleration_filter = tracks[i].velocity_filter;
+    }
+
+    next = rcNanosMonotonic();
+
+    while (atomic_load_explicit(&encoder_estimator.running, memory_order_acquire)) {
+        // Sample all channels back-to-back so they refer to the same
+        // instant, checking jumps before and after like a seqlock reader
+        now = rcNanosMonotonic();
+        for (i = 0; i < 4; i++)
+            jumps[i] = atomic_load_explicit(&encoder_estimator.jumps[i], memory_order_acquire);
+        for (i = 0; i < 4; i++)
+            position[i] = (long)rc_get_encoder_pos(i + 1);
+        atomic_thread_fence(memory_order_acquire);
+        for (i = 0; i < 4; i++)
+            jumped[i] = (jumps[i] & 1) ||
+                        (atomic_load_explicit(&encoder_estimator.jumps[i], memory_order_relaxed) != jumps[i]);
+
+        estimate.nanos = now;
+        for (i = 0; i < 4; i++) {
+            if ((last == 0) || jumped[i] || (jumps[i] != tracks[i].jumps)) {
+                rcEncoderTrackReset(&tracks[i], position[i], now);
+                tracks[i].jumps = jumps[i];
+                velocity = tracks[i].velocity;
+            } else {
+                velocity = rcEncoderTrackVelocity(&tracks[i], position[i], now,
+                                                  (double)(now - last) * 1e-9,
+                                                  encoder_estimator.period_counts);
+                velocity = dfilter_march(&tracks[i].velocity_filter, velocity);
+            }
+
+            estimate.position[i] = position[i];
+            estimate.velocity[i] = velocity;
+            if (last == 0)
+                estimate.acceleration[i] = 0.0;
+            else
+                estimate.acceleration[i] = dfilter_march(&tracks[i].acceleration_filter,
+                                                         (velocity - tracks[i].velocity) /
+                                                         ((double)(now - last) * 1e-9));
+            tracks[i].velocity = velocity;
+        }
+        last = now;
+
+        seq = atomic_load_explicit(&encoder_estimator.seq, memory_order_relaxed);
+        atomic_store_explicit(&encoder_estimator.seq, seq + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        encoder_estimator.estimate = estimate;
+        atomic_store_explicit(&encoder_estimator.seq, seq + 2, memory_order_release);
+        atomic_fetch_add_explicit(&encoder_estimator.samples, 1, memory_order_relaxed);
+
+        next += encoder_estimator.period_ns;
+        now = rcNanosMonotonic();
+        while (next <= now) {
+            atomic_fetch_add_explicit(&encoder_estimator.overruns, 1, memory_order_relaxed);
+            next += encoder_estimator.period_ns;
+        }
+
+        rcSleepUntil(next);
+    }
+
+    return NULL;
+}
+
+static void rcStopEncoderEstimatorThread(void) {
+    if (!atomic_load(&encoder_estimator.running))
+        return;
+
+    atomic_store_explicit(&encoder_estimator.running, 0, memory_order_release);
+    encoder_estimator.stopping = 1;
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_join(encoder_estimator.thread, NULL);
+    Py_END_ALLOW_THREADS
+
+    encoder_estimator.stopping = 0;
+}
+
+static PyObject *rcStartEncoderEstimator(PyObject *self, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames) {
+    static const char *const kwlist[] = {"rate_hz", "cutoff_hz", "period_counts", NULL};
+    PyObject *values[3] = {NULL, NULL, NULL};
+    float rate_hz;
+    float cutoff_hz = 25.0;
+    int period_counts = 2;
+
+    if ((rcUnpackArgs(args, nargs, kwnames, kwlist, values) < 0) ||
+        (values[0] == NULL) || (rcArgToFloat(values[0], &rate_hz) < 0) ||
+        ((values[1] != NULL) && (rcArgToFloat(values[1], &cutoff_hz) < 0)) ||
+        ((values[2] != NULL) && (rcArgToInt(values[2], &period_counts) < 0))) {
+        PyErr_SetString(PyExc_ValueError, "Float argument (rate in Hz) and optional float (filter cutoff in Hz) and integer (period counts) arguments required.");
+        return NULL;
+    }
+
+    if (!((rate_hz > 0.0) && (rate_hz <= 10000.0))) {
+        PyErr_SetString(PyExc_ValueError, "Sample rate must be > 0 and <= 10,000 Hz.");
+        return NULL;
+    }
+
+    if (!((cutoff_hz == 0.0) || ((cutoff_hz > 0.0) && (cutoff_hz < rate_hz / 2.0)))) {
+        PyErr_SetString(PyExc_ValueError, "Filter cutoff must be 0 (no filter) or > 0 and below half the sample rate.");
+        return NULL;
+    }
+
+    if (period_counts < 0) {
+        PyErr_SetString(PyExc_ValueError, "Period counts must be >= 0.");
+        return NULL;
+    }
+
+    if (atomic_load(&encoder_estimator.running)) {
+        PyErr_SetString(PyExc_RuntimeError, "Encoder estimator is already running.");
+        return NULL;
+    }
+
+    if (encoder_estimator.stopping) {
+        PyErr_SetString(PyExc_RuntimeError, "Encoder estimator is still stopping.");
+        return NULL;
+    }
+
+    // The previous thread has been joined and readers hold the GIL, as
+    // we do: the previous estimate may be cleared directly
+    memset(&encoder_estimator.estimate, 0, sizeof(encoder_estimator.estimate));
+    encoder_estimator.period_ns = (uint64_t)(1e9 / rate_hz);
+    encoder_estimator.cutoff_hz = cutoff_hz;
+    encoder_estimator.period_counts = period_counts;
+    atomic_store(&encoder_estimator.seq, 0);
+    atomic_store(&encoder_estimator.samples, 0);
+    atomic_store(&encoder_estimator.overruns, 0);
+    atomic_store(&encoder_estimator.running, 1);
+
+    if (pthread_create(&encoder_estimator.thread, NULL, rcEncoderEstimatorThread, NULL) != 0) {
+        atomic_store(&encoder_estimator.running, 0);
+        PyErr_SetString(PyExc_RuntimeError, "Starting encoder estimator thread failed.");
+        return NULL;
+    }
+
+    return PyLong_FromLong(0);
+}
 
-    return Py_BuildValue("l", retval);
+static PyObject *rcStopEncoderEstimator(PyObject *self, PyObject *args) {
+    rcStopEncoderEstimatorThread();
+
+    return PyLong_FromLong(0);
+}
+
+static PyObject *rcGetEncoderEstimates(PyObject *self, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames) {
+    static const char *const kwlist[] = {"out", NULL};
+    PyObject *out = Py_None;
+    PyObject *result;
+    Py_buffer buffer;
+    encoder_estimate_t estimate;
+    double *row;
+    uint64_t seq;
+    int i;
+
+    if (rcUnpackArgs(args, nargs, kwnames, kwlist, &out) < 0) {
+        PyErr_SetString(PyExc_ValueError, "Optional writable 'd' buffer (out) expected.");
+        return NULL;
+    }
+
+    do {
+        seq = atomic_load_explicit(&encoder_estimator.seq, memory_order_acquire);
+        memcpy(&estimate, &encoder_estimator.estimate, sizeof(estimate));
+        atomic_thread_fence(memory_order_acquire);
+    } while ((seq & 1) || (atomic_load_explicit(&encoder_estimator.seq, memory_order_relaxed) != seq));
+
+    if (out == Py_None) {
+        if (estimate.nanos == 0)
+            Py_RETURN_NONE;
+
+        result = PyStructSequence_New(EncoderEstimateType);
+        if (result == NULL)
+            return NULL;
+
+        PyStructSequence_SET_ITEM(result, 0, PyLong_FromUnsignedLongLong((unsigned long long)estimate.nanos));
+        PyStructSequence_SET_ITEM(result, 1, Py_BuildValue("(llll)", estimate.position[0], estimate.position[1],
+                                                           estimate.position[2], estimate.position[3]));
+        PyStructSequence_SET_ITEM(result, 2, Py_BuildValue("(dddd)", estimate.velocity[0], estimate.velocity[1],
+                                                           estimate.velocity[2], estimate.velocity[3]));
+        PyStructSequence_SET_ITEM(result, 3, Py_BuildValue("(dddd)", estimate.acceleration[0], estimate.acceleration[1],
+                                                           estimate.acceleration[2], estimate.acceleration[3]));
+
+        if (PyErr_Occurred()) {
+            Py_DECREF(result);
+            return NULL;
+        }
+
+        return result;
+    }
+
+    if (PyObject_GetBuffer(out, &buffer, PyBUF_WRITABLE | PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) < 0) {
+        PyErr_SetString(PyExc_ValueError, "Writable contiguous buffer (out) required.");
+        return NULL;
+    }
+
+    if ((buffer.format == NULL) || (strcmp(buffer.format, "d") != 0) ||
+        (buffer.len < (Py_ssize_t)(ENCODER_ESTIMATE_LEN * sizeof(double)))) {
+        PyBuffer_Release(&buffer);
+        PyErr_SetString(PyExc_ValueError, "Buffer (out) has to hold at least 12 double ('d') values.");
+        return NULL;
+    }
+
+    if (estimate.nanos != 0) {
+        row = (double *)buffer.buf;
+        for (i = 0; i < 4; i++) {
+            row[i] = (double)estimate.position[i];
+            row[4 + i] = estimate.velocity[i];
+            row[8 + i] = estimate.acceleration[i];
+        }
+    }
+    PyBuffer_Release(&buffer);
+
+    if (estimate.nanos == 0)
+        Py_RETURN_NONE;
+
+    return PyLong_FromUnsignedLongLong((unsigned long long)estimate.nanos);
+}
+
+static PyObject *rcGetEncoderEstimatorStatus(PyObject *self, PyObject *args) {
+    return Py_BuildValue("(iKK)", atomic_load(&encoder_estimator.running),
+                         (unsigned long long)atomic_load(&encoder_estimator.samples),
+                         (unsigned long long)atomic_load(&encoder_estimator.overruns));
 }
 
 static PyObject *rcBatteryVoltage(PyObject *self, PyObject *args) {
@@ -311,7 +1196,7 @@ static PyObject *rcBatteryVoltage(PyObject *self, PyObject *args) {
 
     voltage = rc_battery_voltage();
 
-    return Py_BuildValue("f", voltage);
+    return PyFloat_FromDouble(voltage);
 }
 
 static PyObject *rcDCJackVoltage(PyObject *self, PyObject *args) {
@@ -319,14 +1204,14 @@ static PyObject *rcDCJackVoltage(PyObject *self, PyObject *args) {
 
     voltage = rc_dc_jack_voltage();
 
-    return Py_BuildValue("f", voltage);
+    return PyFloat_FromDouble(voltage);
 }
 
-static PyObject *rcADCRaw(PyObject *self, PyObject *args) {
+static PyObject *rcADCRaw(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
     int rawvalue;
     int channel;
 
-    if (!PyArg_ParseTuple(args, "i", &channel)) {
+    if ((nargs != 1) || (rcArgToInt(args[0], &channel) < 0)) {
         PyErr_SetString(PyExc_ValueError, "Integer argument (ADC channel number) required.");
         return NULL;
     }
@@ -338,14 +1223,14 @@ static PyObject *rcADCRaw(PyObject *self, PyObject *args) {
 
     rawvalue = rc_adc_raw(channel);
 
-    return Py_BuildValue("i", rawvalue);
+    return PyLong_FromLong(rawvalue);
 }
 
-static PyObject *rcADCVolt(PyObject *self, PyObject *args) {
+static PyObject *rcADCVolt(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
     float voltage;
     int channel;
 
-    if (!PyArg_ParseTuple(args, "i", &channel)) {
+    if ((nargs != 1) || (rcArgToInt(args[0], &channel) < 0)) {
         PyErr_SetString(PyExc_ValueError, "Integer argument (ADC channel number) required.");
         return NULL;
     }
@@ -357,89 +1242,303 @@ static PyObject *rcADCVolt(PyObject *self, PyObject *args) {
 
     voltage = rc_adc_volt(channel);
 
-    return Py_BuildValue("f", voltage);
+    return PyFloat_FromDouble(voltage);
 }
 
-static PyObject *rcEnableServoPowerRail(PyObject *self, PyObject *args) {
-    int retval;
+static void *rcADCSamplerThread(void *arg) {
+    adc_sample_t sample;
+    uint64_t next;
+    uint64_t now;
+    int i;
 
-    retval = rc_enable_servo_power_rail();
+    memset(&sample, 0, sizeof(sample));
+    next = rcNanosMonotonic();
 
-    return Py_BuildValue("i", retval);
-}
+    while (atomic_load_explicit(&adc_sampler.running, memory_order_acquire)) {
+        sample.nanos = rcNanosMonotonic();
+        for (i = 0; i < adc_sampler.num_channels; i++)
+            sample.volts[i] = rc_adc_volt(adc_sampler.channels[i]);
 
-static PyObject *rcDisableServoPowerRail(PyObject *self, PyObject *args) {
-    int retval;
+        spsc_ring_push(&adc_sampler.ring, &sample);
 
-    retval = rc_disable_servo_power_rail();
+        // Stay on the fixed sampling grid; if a period was missed
+        // entirely, skip it instead of sampling in a burst
+        next += adc_sampler.period_ns;
+        now = rcNanosMonotonic();
+        while (next <= now)
+            next += adc_sampler.period_ns;
 
-    return Py_BuildValue("i", retval);
-}
+        rcSleepUntil(next);
+    }
 
-static PyObject *rcSendServoPulseUs(PyObject *self, PyObject *args) {
-    int retval;
-    int channel;
-    int us;
+    return NULL;
+}
 
-    if (!PyArg_ParseTuple(args, "ii", &channel, &us)) {
-        PyErr_SetString(PyExc_ValueError, "Two integer arguments (servo channel, microseconds) required.");
-        return NULL;
-    }
+static void rcStopADCSamplerThread(void) {
+    if (!atomic_load(&adc_sampler.running))
+        return;
 
-    if ((channel < 1) || (channel > 8)) {
-        PyErr_SetString(PyExc_ValueError, "Channel number has to be >= 1 and <= 8.");
-        return NULL;
-    }
+    atomic_store_explicit(&adc_sampler.running, 0, memory_order_release);
+    adc_sampler.stopping = 1;
 
-    retval = rc_send_servo_pulse_us(channel, us);
+    Py_BEGIN_ALLOW_THREADS
+    pthread_join(adc_sampler.thread, NULL);
+    Py_END_ALLOW_THREADS
 
-    return Py_BuildValue("i", retval);
+    spsc_ring_free(&adc_sampler.ring);
+    adc_sampler.stopping = 0;
 }
 
-static PyObject *rcSendServoPulseUsAll(PyObject *self, PyObject *args) {
-    int retval;
-    int us;
+static PyObject *rcStartADCSampler(PyObject *self, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames) {
+    static const char *const kwlist[] = {"channels", "rate_hz", "capacity", NULL};
+    PyObject *values[3] = {NULL, NULL, NULL};
+    PyObject *seq;
+    Py_ssize_t i;
+    int num_channels;
+    int channels[ADC_CHANNELS];
+    float rate_hz;
+    int capacity = 1024;
+
+    if ((rcUnpackArgs(args, nargs, kwnames, kwlist, values) < 0) ||
+        (values[0] == NULL) || (values[1] == NULL) ||
+        (rcArgToFloat(values[1], &rate_hz) < 0) ||
+        ((values[2] != NULL) && (rcArgToInt(values[2], &capacity) < 0))) {
+        PyErr_SetString(PyExc_ValueError, "Sequence of ADC channels, float (rate in Hz) and optional integer (capacity in samples) arguments required.");
+        return NULL;
+    }
 
-    if (!PyArg_ParseTuple(args, "i", &us)) {
-        PyErr_SetString(PyExc_ValueError, "Integer argument (microseconds) required.");
+    seq = PySequence_Fast(values[0], "");
+    if (seq == NULL) {
+        PyErr_SetString(PyExc_ValueError, "Channels have to be given as a sequence of integers.");
         return NULL;
     }
 
-    retval = rc_send_servo_pulse_us_all(us);
+    if ((PySequence_Fast_GET_SIZE(seq) < 1) || (PySequence_Fast_GET_SIZE(seq) > ADC_CHANNELS)) {
+        Py_DECREF(seq);
+        PyErr_SetString(PyExc_ValueError, "Between 1 and 7 ADC channels required.");
+        return NULL;
+    }
 
-    return Py_BuildValue("i", retval);
-}
+    num_channels = (int)PySequence_Fast_GET_SIZE(seq);
+    for (i = 0; i < num_channels; i++) {
+        if ((rcArgToInt(PySequence_Fast_GET_ITEM(seq, i), &channels[i]) < 0) ||
+            (channels[i] < 0) || (channels[i] > 6)) {
+            Py_DECREF(seq);
+            PyErr_SetString(PyExc_ValueError, "Channel number has to be >= 0 and <= 6.");
+            return NULL;
+        }
+    }
+    Py_DECREF(seq);
 
-static PyObject *rcSendServoPulseNormalized(PyObject *self, PyObject *args) {
-    int retval;
-    int channel;
-    float input;
+    if (!((rate_hz > 0.0) && (rate_hz <= 100000.0))) {
+        PyErr_SetString(PyExc_ValueError, "Sample rate must be > 0 and <= 100,000 Hz.");
+        return NULL;
+    }
 
-    if (!PyArg_ParseTuple(args, "if", &channel, &input)) {
-        PyErr_SetString(PyExc_ValueError, "Integer and float arguments (servo channel, normalized input) required.");
+    if (capacity < 1) {
+        PyErr_SetString(PyExc_ValueError, "Capacity must be > 0.");
         return NULL;
     }
 
-    if ((channel < 1) || (channel > 8)) {
-        PyErr_SetString(PyExc_ValueError, "Channel number has to be >= 1 and <= 8.");
+    if (atomic_load(&adc_sampler.running)) {
+        PyErr_SetString(PyExc_RuntimeError, "ADC sampler is already running.");
         return NULL;
     }
 
-    if ((input < -1.5) || (input > 1.5)) {
-        PyErr_SetString(PyExc_ValueError, "Normalized input has to be >= -1.5 and <= 1.5.");
+    if (adc_sampler.stopping) {
+        PyErr_SetString(PyExc_RuntimeError, "ADC sampler is still stopping.");
         return NULL;
     }
 
-    retval = rc_send_servo_pulse_normalized(channel, input);
+    if (spsc_ring_alloc(&adc_sampler.ring, sizeof(adc_sample_t), (size_t)capacity) < 0)
+        return PyErr_NoMemory();
 
-    return Py_BuildValue("i", retval);
-}
+    adc_sampler.num_channels = num_channels;
+    memcpy(adc_sampler.channels, channels, sizeof(channels));
+    adc_sampler.period_ns = (uint64_t)(1e9 / rate_hz);
+    atomic_store(&adc_sampler.running, 1);
 
-static PyObject *rcSendServoPulseNormalizedAll(PyObject *self, PyObject *args) {
-    int retval;
+    if (pthread_create(&adc_sampler.thread, NULL, rcADCSamplerThread, NULL) != 0) {
+        atomic_store(&adc_sampler.running, 0);
+        spsc_ring_free(&adc_sampler.ring);
+        PyErr_SetString(PyExc_RuntimeError, "Starting ADC sampler thread failed.");
+        return NULL;
+    }
+
+    return PyLong_FromLong(0);
+}
+
+static PyObject *rcStopADCSampler(PyObject *self, PyObject *args) {
+    rcStopADCSamplerThread();
+
+    return PyLong_FromLong(0);
+}
+
+static PyObject *rcReadADCSamples(PyObject *self, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames) {
+    static const char *const kwlist[] = {"out", "timestamps", NULL};
+    PyObject *values[2] = {NULL, Py_None};
+    Py_buffer out;
+    Py_buffer stamps;
+    const adc_sample_t *sample;
+    size_t count;
+    size_t i;
+    int num_channels;
+
+    if ((rcUnpackArgs(args, nargs, kwnames, kwlist, values) < 0) || (values[0] == NULL)) {
+        PyErr_SetString(PyExc_ValueError, "Writable float buffer (out) and optional timestamp buffer required.");
+        return NULL;
+    }
+
+    if (!atomic_load(&adc_sampler.running)) {
+        PyErr_SetString(PyExc_RuntimeError, "ADC sampler is not running.");
+        return NULL;
+    }
+
+    if (PyObject_GetBuffer(values[0], &out, PyBUF_WRITABLE | PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) < 0) {
+        PyErr_SetString(PyExc_ValueError, "Writable contiguous buffer (out) required.");
+        return NULL;
+    }
+
+    if ((out.format == NULL) || (strcmp(out.format, "f") != 0)) {
+        PyBuffer_Release(&out);
+        PyErr_SetString(PyExc_ValueError, "Buffer (out) has to hold float ('f') values.");
+        return NULL;
+    }
+
+    num_channels = adc_sampler.num_channels;
+    count = spsc_ring_available(&adc_sampler.ring);
+    if (count > (size_t)(out.len / (Py_ssize_t)sizeof(float) / num_channels))
+        count = (size_t)(out.len / (Py_ssize_t)sizeof(float) / num_channels);
+
+    stamps.obj = NULL;
+    if (values[1] != Py_None) {
+        if (PyObject_GetBuffer(values[1], &stamps, PyBUF_WRITABLE | PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) < 0) {
+            PyBuffer_Release(&out);
+            PyErr_SetString(PyExc_ValueError, "Writable contiguous buffer (timestamps) required.");
+            return NULL;
+        }
+        if ((stamps.itemsize != 8) || (stamps.format == NULL) ||
+            (strchr("qQ", stamps.format[strlen(stamps.format) - 1]) == NULL)) {
+            PyBuffer_Release(&stamps);
+            PyBuffer_Release(&out);
+            PyErr_SetString(PyExc_ValueError, "Buffer (timestamps) has to hold 64 bit integer ('q' or 'Q') values.");
+            return NULL;
+        }
+        if (count > (size_t)(stamps.len / 8))
+            count = (size_t)(stamps.len / 8);
+    }
+
+    for (i = 0; i < count; i++) {
+        sample = spsc_ring_peek(&adc_sampler.ring, i);
+        memcpy((float *)out.buf + i * num_channels, sample->volts, num_channels * sizeof(float));
+        if (stamps.obj != NULL)
+            ((uint64_t *)stamps.buf)[i] = sample->nanos;
+    }
+    spsc_ring_consume(&adc_sampler.ring, count);
+
+    if (stamps.obj != NULL)
+        PyBuffer_Release(&stamps);
+    PyBuffer_Release(&out);
+
+    return PyLong_FromSize_t(count);
+}
+
+static PyObject *rcGetADCSamplerStatus(PyObject *self, PyObject *args) {
+    int running;
+    size_t available = 0;
+    unsigned long long overruns = 0;
+
+    running = atomic_load(&adc_sampler.running);
+    if (running) {
+        available = spsc_ring_available(&adc_sampler.ring);
+        overruns = atomic_load(&adc_sampler.ring.overruns);
+    }
+
+    return Py_BuildValue("(inK)", running, (Py_ssize_t)available, overruns);
+}
+
+static PyObject *rcEnableServoPowerRail(PyObject *self, PyObject *args) {
+    int retval;
+
+    retval = rc_enable_servo_power_rail();
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcDisableServoPowerRail(PyObject *self, PyObject *args) {
+    int retval;
+
+    retval = rc_disable_servo_power_rail();
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcSendServoPulseUs(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int retval;
+    int channel;
+    int us;
+
+    if ((nargs != 2) || (rcArgToInt(args[0], &channel) < 0) ||
+        (rcArgToInt(args[1], &us) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Two integer arguments (servo channel, microseconds) required.");
+        return NULL;
+    }
+
+    if ((channel < 1) || (channel > 8)) {
+        PyErr_SetString(PyExc_ValueError, "Channel number has to be >= 1 and <= 8.");
+        return NULL;
+    }
+
+    retval = rc_send_servo_pulse_us(channel, us);
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcSendServoPulseUsAll(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int retval;
+    int us;
+
+    if ((nargs != 1) || (rcArgToInt(args[0], &us) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Integer argument (microseconds) required.");
+        return NULL;
+    }
+
+    retval = rc_send_servo_pulse_us_all(us);
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcSendServoPulseNormalized(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int retval;
+    int channel;
+    float input;
+
+    if ((nargs != 2) || (rcArgToInt(args[0], &channel) < 0) ||
+        (rcArgToFloat(args[1], &input) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Integer and float arguments (servo channel, normalized input) required.");
+        return NULL;
+    }
+
+    if ((channel < 1) || (channel > 8)) {
+        PyErr_SetString(PyExc_ValueError, "Channel number has to be >= 1 and <= 8.");
+        return NULL;
+    }
+
+    if ((input < -1.5) || (input > 1.5)) {
+        PyErr_SetString(PyExc_ValueError, "Normalized input has to be >= -1.5 and <= 1.5.");
+        return NULL;
+    }
+
+    retval = rc_send_servo_pulse_normalized(channel, input);
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcSendServoPulseNormalizedAll(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int retval;
     float input;
 
-    if (!PyArg_ParseTuple(args, "f", &input)) {
+    if ((nargs != 1) || (rcArgToFloat(args[0], &input) < 0)) {
         PyErr_SetString(PyExc_ValueError, "Float argument (normalized input) required.");
         return NULL;
     }
@@ -451,15 +1550,16 @@ static PyObject *rcSendServoPulseNormalizedAll(PyObject *self, PyObject *args) {
 
     retval = rc_send_servo_pulse_normalized_all(input);
 
-    return Py_BuildValue("i", retval);
+    return PyLong_FromLong(retval);
 }
 
-static PyObject *rcSendESCPulseNormalized(PyObject *self, PyObject *args) {
+static PyObject *rcSendESCPulseNormalized(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
     int retval;
     int channel;
     float input;
 
-    if (!PyArg_ParseTuple(args, "if", &channel, &input)) {
+    if ((nargs != 2) || (rcArgToInt(args[0], &channel) < 0) ||
+        (rcArgToFloat(args[1], &input) < 0)) {
         PyErr_SetString(PyExc_ValueError, "Integer and float argument (ESC channel, normalized input) required.");
         return NULL;
     }
@@ -476,14 +1576,14 @@ static PyObject *rcSendESCPulseNormalized(PyObject *self, PyObject *args) {
 
     retval = rc_send_esc_pulse_normalized(channel, input);
 
-    return Py_BuildValue("i", retval);
+    return PyLong_FromLong(retval);
 }
 
-static PyObject *rcSendESCPulseNormalizedAll(PyObject *self, PyObject *args) {
+static PyObject *rcSendESCPulseNormalizedAll(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
     int retval;
     float input;
 
-    if (!PyArg_ParseTuple(args, "f", &input)) {
+    if ((nargs != 1) || (rcArgToFloat(args[0], &input) < 0)) {
         PyErr_SetString(PyExc_ValueError, "Float argument (normalized input) required.");
         return NULL;
     }
@@ -495,15 +1595,16 @@ static PyObject *rcSendESCPulseNormalizedAll(PyObject *self, PyObject *args) {
 
     retval = rc_send_esc_pulse_normalized_all(input);
 
-    return Py_BuildValue("i", retval);
+    return PyLong_FromLong(retval);
 }
 
-static PyObject *rcSendOneshotPulseNormalized(PyObject *self, PyObject *args) {
+static PyObject *rcSendOneshotPulseNormalized(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
     int retval;
     int channel;
     float input;
 
-    if (!PyArg_ParseTuple(args, "if", &channel, &input)) {
+    if ((nargs != 2) || (rcArgToInt(args[0], &channel) < 0) ||
+        (rcArgToFloat(args[1], &input) < 0)) {
         PyErr_SetString(PyExc_ValueError, "Integer and float argument (channel, normalized input) required.");
         return NULL;
     }
@@ -520,14 +1621,14 @@ static PyObject *rcSendOneshotPulseNormalized(PyObject *self, PyObject *args) {
 
     retval = rc_send_oneshot_pulse_normalized(channel, input);
 
-    return Py_BuildValue("i", retval);
+    return PyLong_FromLong(retval);
 }
 
-static PyObject *rcSendOneshotPulseNormalizedAll(PyObject *self, PyObject *args) {
+static PyObject *rcSendOneshotPulseNormalizedAll(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
     int retval;
     float input;
 
-    if (!PyArg_ParseTuple(args, "f", &input)) {
+    if ((nargs != 1) || (rcArgToFloat(args[0], &input) < 0)) {
         PyErr_SetString(PyExc_ValueError, "Float argument (normalized input) required.");
         return NULL;
     }
@@ -539,547 +1640,5196 @@ static PyObject *rcSendOneshotPulseNormalizedAll(PyObject *self, PyObject *args)
 
     retval = rc_send_oneshot_pulse_normalized_all(input);
 
-    return Py_BuildValue("i", retval);
+    return PyLong_FromLong(retval);
 }
 
-static PyObject *rcInitializeDSM(PyObject *self, PyObject *args) {
-    int retval;
-
-    retval = rc_initialize_dsm();
+/*
+ * Check normalized pulse inputs against the range of the given mode,
+ * NaN meaning "no pulse" is always accepted. Sets a ValueError and
+ * returns -1 on failure.
+ */
+static int rcCheckPulses(int mode, const float *values, Py_ssize_t count) {
+    Py_ssize_t i;
+    float low = (mode == SERVO_MODE_SERVO) ? -1.5 : -0.1;
+    float high = (mode == SERVO_MODE_SERVO) ? 1.5 : 1.0;
+
+    for (i = 0; i < count; i++) {
+        if (!isnan(values[i]) && ((values[i] < low) || (values[i] > high))) {
+            if (mode == SERVO_MODE_SERVO)
+                PyErr_SetString(PyExc_ValueError, "Normalized input has to be >= -1.5 and <= 1.5.");
+            else
+                PyErr_SetString(PyExc_ValueError, "Normalized input has to be >= -0.1 and <= 1.0.");
+            return -1;
+        }
+    }
 
-    return Py_BuildValue("i", retval);
+    return 0;
 }
 
-static PyObject *rcStopDSMService(PyObject *self, PyObject *args) {
-    int retval;
-
-    retval = rc_stop_dsm_service();
+/*
+ * Send one pulse of the given mode to channels 1-count, skipping NaN
+ * values. Does not touch Python objects, so callers may release the GIL.
+ * Returns -1 if any pulse failed, 0 otherwise.
+ */
+static int rcSendPulses(int mode, const float *values, int count) {
+    int i;
+    int retval = 0;
+
+    for (i = 0; i < count; i++) {
+        if (isnan(values[i]))
+            continue;
+
+        if (mode == SERVO_MODE_SERVO) {
+            if (rc_send_servo_pulse_normalized(i + 1, values[i]) < 0)
+                retval = -1;
+        } else if (mode == SERVO_MODE_ESC) {
+            if (rc_send_esc_pulse_normalized(i + 1, values[i]) < 0)
+                retval = -1;
+        } else {
+            if (rc_send_oneshot_pulse_normalized(i + 1, values[i]) < 0)
+                retval = -1;
+        }
+    }
 
-    return Py_BuildValue("i", retval);
+    return retval;
 }
 
-static PyObject *rcGetDSMChRaw(PyObject *self, PyObject *args) {
-    int rawvalue;
-    int channel;
+/*
+ * Shared body of the rcSend*PulseNormalizedVector functions: one
+ * argument conversion and range check, then all pulses back to back so
+ * the channels stay phase aligned.
+ */
+static PyObject *rcSendPulseVector(int mode, PyObject *const *args, Py_ssize_t nargs) {
+    float values[SERVO_CHANNELS];
+    Py_ssize_t count;
+    int retval;
 
-    if (!PyArg_ParseTuple(args, "i", &channel)) {
-        PyErr_SetString(PyExc_ValueError, "Integer argument (DSM channel number) required.");
+    if (nargs != 1) {
+        PyErr_SetString(PyExc_ValueError, "Sequence or buffer of up to 8 normalized inputs required.");
         return NULL;
     }
 
-    if ((channel < 1) || (channel > 9)) {
-        PyErr_SetString(PyExc_ValueError, "Channel number has to be >= 1 and <= 9.");
+    if ((rcFloatsFromObject(args[0], values, SERVO_CHANNELS, &count) < 0) ||
+        (rcCheckPulses(mode, values, count) < 0))
         return NULL;
+
+    retval = rcSendPulses(mode, values, (int)count);
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcSendServoPulseNormalizedVector(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    return rcSendPulseVector(SERVO_MODE_SERVO, args, nargs);
+}
+
+static PyObject *rcSendESCPulseNormalizedVector(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    return rcSendPulseVector(SERVO_MODE_ESC, args, nargs);
+}
+
+static PyObject *rcSendOneshotPulseNormalizedVector(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    return rcSendPulseVector(SERVO_MODE_ONESHOT, args, nargs);
+}
+
+static void *rcServoServiceThread(void *arg) {
+    float setpoints[SERVO_CHANNELS];
+    uint64_t front;
+    uint64_t next;
+    uint64_t now;
+
+    next = rcNanosMonotonic();
+
+    while (atomic_load_explicit(&servo_service.running, memory_order_acquire)) {
+        do {
+            front = atomic_load_explicit(&servo_service.front, memory_order_acquire);
+            memcpy(setpoints, servo_service.setpoints[front & 1], sizeof(setpoints));
+            atomic_thread_fence(memory_order_acquire);
+        } while (atomic_load_explicit(&servo_service.front, memory_order_relaxed) != front);
+
+        rcSendPulses(servo_service.mode, setpoints, SERVO_CHANNELS);
+        atomic_fetch_add_explicit(&servo_service.frames, 1, memory_order_relaxed);
+
+        // Servos and ESCs want an even pulse train: periods that were
+        // missed entirely are dropped, not sent in a burst
+        next += servo_service.period_ns;
+        now = rcNanosMonotonic();
+        while (next <= now) {
+            atomic_fetch_add_explicit(&servo_service.overruns, 1, memory_order_relaxed);
+            next += servo_service.period_ns;
+        }
+
+        rcSleepUntil(next);
     }
 
-    rawvalue = rc_get_dsm_ch_raw(channel);
+    return NULL;
+}
+
+static void rcStopServoServiceThread(void) {
+    if (!atomic_load(&servo_service.running))
+        return;
+
+    atomic_store_explicit(&servo_service.running, 0, memory_order_release);
+    servo_service.stopping = 1;
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_join(servo_service.thread, NULL);
+    Py_END_ALLOW_THREADS
 
-    return Py_BuildValue("i", rawvalue);
+    servo_service.stopping = 0;
 }
 
-static PyObject *rcGetDSMChNormalized(PyObject *self, PyObject *args) {
-    float normalized;
-    int channel;
+static PyObject *rcStartServoService(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    float rate_hz;
+    int mode;
+    int i;
 
-    if (!PyArg_ParseTuple(args, "i", &channel)) {
-        PyErr_SetString(PyExc_ValueError, "Integer argument (DSM channel number) required.");
+    if ((nargs != 2) || (rcArgToFloat(args[0], &rate_hz) < 0) ||
+        (rcArgToInt(args[1], &mode) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Float and integer arguments (rate in Hz, servo mode) required.");
         return NULL;
     }
 
-    if ((channel < 1) || (channel > 9)) {
-        PyErr_SetString(PyExc_ValueError, "Channel number has to be >= 1 and <= 9.");
+    if (!((rate_hz > 0.0) && (rate_hz <= 1000.0))) {
+        PyErr_SetString(PyExc_ValueError, "Pulse rate must be > 0 and <= 1,000 Hz.");
         return NULL;
     }
 
-    normalized = rc_get_dsm_ch_normalized(channel);
+    if ((mode < SERVO_MODE_SERVO) || (mode > SERVO_MODE_ONESHOT)) {
+        PyErr_SetString(PyExc_ValueError, "Servo mode has to be >= 0 and <= 2.");
+        return NULL;
+    }
 
-    return Py_BuildValue("f", normalized);
-}
+    if (atomic_load(&servo_service.running)) {
+        PyErr_SetString(PyExc_RuntimeError, "Servo service is already running.");
+        return NULL;
+    }
 
-static PyObject *rcIsDSMNewData(PyObject *self, PyObject *args) {
-    int retval;
+    if (servo_service.stopping) {
+        PyErr_SetString(PyExc_RuntimeError, "Servo service is still stopping.");
+        return NULL;
+    }
 
-    retval = rc_is_new_dsm_data();
+    // No channel gets pulses until its first setpoint arrives
+    for (i = 0; i < SERVO_CHANNELS; i++) {
+        servo_service.setpoints[0][i] = NAN;
+        servo_service.setpoints[1][i] = NAN;
+    }
+    servo_service.mode = mode;
+    servo_service.period_ns = (uint64_t)(1e9 / rate_hz);
+    atomic_store(&servo_service.front, 0);
+    atomic_store(&servo_service.frames, 0);
+    atomic_store(&servo_service.overruns, 0);
+    atomic_store(&servo_service.running, 1);
+
+    if (pthread_create(&servo_service.thread, NULL, rcServoServiceThread, NULL) != 0) {
+        atomic_store(&servo_service.running, 0);
+        PyErr_SetString(PyExc_RuntimeError, "Starting servo service thread failed.");
+        return NULL;
+    }
 
-    return Py_BuildValue("i", retval);
+    return PyLong_FromLong(0);
 }
 
-static PyObject *rcIsDSMActive(PyObject *self, PyObject *args) {
-    int retval;
-
-    retval = rc_is_dsm_active();
+static PyObject *rcStopServoService(PyObject *self, PyObject *args) {
+    rcStopServoServiceThread();
 
-    return Py_BuildValue("i", retval);
+    return PyLong_FromLong(0);
 }
 
-static PyObject *rcNanosSinceLastDSMPacket(PyObject *self, PyObject *args) {
-    long nanos;
+static PyObject *rcSetServoSetpoints(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    float values[SERVO_CHANNELS];
+    float *back;
+    Py_ssize_t count;
+    uint64_t front;
 
-    nanos = rc_nanos_since_last_dsm_packet();
+    if (nargs != 1) {
+        PyErr_SetString(PyExc_ValueError, "Sequence or buffer of up to 8 normalized setpoints required.");
+        return NULL;
+    }
 
-    return PyLong_FromUnsignedLongLong(nanos);
-}
+    if (rcFloatsFromObject(args[0], values, SERVO_CHANNELS, &count) < 0)
+        return NULL;
 
-static PyObject *rcGetDSMResolution(PyObject *self, PyObject *args) {
-    int resolution;
+    if (!atomic_load(&servo_service.running)) {
+        PyErr_SetString(PyExc_RuntimeError, "Servo service is not running.");
+        return NULL;
+    }
 
-    resolution = rc_get_dsm_resolution();
+    if (rcCheckPulses(servo_service.mode, values, count) < 0)
+        return NULL;
 
-    return Py_BuildValue("i", resolution);
+    // Only callers holding the GIL write, so there is a single writer.
+    // Channels beyond count keep their current setpoint.
+    // The fence keeps the writes to back from becoming visible before
+    // the previous front update: a pulse thread still copying back under
+    // an older front then sees front has moved and retries.
+    front = atomic_load_explicit(&servo_service.front, memory_order_relaxed);
+    back = servo_service.setpoints[(front + 1) & 1];
+    atomic_thread_fence(memory_order_release);
+    memcpy(back, servo_service.setpoints[front & 1], sizeof(values));
+    memcpy(back, values, count * sizeof(float));
+    atomic_store_explicit(&servo_service.front, front + 1, memory_order_release);
+
+    return PyLong_FromLong(0);
 }
 
-static PyObject *rcNumDSMChannels(PyObject *self, PyObject *args) {
-    int num_channels;
+static PyObject *rcGetServoServiceStatus(PyObject *self, PyObject *args) {
+    return Py_BuildValue("(iKK)", atomic_load(&servo_service.running),
+                         (unsigned long long)atomic_load(&servo_service.frames),
+                         (unsigned long long)atomic_load(&servo_service.overruns));
+}
 
-    num_channels = rc_num_dsm_channels();
+static void *rcLoopThread(void *arg) {
+    PyGILState_STATE gstate;
+    PyObject *result;
+    Py_buffer *inputs = &control_loop.inputs;
+    double *values;
+    float duty[4];
+    Py_ssize_t num_duties = 0;
+    uint64_t start;
+    uint64_t next;
+    uint64_t wake;
+    uint64_t done;
+    int i;
+    int error;
+
+    start = rcNanosMonotonic();
+    next = start + control_loop.period_ns;
+
+    while (!atomic_load_explicit(&control_loop.stop, memory_order_acquire) &&
+           (rc_get_state() != EXITING)) {
+        rcSleepUntil(next);
+        wake = rcNanosMonotonic();
+
+        // Sample inputs before taking the GIL, so their timing does not
+        // depend on what other Python threads are doing
+        values = (double *)control_loop.samples;
+        values[0] = (double)(wake - start) * 1e-9;
+        for (i = 0; i < 4; i++)
+            values[1 + i] = (double)rc_get_encoder_pos(i + 1);
+        for (i = 0; i < control_loop.num_adc_channels; i++)
+            values[5 + i] = (double)rc_adc_volt(control_loop.adc_channels[i]);
+
+        gstate = PyGILState_Ensure();
+
+        memcpy(inputs->buf, control_loop.samples, inputs->len);
+        result = PyObject_CallFunctionObjArgs(control_loop.callback, control_loop.array, NULL);
+
+        error = 0;
+        num_duties = 0;
+        if (result == NULL) {
+            error = 1;
+        } else {
+            if ((result != Py_None) &&
+                (rcFloatsFromObject(result, duty, 4, &num_duties) == 0)) {
+                for (i = 0; i < num_duties; i++) {
+                    if (!((duty[i] >= -1.0) && (duty[i] <= 1.0))) {
+                        PyErr_SetString(PyExc_ValueError, "Duty cycle has to be >= -1.0 and <= 1.0.");
+                        num_duties = 0;
+                        break;
+                    }
+                }
+            }
+            error = (PyErr_Occurred() != NULL);
+            Py_DECREF(result);
+        }
+
+        // Hand the exception over to the thread waiting in rcRunLoop
+        if (error) {
+            PyErr_Fetch(&control_loop.exc_type, &control_loop.exc_value, &control_loop.exc_traceback);
+            atomic_store(&control_loop.stop, 1);
+            num_duties = 0;
+        }
+
+        PyGILState_Release(gstate);
+
+        for (i = 0; i < num_duties; i++)
+            rc_set_motor(i + 1, duty[i]);
+
+        done = rcNanosMonotonic();
+
+        pthread_mutex_lock(&control_loop.stats_lock);
+        control_loop.stats.ticks++;
+        control_loop.stats.total_exec_ns += done - wake;
+        if (wake - next > control_loop.stats.max_latency_ns)
+            control_loop.stats.max_latency_ns = wake - next;
+        if (done - wake > control_loop.stats.max_exec_ns)
+            control_loop.stats.max_exec_ns = done - wake;
+
+        // A tick running into the next deadline is an overrun; missed
+        // deadlines are skipped rather than caught up in a burst
+        next += control_loop.period_ns;
+        while (next <= done) {
+            control_loop.stats.overruns++;
+            next += control_loop.period_ns;
+        }
+        pthread_mutex_unlock(&control_loop.stats_lock);
+    }
 
-    return Py_BuildValue("i", num_channels);
+    return NULL;
 }
 
-static PyObject *rcBindDSM(PyObject *self, PyObject *args) {
-    int retval;
+static PyObject *rcLoopStatsDict(void) {
+    loop_stats_t stats;
 
-    retval = rc_bind_dsm();
+    pthread_mutex_lock(&control_loop.stats_lock);
+    stats = control_loop.stats;
+    pthread_mutex_unlock(&control_loop.stats_lock);
 
-    return Py_BuildValue("i", retval);
+    return Py_BuildValue("{s:K,s:K,s:K,s:K,s:K}",
+                         "ticks", (unsigned long long)stats.ticks,
+                         "overruns", (unsigned long long)stats.overruns,
+                         "max_latency_ns", (unsigned long long)stats.max_latency_ns,
+                         "max_exec_ns", (unsigned long long)stats.max_exec_ns,
+                         "mean_exec_ns", (unsigned long long)(stats.ticks ? stats.total_exec_ns / stats.ticks : 0));
 }
 
-static PyObject *rcCalibrateDSMRoutine(PyObject *self, PyObject *args) {
+static PyObject *rcRunLoop(PyObject *self, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames) {
+    static const char *const kwlist[] = {"callback", "hz", "priority", "adc_channels", NULL};
+    PyObject *values[4] = {NULL, NULL, Py_None, NULL};
+    PyObject *seq;
+    PyObject *module;
+    PyObject *zeros;
+    pthread_attr_t attr;
+    struct sched_param param;
+    struct timespec deadline;
+    Py_ssize_t i;
+    float hz;
+    int priority = 0;
     int retval;
 
-    retval = rc_calibrate_dsm_routine();
+    if ((rcUnpackArgs(args, nargs, kwnames, kwlist, values) < 0) ||
+        (values[0] == NULL) || (values[1] == NULL) ||
+        (rcArgToFloat(values[1], &hz) < 0) ||
+        ((values[2] != Py_None) && (rcArgToInt(values[2], &priority) < 0))) {
+        PyErr_SetString(PyExc_ValueError, "Callable, float (rate in Hz) and optional integer (SCHED_FIFO priority) arguments required.");
+        return NULL;
+    }
 
-    return Py_BuildValue("i", retval);
-}
+    if (!PyCallable_Check(values[0])) {
+        PyErr_SetString(PyExc_ValueError, "Callback must be callable.");
+        return NULL;
+    }
 
-// TODO: IMU methods
+    if (!((hz > 0.0) && (hz <= 10000.0))) {
+        PyErr_SetString(PyExc_ValueError, "Loop rate must be > 0 and <= 10,000 Hz.");
+        return NULL;
+    }
 
-static PyObject *_rcInitializeBarometer(PyObject *self, PyObject *args) {
-    int retval;
-    int oversample;
-    int filter;
+    if ((values[2] != Py_None) && ((priority < 1) || (priority > 99))) {
+        PyErr_SetString(PyExc_ValueError, "Priority must be >= 1 and <= 99.");
+        return NULL;
+    }
 
-    if (!PyArg_ParseTuple(args, "ii", &oversample, &filter)) {
-        PyErr_SetString(PyExc_ValueError, "Two integer arguments (oversample setting, filter setting) required.");
+    if (control_loop.callback != NULL) {
+        PyErr_SetString(PyExc_RuntimeError, "A control loop is already running.");
         return NULL;
     }
 
-    if ((oversample < 4) || (oversample > 20) || (oversample % 4 != 0)) {
-        PyErr_SetString(PyExc_ValueError, "Allowed oversample values: 4, 8, 12, 16, or 20.");
+    control_loop.num_adc_channels = 0;
+    if (values[3] != NULL) {
+        seq = PySequence_Fast(values[3], "");
+        if ((seq == NULL) || (PySequence_Fast_GET_SIZE(seq) > ADC_CHANNELS)) {
+            Py_XDECREF(seq);
+            PyErr_SetString(PyExc_ValueError, "ADC channels have to be given as a sequence of at most 7 integers.");
+            return NULL;
+        }
+        for (i = 0; i < PySequence_Fast_GET_SIZE(seq); i++) {
+            if ((rcArgToInt(PySequence_Fast_GET_ITEM(seq, i), &control_loop.adc_channels[i]) < 0) ||
+                (control_loop.adc_channels[i] < 0) || (control_loop.adc_channels[i] > 6)) {
+                Py_DECREF(seq);
+                PyErr_SetString(PyExc_ValueError, "Channel number has to be >= 0 and <= 6.");
+                return NULL;
+            }
+        }
+        control_loop.num_adc_channels = (int)PySequence_Fast_GET_SIZE(seq);
+        Py_DECREF(seq);
+    }
+
+    // The callback gets the same array('d') every tick:
+    // [seconds since start, encoder 1-4, selected ADC channels]
+    module = PyImport_ImportModule("array");
+    if (module == NULL)
+        return NULL;
+    zeros = PyBytes_FromStringAndSize(NULL, (5 + control_loop.num_adc_channels) * sizeof(double));
+    if (zeros == NULL) {
+        Py_DECREF(module);
         return NULL;
     }
+    memset(PyBytes_AS_STRING(zeros), 0, PyBytes_GET_SIZE(zeros));
+    control_loop.array = PyObject_CallMethod(module, "array", "sO", "d", zeros);
+    Py_DECREF(zeros);
+    Py_DECREF(module);
+    if (control_loop.array == NULL)
+        return NULL;
 
-    if ((filter < 0) || (filter > 16) || (filter % 4 != 0)) {
-        PyErr_SetString(PyExc_ValueError, "Allowed filter values: 0, 4, 8, 12, or 16.");
+    // Holding the export keeps the array from being resized by the callback
+    if (PyObject_GetBuffer(control_loop.array, &control_loop.inputs, PyBUF_WRITABLE | PyBUF_C_CONTIGUOUS) < 0) {
+        Py_CLEAR(control_loop.array);
         return NULL;
     }
 
-    retval = rc_initialize_barometer(oversample, filter);
+    Py_INCREF(values[0]);
+    control_loop.callback = values[0];
+    control_loop.period_ns = (uint64_t)(1e9 / hz);
+    control_loop.exc_type = NULL;
+    control_loop.exc_value = NULL;
+    control_loop.exc_traceback = NULL;
+    memset(&control_loop.stats, 0, sizeof(control_loop.stats));
+    atomic_store(&control_loop.stop, 0);
+
+    pthread_attr_init(&attr);
+    if (values[2] != Py_None) {
+        param.sched_priority = priority;
+        pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+        pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+        pthread_attr_setschedparam(&attr, &param);
+    }
+    retval = pthread_create(&control_loop.thread, &attr, rcLoopThread, NULL);
+    pthread_attr_destroy(&attr);
+
+    if (retval != 0) {
+        PyBuffer_Release(&control_loop.inputs);
+        Py_CLEAR(control_loop.array);
+        Py_CLEAR(control_loop.callback);
+        errno = retval;
+        return PyErr_SetFromErrno(PyExc_OSError);
+    }
+
+    // Wait for the loop to end, waking up regularly so Ctrl-C still works
+    for (;;) {
+        Py_BEGIN_ALLOW_THREADS
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += 100000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        retval = pthread_timedjoin_np(control_loop.thread, NULL, &deadline);
+        Py_END_ALLOW_THREADS
+
+        if (retval == 0)
+            break;
+
+        if (PyErr_CheckSignals() < 0) {
+            atomic_store(&control_loop.stop, 1);
+            Py_BEGIN_ALLOW_THREADS
+            pthread_join(control_loop.thread, NULL);
+            Py_END_ALLOW_THREADS
+            break;
+        }
+    }
+
+    PyBuffer_Release(&control_loop.inputs);
+    Py_CLEAR(control_loop.array);
+    Py_CLEAR(control_loop.callback);
+
+    if (PyErr_Occurred()) {
+        Py_XDECREF(control_loop.exc_type);
+        Py_XDECREF(control_loop.exc_value);
+        Py_XDECREF(control_loop.exc_traceback);
+        return NULL;
+    }
 
-    return Py_BuildValue("i", retval);
+    if (control_loop.exc_type != NULL) {
+        PyErr_Restore(control_loop.exc_type, control_loop.exc_value, control_loop.exc_traceback);
+        return NULL;
+    }
+
+    return rcLoopStatsDict();
 }
 
-static PyObject *rcPowerOffBarometer(PyObject *self, PyObject *args) {
-    int retval;
+static PyObject *rcStopLoop(PyObject *self, PyObject *args) {
+    atomic_store(&control_loop.stop, 1);
 
-    retval = rc_power_off_barometer();
+    return PyLong_FromLong(0);
+}
 
-    return Py_BuildValue("i", retval);
+static PyObject *rcGetLoopStats(PyObject *self, PyObject *args) {
+    return rcLoopStatsDict();
 }
 
-static PyObject *rcReadBarometer(PyObject *self, PyObject *args) {
-    int retval;
+static int rcDSMDataFunc(void) {
+    dsm_record_t record;
+    uint64_t seq;
+    int num_channels;
+    int i;
 
-    retval = rc_read_barometer();
+    // The library does not touch the channels until its next frame
+    memset(&record, 0, sizeof(record));
+    record.nanos = rcNanosMonotonic();
+    num_channels = rc_num_dsm_channels();
+    if (num_channels > DSM_CHANNELS)
+        num_channels = DSM_CHANNELS;
+    record.num_channels = (uint8_t)num_channels;
+    record.resolution = (uint8_t)rc_get_dsm_resolution();
+    for (i = 0; i < num_channels; i++) {
+        record.raw[i] = (int16_t)rc_get_dsm_ch_raw(i + 1);
+        record.normalized[i] = rc_get_dsm_ch_normalized(i + 1);
+    }
+
+    pthread_mutex_lock(&dsm_service.lock);
+
+    seq = atomic_load_explicit(&dsm_service.seq, memory_order_relaxed);
+    atomic_store_explicit(&dsm_service.seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    dsm_service.frame = record;
+    atomic_store_explicit(&dsm_service.seq, seq + 2, memory_order_release);
+
+    if (atomic_load(&dsm_recorder.recording)) {
+        record.nanos -= dsm_recorder.start_ns;
+        spsc_ring_push(&dsm_recorder.ring, &record);
+    }
+
+    dsm_service.frames++;
+    atomic_store(&dsm_service.unread, 1);
+    pthread_cond_broadcast(&dsm_service.cond);
+    pthread_mutex_unlock(&dsm_service.lock);
 
-    return Py_BuildValue("i", retval);
+    return 0;
 }
 
-static PyObject *rcGetBMPTemperature(PyObject *self, PyObject *args) {
-    float celsius;
+/*
+ * Mark the current frame as read. Wakes a replay thread waiting to
+ * serve the next frame as fast as possible.
+ */
+static void rcDSMFrameRead(void) {
+    if (atomic_exchange(&dsm_service.unread, 0)) {
+        pthread_mutex_lock(&dsm_service.lock);
+        pthread_cond_broadcast(&dsm_service.cond);
+        pthread_mutex_unlock(&dsm_service.lock);
+    }
+}
 
-    celsius = rc_bmp_get_temperature();
+/*
+ * Frame accessors used by every DSM binding: the replayed frame while
+ * replay is active, the library otherwise.
+ */
+static int rcDSMChRaw(int channel) {
+    const dsm_record_t *record;
 
-    return Py_BuildValue("f", celsius);
+    if (!atomic_load(&dsm_replay.active))
+        return rc_get_dsm_ch_raw(channel);
+
+    record = atomic_load(&dsm_replay.current);
+    if ((record == NULL) || (channel > record->num_channels))
+        return 0;
+
+    return record->raw[channel - 1];
 }
 
-static PyObject *rcGetBMPPressurePa(PyObject *self, PyObject *args) {
-    float pa;
+static float rcDSMChNormalized(int channel) {
+    const dsm_record_t *record;
 
-    pa = rc_bmp_get_pressure_pa();
+    if (!atomic_load(&dsm_replay.active))
+        return rc_get_dsm_ch_normalized(channel);
+
+    record = atomic_load(&dsm_replay.current);
+    if ((record == NULL) || (channel > record->num_channels))
+        return 0.0;
 
-    return Py_BuildValue("f", pa);
+    return record->normalized[channel - 1];
 }
 
-static PyObject *rcGetBMPAltitudeM(PyObject *self, PyObject *args) {
-    float meters;
+static int rcDSMNumChannels(void) {
+    const dsm_record_t *record;
 
-    meters = rc_bmp_get_altitude_m();
+    if (!atomic_load(&dsm_replay.active))
+        return rc_num_dsm_channels();
+
+    record = atomic_load(&dsm_replay.current);
 
-    return Py_BuildValue("f", meters);
+    return (record == NULL) ? 0 : record->num_channels;
 }
 
-static PyObject *rcSetBMPSeaLevelPressurePa(PyObject *self, PyObject *args) {
-    int retval;
-    float pa;
+static int rcDSMResolution(void) {
+    const dsm_record_t *record;
+
+    if (!atomic_load(&dsm_replay.active))
+        return rc_get_dsm_resolution();
+
+    record = atomic_load(&dsm_replay.current);
+
+    return (record == NULL) ? 0 : record->resolution;
+}
+
+static uint64_t rcDSMNanosSinceLastPacket(void) {
+    if (!atomic_load(&dsm_replay.active))
+        return rc_nanos_since_last_dsm_packet();
+
+    if (atomic_load(&dsm_replay.current) == NULL)
+        return UINT64_MAX;
+
+    return rcNanosMonotonic() - atomic_load(&dsm_replay.published_ns);
+}
+
+static int rcDSMActive(void) {
+    if (!atomic_load(&dsm_replay.active))
+        return rc_is_dsm_active();
+
+    return (atomic_load(&dsm_replay.current) != NULL) && !atomic_load(&dsm_replay.finished);
+}
+
+static PyObject *rcInitializeDSM(PyObject *self, PyObject *args) {
+    int retval;
+
+    if (atomic_load(&dsm_replay.active)) {
+        PyErr_SetString(PyExc_RuntimeError, "DSM replay is active.");
+        return NULL;
+    }
+
+    retval = rc_initialize_dsm();
+
+    if (retval == 0) {
+        pthread_mutex_lock(&dsm_service.lock);
+        dsm_service.running = 1;
+        pthread_mutex_unlock(&dsm_service.lock);
+        rc_set_dsm_data_func(rcDSMDataFunc);
+    }
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcStopDSMService(PyObject *self, PyObject *args) {
+    int retval;
+
+    if (atomic_load(&dsm_replay.active)) {
+        rcStopDSMReplayThread();
+        return PyLong_FromLong(0);
+    }
+
+    rcStopDSMCallbackThread();
+
+    retval = rc_stop_dsm_service();
+
+    // Let rcWaitDSMFrame callers return instead of waiting forever
+    pthread_mutex_lock(&dsm_service.lock);
+    dsm_service.running = 0;
+    pthread_cond_broadcast(&dsm_service.cond);
+    pthread_mutex_unlock(&dsm_service.lock);
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcGetDSMChRaw(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int rawvalue;
+    int channel;
+
+    if ((nargs != 1) || (rcArgToInt(args[0], &channel) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Integer argument (DSM channel number) required.");
+        return NULL;
+    }
+
+    if ((channel < 1) || (channel > 9)) {
+        PyErr_SetString(PyExc_ValueError, "Channel number has to be >= 1 and <= 9.");
+        return NULL;
+    }
+
+    rawvalue = rcDSMChRaw(channel);
+    rcDSMFrameRead();
+
+    return PyLong_FromLong(rawvalue);
+}
+
+static PyObject *rcGetDSMChNormalized(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    float normalized;
+    int channel;
+
+    if ((nargs != 1) || (rcArgToInt(args[0], &channel) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Integer argument (DSM channel number) required.");
+        return NULL;
+    }
+
+    if ((channel < 1) || (channel > 9)) {
+        PyErr_SetString(PyExc_ValueError, "Channel number has to be >= 1 and <= 9.");
+        return NULL;
+    }
+
+    normalized = rcDSMChNormalized(channel);
+    rcDSMFrameRead();
+
+    return PyFloat_FromDouble(normalized);
+}
+
+static PyObject *rcIsDSMNewData(PyObject *self, PyObject *args) {
+    int retval;
+
+    if (atomic_load(&dsm_service.running))
+        retval = atomic_load(&dsm_service.unread);
+    else
+        retval = rc_is_new_dsm_data();
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcIsDSMActive(PyObject *self, PyObject *args) {
+    int retval;
+
+    retval = rcDSMActive();
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcNanosSinceLastDSMPacket(PyObject *self, PyObject *args) {
+    long nanos;
+
+    nanos = rcDSMNanosSinceLastPacket();
+
+    return PyLong_FromUnsignedLongLong(nanos);
+}
+
+static PyObject *rcGetDSMResolution(PyObject *self, PyObject *args) {
+    int resolution;
+
+    resolution = rcDSMResolution();
+
+    return PyLong_FromLong(resolution);
+}
+
+static PyObject *rcNumDSMChannels(PyObject *self, PyObject *args) {
+    int num_channels;
+
+    num_channels = rcDSMNumChannels();
+
+    return PyLong_FromLong(num_channels);
+}
+
+static PyObject *rcBindDSM(PyObject *self, PyObject *args) {
+    int retval;
+
+    retval = rc_bind_dsm();
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcCalibrateDSMRoutine(PyObject *self, PyObject *args) {
+    int retval;
+
+    retval = rc_calibrate_dsm_routine();
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcWaitDSMFrame(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    struct timespec ts;
+    uint64_t now;
+    uint64_t deadline = UINT64_MAX;
+    uint64_t wake;
+    float timeout;
+    int running;
+    int received;
+
+    if ((nargs > 1) ||
+        ((nargs == 1) && (args[0] != Py_None) && (rcArgToFloat(args[0], &timeout) < 0))) {
+        PyErr_SetString(PyExc_ValueError, "Optional float argument (timeout in seconds) required.");
+        return NULL;
+    }
+
+    if ((nargs == 1) && (args[0] != Py_None)) {
+        if (!(timeout >= 0.0)) {
+            PyErr_SetString(PyExc_ValueError, "Timeout must be >= 0.");
+            return NULL;
+        }
+        // Keeps the conversion to nanoseconds defined, inf included
+        if (timeout < DSM_MAX_TIMEOUT)
+            deadline = rcNanosMonotonic() + (uint64_t)(timeout * 1e9);
+    }
+
+    // A finished replay still hands out its last frame, then returns 0
+    if (!atomic_load(&dsm_service.running) && !atomic_load(&dsm_replay.active)) {
+        PyErr_SetString(PyExc_RuntimeError, "DSM service is not running.");
+        return NULL;
+    }
+
+    // Wait in slices of at most 100 ms, so Ctrl-C still works
+    for (;;) {
+        Py_BEGIN_ALLOW_THREADS
+        now = rcNanosMonotonic();
+        wake = now + 100000000ULL;
+        if (wake > deadline)
+            wake = deadline;
+        ts.tv_sec = (time_t)(wake / 1000000000ULL);
+        ts.tv_nsec = (long)(wake % 1000000000ULL);
+
+        pthread_mutex_lock(&dsm_service.lock);
+        while (!dsm_service.unread && dsm_service.running && (wake > now) &&
+               (pthread_cond_timedwait(&dsm_service.cond, &dsm_service.lock, &ts) != ETIMEDOUT))
+            ;
+        received = dsm_service.unread;
+        running = dsm_service.running;
+        pthread_mutex_unlock(&dsm_service.lock);
+        Py_END_ALLOW_THREADS
+
+        if (received)
+            return PyLong_FromLong(1);
+
+        if (!running || (rcNanosMonotonic() >= deadline))
+            return PyLong_FromLong(0);
+
+        if (PyErr_CheckSignals() < 0)
+            return NULL;
+    }
+}
+
+/*
+ * Copy all channels of the newest DSM frame into values[0..8] (NaN for
+ * channels not sent) followed by resolution, nanoseconds since the
+ * packet and the active flag. The channels come from a single snapshot:
+ * the replayed record or the frame published by rcDSMDataFunc, so they
+ * never mix two frames.
+ */
+static void rcReadDSMFrame(int normalized, double *values, int *num_channels, uint64_t *nanos) {
+    const dsm_record_t *current;
+    dsm_record_t frame;
+    uint64_t seq;
+    int i;
+
+    if (atomic_load(&dsm_replay.active)) {
+        current = atomic_load(&dsm_replay.current);
+        if (current != NULL)
+            frame = *current;
+        else
+            memset(&frame, 0, sizeof(frame));
+    } else {
+        do {
+            seq = atomic_load_explicit(&dsm_service.seq, memory_order_acquire);
+            memcpy(&frame, &dsm_service.frame, sizeof(frame));
+            atomic_thread_fence(memory_order_acquire);
+        } while ((seq & 1) || (atomic_load_explicit(&dsm_service.seq, memory_order_relaxed) != seq));
+    }
+
+    // Replayed records come from a file
+    *num_channels = frame.num_channels;
+    if (*num_channels > DSM_CHANNELS)
+        *num_channels = DSM_CHANNELS;
+    for (i = 0; i < *num_channels; i++)
+        values[i] = normalized ? (double)frame.normalized[i] : (double)frame.raw[i];
+    *nanos = rcDSMNanosSinceLastPacket();
+
+    for (i = *num_channels; i < DSM_CHANNELS; i++)
+        values[i] = NAN;
+    values[DSM_CHANNELS] = (double)frame.resolution;
+    values[DSM_CHANNELS + 1] = (double)*nanos;
+    values[DSM_CHANNELS + 2] = (double)rcDSMActive();
+
+    rcDSMFrameRead();
+}
+
+static PyObject *rcGetDSMFrame(PyObject *self, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames) {
+    static const char *const kwlist[] = {"out", "normalized", NULL};
+    PyObject *values[2] = {Py_None, Py_True};
+    PyObject *frame;
+    PyObject *channels;
+    PyObject *item;
+    Py_buffer out;
+    double frame_values[DSM_FRAME_LEN];
+    uint64_t nanos;
+    int normalized;
+    int num_channels;
+    int i;
+
+    if ((rcUnpackArgs(args, nargs, kwnames, kwlist, values) < 0) ||
+        ((normalized = PyObject_IsTrue(values[1])) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Optional writable 'd' buffer (out) and boolean (normalized) arguments required.");
+        return NULL;
+    }
+
+    if (values[0] != Py_None) {
+        if (PyObject_GetBuffer(values[0], &out, PyBUF_WRITABLE | PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) < 0) {
+            PyErr_SetString(PyExc_ValueError, "Writable contiguous buffer (out) required.");
+            return NULL;
+        }
+
+        if ((out.format == NULL) || (strcmp(out.format, "d") != 0) ||
+            (out.len < (Py_ssize_t)sizeof(frame_values))) {
+            PyBuffer_Release(&out);
+            PyErr_SetString(PyExc_ValueError, "Buffer (out) has to hold at least 12 double ('d') values.");
+            return NULL;
+        }
+
+        rcReadDSMFrame(normalized, (double *)out.buf, &num_channels, &nanos);
+        PyBuffer_Release(&out);
+
+        return PyLong_FromLong(num_channels);
+    }
+
+    rcReadDSMFrame(normalized, frame_values, &num_channels, &nanos);
+
+    channels = PyTuple_New(num_channels);
+    if (channels == NULL)
+        return NULL;
+    for (i = 0; i < num_channels; i++) {
+        item = normalized ? PyFloat_FromDouble(frame_values[i]) : PyLong_FromLong((long)frame_values[i]);
+        if (item == NULL) {
+            Py_DECREF(channels);
+            return NULL;
+        }
+        PyTuple_SET_ITEM(channels, i, item);
+    }
+
+    frame = PyStructSequence_New(DSMFrameType);
+    if (frame == NULL) {
+        Py_DECREF(channels);
+        return NULL;
+    }
+    PyStructSequence_SET_ITEM(frame, 0, channels);
+    PyStructSequence_SET_ITEM(frame, 1, PyLong_FromLong((long)frame_values[DSM_CHANNELS]));
+    PyStructSequence_SET_ITEM(frame, 2, PyLong_FromUnsignedLongLong((unsigned long long)nanos));
+    PyStructSequence_SET_ITEM(frame, 3, PyLong_FromLong((long)frame_values[DSM_CHANNELS + 2]));
+
+    if (PyErr_Occurred()) {
+        Py_DECREF(frame);
+        return NULL;
+    }
+
+    return frame;
+}
+
+static void *rcDSMCallbackThread(void *arg) {
+    PyGILState_STATE gstate;
+    PyObject *callback;
+    PyObject *channels;
+    PyObject *result;
+    double values[DSM_FRAME_LEN];
+    uint64_t frames;
+    uint64_t nanos;
+    int num_channels;
+    int i;
+
+    // A frame nobody has read yet is delivered right away
+    pthread_mutex_lock(&dsm_service.lock);
+    frames = dsm_service.frames - (dsm_service.unread ? 1 : 0);
+    pthread_mutex_unlock(&dsm_service.lock);
+
+    for (;;) {
+        pthread_mutex_lock(&dsm_service.lock);
+        while ((dsm_service.frames == frames) &&
+               atomic_load_explicit(&dsm_service.dispatching, memory_order_acquire))
+            pthread_cond_wait(&dsm_service.cond, &dsm_service.lock);
+        frames = dsm_service.frames;
+        pthread_mutex_unlock(&dsm_service.lock);
+
+        if (!atomic_load_explicit(&dsm_service.dispatching, memory_order_acquire))
+            break;
+
+        // Copy the frame snapshot rcGetDSMFrame reads before taking the
+        // GIL; frames arriving while the callback runs are coalesced into
+        // the newest one. This clears unread: the callback consumes the
+        // frame just like rcGetDSMFrame would
+        rcReadDSMFrame(1, values, &num_channels, &nanos);
+
+        gstate = PyGILState_Ensure();
+
+        callback = dsm_service.callback;
+        if (callback != NULL) {
+            Py_INCREF(callback);
+            channels = PyTuple_New(num_channels);
+            for (i = 0; (channels != NULL) && (i < num_channels); i++) {
+                result = PyFloat_FromDouble(values[i]);
+                if (result == NULL)
+                    Py_CLEAR(channels);
+                else
+                    PyTuple_SET_ITEM(channels, i, result);
+            }
+
+            result = (channels == NULL) ? NULL : PyObject_CallFunctionObjArgs(callback, channels, NULL);
+            if (result == NULL)
+                PyErr_WriteUnraisable(callback);
+
+            Py_XDECREF(result);
+            Py_XDECREF(channels);
+            Py_DECREF(callback);
+        }
+
+        PyGILState_Release(gstate);
+    }
+
+    return NULL;
+}
+
+static void rcStopDSMCallbackThread(void) {
+    if (!atomic_load(&dsm_service.dispatching))
+        return;
+
+    pthread_mutex_lock(&dsm_service.lock);
+    atomic_store_explicit(&dsm_service.dispatching, 0, memory_order_release);
+    pthread_cond_broadcast(&dsm_service.cond);
+    pthread_mutex_unlock(&dsm_service.lock);
+    dsm_service.stopping = 1;
+
+    // The thread may be waiting for the GIL to finish a callback
+    Py_BEGIN_ALLOW_THREADS
+    pthread_join(dsm_service.thread, NULL);
+    Py_END_ALLOW_THREADS
+
+    Py_CLEAR(dsm_service.callback);
+    dsm_service.stopping = 0;
+}
+
+static PyObject *rcSetDSMCallback(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    PyObject *previous;
+
+    if ((nargs != 1) || ((args[0] != Py_None) && !PyCallable_Check(args[0]))) {
+        PyErr_SetString(PyExc_ValueError, "Callable or None argument (callback) required.");
+        return NULL;
+    }
+
+    if (args[0] == Py_None) {
+        rcStopDSMCallbackThread();
+        return PyLong_FromLong(0);
+    }
+
+    if (dsm_service.stopping) {
+        PyErr_SetString(PyExc_RuntimeError, "DSM callback is still stopping.");
+        return NULL;
+    }
+
+    if (dsm_replay.stopping) {
+        PyErr_SetString(PyExc_RuntimeError, "DSM replay is still stopping.");
+        return NULL;
+    }
+
+    // The thread only reads callback with the GIL held, so a running
+    // thread can simply be handed the new one
+    previous = dsm_service.callback;
+    Py_INCREF(args[0]);
+    dsm_service.callback = args[0];
+    Py_XDECREF(previous);
+
+    if (atomic_load(&dsm_service.dispatching))
+        return PyLong_FromLong(0);
+
+    atomic_store(&dsm_service.dispatching, 1);
+    if (pthread_create(&dsm_service.thread, NULL, rcDSMCallbackThread, NULL) != 0) {
+        atomic_store(&dsm_service.dispatching, 0);
+        Py_CLEAR(dsm_service.callback);
+        PyErr_SetString(PyExc_RuntimeError, "Starting DSM callback thread failed.");
+        return NULL;
+    }
+
+    return PyLong_FromLong(0);
+}
+
+static void *rcDSMRecorderThread(void *arg) {
+    uint64_t next;
+    size_t count;
+    size_t i;
+    int stop;
+
+    next = rcNanosMonotonic();
+
+    // Write out what has been recorded every 50 ms; one more pass after
+    // recording has been switched off catches the last frames
+    do {
+        stop = !atomic_load(&dsm_recorder.recording);
+
+        count = spsc_ring_available(&dsm_recorder.ring);
+        for (i = 0; i < count; i++) {
+            if (fwrite(spsc_ring_peek(&dsm_recorder.ring, i), sizeof(dsm_record_t), 1, dsm_recorder.file) == 1)
+                dsm_recorder.written++;
+            else if (dsm_recorder.error == 0)
+                dsm_recorder.error = errno ? errno : EIO;
+        }
+        spsc_ring_consume(&dsm_recorder.ring, count);
+
+        if (!stop) {
+            next += 50000000ULL;
+            rcSleepUntil(next);
+        }
+    } while (!stop);
+
+    return NULL;
+}
+
+/*
+ * Stop recording and close the file. Returns 0 or the errno of the
+ * first failed write.
+ */
+static int rcStopDSMRecorderThread(void) {
+    int error;
+
+    if (!atomic_load(&dsm_recorder.recording))
+        return 0;
+
+    pthread_mutex_lock(&dsm_service.lock);
+    atomic_store(&dsm_recorder.recording, 0);
+    pthread_mutex_unlock(&dsm_service.lock);
+    dsm_recorder.stopping = 1;
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_join(dsm_recorder.thread, NULL);
+    if ((fclose(dsm_recorder.file) != 0) && (dsm_recorder.error == 0))
+        dsm_recorder.error = errno;
+    Py_END_ALLOW_THREADS
+
+    dsm_recorder.file = NULL;
+    spsc_ring_free(&dsm_recorder.ring);
+    dsm_recorder.stopping = 0;
+
+    error = dsm_recorder.error;
+    if (atomic_load(&dsm_recorder.ring.overruns) && (error == 0))
+        error = ENOBUFS;
+
+    return error;
+}
+
+static PyObject *rcStartDSMRecording(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    PyObject *path;
+
+    if ((nargs != 1) || !PyUnicode_FSConverter(args[0], &path)) {
+        PyErr_SetString(PyExc_ValueError, "Path argument (recording file) required.");
+        return NULL;
+    }
+
+    if (atomic_load(&dsm_recorder.recording)) {
+        Py_DECREF(path);
+        PyErr_SetString(PyExc_RuntimeError, "DSM recording is already running.");
+        return NULL;
+    }
+
+    if (dsm_recorder.stopping) {
+        Py_DECREF(path);
+        PyErr_SetString(PyExc_RuntimeError, "DSM recording is still stopping.");
+        return NULL;
+    }
+
+    dsm_recorder.file = fopen(PyBytes_AS_STRING(path), "wb");
+    if (dsm_recorder.file == NULL) {
+        PyErr_SetFromErrnoWithFilenameObject(PyExc_OSError, args[0]);
+        Py_DECREF(path);
+        return NULL;
+    }
+    Py_DECREF(path);
+
+    if (fwrite(DSM_RECORD_MAGIC, 8, 1, dsm_recorder.file) != 1) {
+        PyErr_SetFromErrnoWithFilenameObject(PyExc_OSError, args[0]);
+        fclose(dsm_recorder.file);
+        return NULL;
+    }
+
+    // Room for about 5 s of frames between two writer passes
+    if (spsc_ring_alloc(&dsm_recorder.ring, sizeof(dsm_record_t), 256) < 0) {
+        fclose(dsm_recorder.file);
+        return PyErr_NoMemory();
+    }
+
+    dsm_recorder.start_ns = rcNanosMonotonic();
+    dsm_recorder.written = 0;
+    dsm_recorder.error = 0;
+    atomic_store(&dsm_recorder.recording, 1);
+
+    if (pthread_create(&dsm_recorder.thread, NULL, rcDSMRecorderThread, NULL) != 0) {
+        pthread_mutex_lock(&dsm_service.lock);
+        atomic_store(&dsm_recorder.recording, 0);
+        pthread_mutex_unlock(&dsm_service.lock);
+        fclose(dsm_recorder.file);
+        spsc_ring_free(&dsm_recorder.ring);
+        PyErr_SetString(PyExc_RuntimeError, "Starting DSM recorder thread failed.");
+        return NULL;
+    }
+
+    return PyLong_FromLong(0);
+}
+
+static PyObject *rcStopDSMRecording(PyObject *self, PyObject *args) {
+    int error;
+
+    error = rcStopDSMRecorderThread();
+    if (error != 0) {
+        errno = error;
+        return PyErr_SetFromErrno(PyExc_OSError);
+    }
+
+    return PyLong_FromUnsignedLongLong(dsm_recorder.written);
+}
+
+static void *rcDSMReplayThread(void *arg) {
+    const dsm_record_t *record;
+    struct timespec ts;
+    uint64_t start;
+    uint64_t target;
+    size_t i;
+
+    start = rcNanosMonotonic();
+
+    for (i = 0; i < dsm_replay.count; i++) {
+        record = &dsm_replay.records[i];
+
+        // Either keep the recorded spacing of frames or hand out the
+        // next one as soon as the previous one has been read
+        pthread_mutex_lock(&dsm_service.lock);
+        if (dsm_replay.realtime) {
+            target = start + (record->nanos - dsm_replay.records[0].nanos);
+            ts.tv_sec = (time_t)(target / 1000000000ULL);
+            ts.tv_nsec = (long)(target % 1000000000ULL);
+            while (!atomic_load(&dsm_replay.stop) && (rcNanosMonotonic() < target))
+                pthread_cond_timedwait(&dsm_service.cond, &dsm_service.lock, &ts);
+        } else {
+            while (!atomic_load(&dsm_replay.stop) && dsm_service.unread)
+                pthread_cond_wait(&dsm_service.cond, &dsm_service.lock);
+        }
+
+        if (atomic_load(&dsm_replay.stop)) {
+            pthread_mutex_unlock(&dsm_service.lock);
+            break;
+        }
+
+        atomic_store(&dsm_replay.current, record);
+        atomic_store(&dsm_replay.published_ns, rcNanosMonotonic());
+        atomic_store(&dsm_replay.replayed, i + 1);
+        dsm_service.frames++;
+        atomic_store(&dsm_service.unread, 1);
+        pthread_cond_broadcast(&dsm_service.cond);
+        pthread_mutex_unlock(&dsm_service.lock);
+    }
+
+    // Like a receiver losing its signal: the last frame stays readable,
+    // rcWaitDSMFrame callers return
+    pthread_mutex_lock(&dsm_service.lock);
+    atomic_store(&dsm_replay.finished, 1);
+    atomic_store(&dsm_service.running, 0);
+    pthread_cond_broadcast(&dsm_service.cond);
+    pthread_mutex_unlock(&dsm_service.lock);
+
+    return NULL;
+}
+
+static void rcStopDSMReplayThread(void) {
+    if (!atomic_load(&dsm_replay.active) || dsm_replay.stopping)
+        return;
+
+    // The callback thread reads records without the GIL; stopping keeps
+    // a new one from being started until records are freed
+    dsm_replay.stopping = 1;
+    rcStopDSMCallbackThread();
+
+    pthread_mutex_lock(&dsm_service.lock);
+    atomic_store(&dsm_replay.stop, 1);
+    pthread_cond_broadcast(&dsm_service.cond);
+    pthread_mutex_unlock(&dsm_service.lock);
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_join(dsm_replay.thread, NULL);
+    Py_END_ALLOW_THREADS
+
+    atomic_store(&dsm_replay.active, 0);
+    atomic_store(&dsm_replay.current, NULL);
+    atomic_store(&dsm_service.unread, 0);
+    free(dsm_replay.records);
+    dsm_replay.records = NULL;
+    dsm_replay.stopping = 0;
+}
+
+static PyObject *rcStartDSMReplay(PyObject *self, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames) {
+    static const char *const kwlist[] = {"path", "realtime", NULL};
+    PyObject *values[2] = {NULL, Py_True};
+    PyObject *path;
+    FILE *file;
+    char magic[8];
+    long size;
+    size_t count = 0;
+    dsm_record_t *records = NULL;
+    int realtime;
+
+    if ((rcUnpackArgs(args, nargs, kwnames, kwlist, values) < 0) || (values[0] == NULL) ||
+        ((realtime = PyObject_IsTrue(values[1])) < 0) ||
+        !PyUnicode_FSConverter(values[0], &path)) {
+        PyErr_SetString(PyExc_ValueError, "Path (recording file) and optional boolean (realtime) arguments required.");
+        return NULL;
+    }
+
+    if (atomic_load(&dsm_replay.active) || atomic_load(&dsm_service.running)) {
+        Py_DECREF(path);
+        PyErr_SetString(PyExc_RuntimeError, "DSM service or replay is already running.");
+        return NULL;
+    }
+
+    file = fopen(PyBytes_AS_STRING(path), "rb");
+    Py_DECREF(path);
+    if (file == NULL)
+        return PyErr_SetFromErrnoWithFilenameObject(PyExc_OSError, values[0]);
+
+    if ((fread(magic, 8, 1, file) == 1) && (memcmp(magic, DSM_RECORD_MAGIC, 8) == 0) &&
+        (fseek(file, 0, SEEK_END) == 0) && ((size = ftell(file)) >= 8) &&
+        (fseek(file, 8, SEEK_SET) == 0)) {
+        count = (size_t)(size - 8) / sizeof(dsm_record_t);
+        records = malloc((count ? count : 1) * sizeof(dsm_record_t));
+        if ((records != NULL) && (fread(records, sizeof(dsm_record_t), count, file) != count)) {
+            free(records);
+            records = NULL;
+            count = 0;
+        }
+    }
+    fclose(file);
+
+    if (count == 0) {
+        free(records);
+        PyErr_SetString(PyExc_ValueError, "File is not a DSM recording or holds no frames.");
+        return NULL;
+    }
+
+    dsm_replay.records = records;
+    dsm_replay.count = count;
+    dsm_replay.realtime = realtime;
+    atomic_store(&dsm_replay.current, NULL);
+    atomic_store(&dsm_replay.replayed, 0);
+    atomic_store(&dsm_replay.stop, 0);
+    atomic_store(&dsm_replay.finished, 0);
+    atomic_store(&dsm_service.unread, 0);
+    atomic_store(&dsm_replay.active, 1);
+    atomic_store(&dsm_service.running, 1);
+
+    if (pthread_create(&dsm_replay.thread, NULL, rcDSMReplayThread, NULL) != 0) {
+        atomic_store(&dsm_service.running, 0);
+        atomic_store(&dsm_replay.active, 0);
+        free(dsm_replay.records);
+        dsm_replay.records = NULL;
+        PyErr_SetString(PyExc_RuntimeError, "Starting DSM replay thread failed.");
+        return NULL;
+    }
+
+    return PyLong_FromLong(0);
+}
+
+static PyObject *rcStopDSMReplay(PyObject *self, PyObject *args) {
+    size_t replayed;
+
+    replayed = atomic_load(&dsm_replay.replayed);
+    rcStopDSMReplayThread();
+
+    return PyLong_FromSize_t(replayed);
+}
+
+/*
+ * Fill conf from the leading _rcInitializeIMU* arguments: accel and
+ * gyro full scale range, accel and gyro low pass filter, magnetometer
+ * flag. Sets a ValueError and returns -1 on failure.
+ */
+static int rcIMUConfigFromArgs(PyObject *const *args, Py_ssize_t nargs, rc_imu_config_t *conf) {
+    int accel_fsr;
+    int gyro_fsr;
+    int accel_dlpf;
+    int gyro_dlpf;
+    int magnetometer;
+
+    if ((nargs < 5) || (rcArgToInt(args[0], &accel_fsr) < 0) ||
+        (rcArgToInt(args[1], &gyro_fsr) < 0) || (rcArgToInt(args[2], &accel_dlpf) < 0) ||
+        (rcArgToInt(args[3], &gyro_dlpf) < 0) || (rcArgToInt(args[4], &magnetometer) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Five integer arguments (accel range, gyro range, accel filter, gyro filter, magnetometer) required.");
+        return -1;
+    }
+
+    if ((accel_fsr < A_FSR_2G) || (accel_fsr > A_FSR_16G) ||
+        (gyro_fsr < G_FSR_250DPS) || (gyro_fsr > G_FSR_2000DPS)) {
+        PyErr_SetString(PyExc_ValueError, "Full scale ranges have to be >= 0 and <= 3.");
+        return -1;
+    }
+
+    if ((accel_dlpf < ACCEL_DLPF_OFF) || (accel_dlpf > ACCEL_DLPF_5) ||
+        (gyro_dlpf < GYRO_DLPF_OFF) || (gyro_dlpf > GYRO_DLPF_5)) {
+        PyErr_SetString(PyExc_ValueError, "Low pass filter settings have to be >= 0 and <= 6.");
+        return -1;
+    }
+
+    if ((magnetometer < 0) || (magnetometer > 1)) {
+        PyErr_SetString(PyExc_ValueError, "Magnetometer has to be 0 or 1.");
+        return -1;
+    }
+
+    *conf = rc_default_imu_config();
+    conf->accel_fsr = accel_fsr;
+    conf->gyro_fsr = gyro_fsr;
+    conf->accel_dlpf = accel_dlpf;
+    conf->gyro_dlpf = gyro_dlpf;
+    conf->enable_magnetometer = magnetometer;
+
+    return 0;
+}
+
+static PyObject *_rcInitializeIMU(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    rc_imu_config_t conf;
+    int retval;
+
+    if (nargs != 5) {
+        PyErr_SetString(PyExc_ValueError, "Five integer arguments (accel range, gyro range, accel filter, gyro filter, magnetometer) required.");
+        return NULL;
+    }
+
+    if (rcIMUConfigFromArgs(args, nargs, &conf) < 0)
+        return NULL;
+
+    if (atomic_load(&imu_service.running)) {
+        PyErr_SetString(PyExc_RuntimeError, "IMU is running in DMP mode.");
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&i2c_bus_lock[IMU_I2C_BUS]);
+    retval = rc_initialize_imu(&imu_service.data, conf);
+    imu_fifo.initialized = (retval == 0);
+    imu_fifo.running = 0;
+    pthread_mutex_unlock(&i2c_bus_lock[IMU_I2C_BUS]);
+    Py_END_ALLOW_THREADS
+
+    if (retval == 0)
+        imu_service.config = conf;
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *_rcInitializeIMUDMP(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    static const int orientations[] = {
+        ORIENTATION_Z_UP, ORIENTATION_Z_DOWN, ORIENTATION_X_UP, ORIENTATION_X_DOWN,
+        ORIENTATION_Y_UP, ORIENTATION_Y_DOWN, ORIENTATION_X_FORWARD, ORIENTATION_X_BACK
+    };
+    rc_imu_config_t conf;
+    int sample_rate;
+    int orientation;
+    float time_constant;
+    int capacity;
+    int retval;
+    size_t i;
+
+    if ((nargs != 9) || (rcArgToInt(args[5], &sample_rate) < 0) ||
+        (rcArgToInt(args[6], &orientation) < 0) || (rcArgToFloat(args[7], &time_constant) < 0) ||
+        (rcArgToInt(args[8], &capacity) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Five integer arguments like _rcInitializeIMU, integer (sample rate), integer (orientation), float (compass time constant) and integer (capacity in samples) arguments required.");
+        return NULL;
+    }
+
+    if (rcIMUConfigFromArgs(args, 5, &conf) < 0)
+        return NULL;
+
+    if ((sample_rate < 4) || (sample_rate > 200) || (200 % sample_rate != 0)) {
+        PyErr_SetString(PyExc_ValueError, "Sample rate has to be 200 Hz divided by an integer, >= 4.");
+        return NULL;
+    }
+
+    for (i = 0; i < sizeof(orientations) / sizeof(orientations[0]); i++)
+        if (orientation == orientations[i])
+            break;
+    if (i == sizeof(orientations) / sizeof(orientations[0])) {
+        PyErr_SetString(PyExc_ValueError, "Unknown orientation.");
+        return NULL;
+    }
+
+    if (!(time_constant > 0.0)) {
+        PyErr_SetString(PyExc_ValueError, "Compass time constant must be > 0.");
+        return NULL;
+    }
+
+    if (capacity < 1) {
+        PyErr_SetString(PyExc_ValueError, "Capacity must be > 0.");
+        return NULL;
+    }
+
+    if (atomic_load(&imu_service.running)) {
+        PyErr_SetString(PyExc_RuntimeError, "IMU is already running in DMP mode.");
+        return NULL;
+    }
+
+    // The library's interrupt thread does not take i2c_bus_lock
+    if (atomic_load(&bmp_service.running) || bmp_service.stopping) {
+        PyErr_SetString(PyExc_RuntimeError, "Barometer service is running on the IMU's I²C bus.");
+        return NULL;
+    }
+
+    conf.dmp_sample_rate = sample_rate;
+    conf.orientation = orientation;
+    conf.compass_time_constant = time_constant;
+
+    if (spsc_ring_alloc(&imu_service.ring, sizeof(imu_sample_t), (size_t)capacity) < 0)
+        return PyErr_NoMemory();
+
+    pthread_mutex_lock(&imu_service.lock);
+    memset(&imu_service.latest, 0, sizeof(imu_service.latest));
+    imu_service.samples = 0;
+    pthread_mutex_unlock(&imu_service.lock);
+    imu_service.config = conf;
+
+    // Polled reads are refused from here on
+    atomic_store(&imu_service.running, 1);
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&i2c_bus_lock[IMU_I2C_BUS]);
+    retval = rc_initialize_imu_dmp(&imu_service.data, conf);
+    imu_fifo.initialized = 0;
+    imu_fifo.running = 0;
+    pthread_mutex_unlock(&i2c_bus_lock[IMU_I2C_BUS]);
+    Py_END_ALLOW_THREADS
+
+    // rc_initialize_imu_dmp resets the interrupt function, so it can only
+    // be set afterwards; interrupts before that are not delivered
+    if (retval < 0) {
+        atomic_store(&imu_service.running, 0);
+        spsc_ring_free(&imu_service.ring);
+    } else {
+        rc_set_imu_interrupt_func(rcIMUInterruptFunc);
+    }
+
+    return PyLong_FromLong(retval);
+}
+
+/*
+ * Runs on the library's interrupt thread for every DMP sample.
+ */
+static int rcIMUInterruptFunc(void) {
+    const rc_imu_data_t *data = &imu_service.data;
+    imu_sample_t sample;
+    int i;
+
+    if (!atomic_load_explicit(&imu_service.running, memory_order_acquire))
+        return 0;
+
+    sample.nanos = rcNanosMonotonic();
+    for (i = 0; i < 3; i++) {
+        sample.accel[i] = data->accel[i];
+        sample.gyro[i] = data->gyro[i];
+        sample.mag[i] = imu_service.config.enable_magnetometer ? data->mag[i] : NAN;
+        sample.tait_bryan[i] = imu_service.config.enable_magnetometer ? data->fused_TaitBryan[i] : data->dmp_TaitBryan[i];
+    }
+    for (i = 0; i < 4; i++)
+        sample.quat[i] = imu_service.config.enable_magnetometer ? data->fused_quat[i] : data->dmp_quat[i];
+
+    spsc_ring_push(&imu_service.ring, &sample);
+
+    pthread_mutex_lock(&imu_service.lock);
+    imu_service.latest = sample;
+    imu_service.samples++;
+    pthread_cond_broadcast(&imu_service.cond);
+    pthread_mutex_unlock(&imu_service.lock);
+
+    return 0;
+}
+
+static void rcIMUSampleToRow(const imu_sample_t *sample, float *row) {
+    memcpy(row, sample->accel, sizeof(sample->accel));
+    memcpy(row + 3, sample->gyro, sizeof(sample->gyro));
+    memcpy(row + 6, sample->mag, sizeof(sample->mag));
+    memcpy(row + 9, sample->quat, sizeof(sample->quat));
+    memcpy(row + 13, sample->tait_bryan, sizeof(sample->tait_bryan));
+}
+
+static PyObject *rcIMUSampleObject(const imu_sample_t *sample) {
+    PyObject *result;
+
+    result = PyStructSequence_New(IMUSampleType);
+    if (result == NULL)
+        return NULL;
+
+    PyStructSequence_SET_ITEM(result, 0, PyLong_FromUnsignedLongLong((unsigned long long)sample->nanos));
+    PyStructSequence_SET_ITEM(result, 1, Py_BuildValue("(fff)", sample->accel[0], sample->accel[1], sample->accel[2]));
+    PyStructSequence_SET_ITEM(result, 2, Py_BuildValue("(fff)", sample->gyro[0], sample->gyro[1], sample->gyro[2]));
+    PyStructSequence_SET_ITEM(result, 3, Py_BuildValue("(fff)", sample->mag[0], sample->mag[1], sample->mag[2]));
+    PyStructSequence_SET_ITEM(result, 4, Py_BuildValue("(ffff)", sample->quat[0], sample->quat[1],
+                                                       sample->quat[2], sample->quat[3]));
+    PyStructSequence_SET_ITEM(result, 5, Py_BuildValue("(fff)", sample->tait_bryan[0],
+                                                       sample->tait_bryan[1], sample->tait_bryan[2]));
+
+    if (PyErr_Occurred()) {
+        Py_DECREF(result);
+        return NULL;
+    }
+
+    return result;
+}
+
+static int rcStopIMUService(void) {
+    int retval;
+
+    rcStopIMUCallbackThread();
+
+    if (!atomic_load(&imu_service.running))
+        return 0;
+
+    // Powering off joins the library's interrupt thread, so no handler
+    // is left running when the ring is freed
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&i2c_bus_lock[IMU_I2C_BUS]);
+    rc_stop_imu_interrupt_func();
+    retval = rc_power_off_imu();
+    imu_fifo.initialized = 0;
+    pthread_mutex_unlock(&i2c_bus_lock[IMU_I2C_BUS]);
+    Py_END_ALLOW_THREADS
+
+    atomic_store(&imu_service.running, 0);
+    spsc_ring_free(&imu_service.ring);
+
+    return retval;
+}
+
+static PyObject *rcPowerOffIMU(PyObject *self, PyObject *args) {
+    int retval;
+
+    if (atomic_load(&imu_service.running))
+        return PyLong_FromLong(rcStopIMUService());
+
+    rcStopIMUCallbackThread();
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&i2c_bus_lock[IMU_I2C_BUS]);
+    retval = rc_power_off_imu();
+    imu_fifo.initialized = 0;
+    imu_fifo.running = 0;
+    pthread_mutex_unlock(&i2c_bus_lock[IMU_I2C_BUS]);
+    Py_END_ALLOW_THREADS
+
+    return PyLong_FromLong(retval);
+}
+
+/*
+ * Polled read of one sensor into imu_service.data; returns a copy of
+ * vector (a member of imu_service.data) as (x, y, z).
+ */
+static PyObject *rcIMUVector(int (*read)(rc_imu_data_t *), const float *vector, const char *message) {
+    float values[3];
+    int retval;
+
+    if (atomic_load(&imu_service.running)) {
+        PyErr_SetString(PyExc_RuntimeError, "IMU is running in DMP mode, use rcGetIMUSample() or rcReadIMUSamples().");
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&i2c_bus_lock[IMU_I2C_BUS]);
+    retval = read(&imu_service.data);
+    memcpy(values, vector, sizeof(values));
+    pthread_mutex_unlock(&i2c_bus_lock[IMU_I2C_BUS]);
+    Py_END_ALLOW_THREADS
+
+    if (retval < 0) {
+        PyErr_SetString(PyExc_ValueError, message);
+        return NULL;
+    }
+
+    return Py_BuildValue("(fff)", values[0], values[1], values[2]);
+}
+
+static PyObject *rcReadAccelData(PyObject *self, PyObject *args) {
+    return rcIMUVector(rc_read_accel_data, imu_service.data.accel, "Reading accelerometer failed.");
+}
+
+static PyObject *rcReadGyroData(PyObject *self, PyObject *args) {
+    return rcIMUVector(rc_read_gyro_data, imu_service.data.gyro, "Reading gyroscope failed.");
+}
+
+static PyObject *rcReadMagData(PyObject *self, PyObject *args) {
+    return rcIMUVector(rc_read_mag_data, imu_service.data.mag, "Reading magnetometer failed.");
+}
+
+static PyObject *rcReadIMUTemp(PyObject *self, PyObject *args) {
+    float celsius;
+    int retval;
+
+    if (atomic_load(&imu_service.running)) {
+        PyErr_SetString(PyExc_RuntimeError, "IMU is running in DMP mode.");
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&i2c_bus_lock[IMU_I2C_BUS]);
+    retval = rc_read_imu_temp(&imu_service.data);
+    celsius = imu_service.data.temp;
+    pthread_mutex_unlock(&i2c_bus_lock[IMU_I2C_BUS]);
+    Py_END_ALLOW_THREADS
+
+    if (retval < 0) {
+        PyErr_SetString(PyExc_ValueError, "Reading IMU temperature failed.");
+        return NULL;
+    }
+
+    return PyFloat_FromDouble(celsius);
+}
+
+static PyObject *rcCalibrateGyroRoutine(PyObject *self, PyObject *args) {
+    int retval;
+
+    if (rcCheckI2COwner(IMU_I2C_BUS) < 0)
+        return NULL;
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&i2c_bus_lock[IMU_I2C_BUS]);
+    retval = rc_calibrate_gyro_routine();
+    pthread_mutex_unlock(&i2c_bus_lock[IMU_I2C_BUS]);
+    Py_END_ALLOW_THREADS
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcCalibrateMagRoutine(PyObject *self, PyObject *args) {
+    int retval;
+
+    if (rcCheckI2COwner(IMU_I2C_BUS) < 0)
+        return NULL;
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&i2c_bus_lock[IMU_I2C_BUS]);
+    retval = rc_calibrate_mag_routine();
+    pthread_mutex_unlock(&i2c_bus_lock[IMU_I2C_BUS]);
+    Py_END_ALLOW_THREADS
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcIsGyroCalibrated(PyObject *self, PyObject *args) {
+    int calibrated;
+
+    calibrated = rc_is_gyro_calibrated();
+
+    return PyLong_FromLong(calibrated);
+}
+
+static PyObject *rcIsMagCalibrated(PyObject *self, PyObject *args) {
+    int calibrated;
+
+    calibrated = rc_is_mag_calibrated();
+
+    return PyLong_FromLong(calibrated);
+}
+
+static PyObject *rcWasLastIMUReadSuccessful(PyObject *self, PyObject *args) {
+    int successful;
+
+    successful = rc_was_last_imu_read_successful();
+
+    return PyLong_FromLong(successful);
+}
+
+static PyObject *rcNanosSinceLastIMUInterrupt(PyObject *self, PyObject *args) {
+    uint64_t nanos;
+
+    nanos = rc_nanos_since_last_imu_interrupt();
+
+    return PyLong_FromUnsignedLongLong((unsigned long long)nanos);
+}
+
+static PyObject *rcGetIMUSample(PyObject *self, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames) {
+    static const char *const kwlist[] = {"out", NULL};
+    PyObject *out = Py_None;
+    Py_buffer buffer;
+    imu_sample_t sample;
+
+    if (rcUnpackArgs(args, nargs, kwnames, kwlist, &out) < 0) {
+        PyErr_SetString(PyExc_ValueError, "Optional writable 'f' buffer (out) expected.");
+        return NULL;
+    }
+
+    pthread_mutex_lock(&imu_service.lock);
+    sample = imu_service.latest;
+    pthread_mutex_unlock(&imu_service.lock);
+
+    if (out == Py_None) {
+        if (sample.nanos == 0)
+            Py_RETURN_NONE;
+        return rcIMUSampleObject(&sample);
+    }
+
+    if (PyObject_GetBuffer(out, &buffer, PyBUF_WRITABLE | PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) < 0) {
+        PyErr_SetString(PyExc_ValueError, "Writable contiguous buffer (out) required.");
+        return NULL;
+    }
+
+    if ((buffer.format == NULL) || (strcmp(buffer.format, "f") != 0) ||
+        (buffer.len < (Py_ssize_t)(IMU_SAMPLE_LEN * sizeof(float)))) {
+        PyBuffer_Release(&buffer);
+        PyErr_SetString(PyExc_ValueError, "Buffer (out) has to hold at least 16 float ('f') values.");
+        return NULL;
+    }
+
+    if (sample.nanos != 0)
+        rcIMUSampleToRow(&sample, (float *)buffer.buf);
+    PyBuffer_Release(&buffer);
+
+    if (sample.nanos == 0)
+        Py_RETURN_NONE;
+
+    return PyLong_FromUnsignedLongLong((unsigned long long)sample.nanos);
+}
+
+static PyObject *rcReadIMUSamples(PyObject *self, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames) {
+    static const char *const kwlist[] = {"out", "timestamps", NULL};
+    PyObject *values[2] = {NULL, Py_None};
+    Py_buffer out;
+    Py_buffer stamps;
+    const imu_sample_t *sample;
+    size_t count;
+    size_t i;
+
+    if ((rcUnpackArgs(args, nargs, kwnames, kwlist, values) < 0) || (values[0] == NULL)) {
+        PyErr_SetString(PyExc_ValueError, "Writable float buffer (out) and optional timestamp buffer required.");
+        return NULL;
+    }
+
+    if (!atomic_load(&imu_service.running)) {
+        PyErr_SetString(PyExc_RuntimeError, "IMU is not running in DMP mode.");
+        return NULL;
+    }
+
+    if (PyObject_GetBuffer(values[0], &out, PyBUF_WRITABLE | PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) < 0) {
+        PyErr_SetString(PyExc_ValueError, "Writable contiguous buffer (out) required.");
+        return NULL;
+    }
+
+    if ((out.format == NULL) || (strcmp(out.format, "f") != 0)) {
+        PyBuffer_Release(&out);
+        PyErr_SetString(PyExc_ValueError, "Buffer (out) has to hold float ('f') values.");
+        return NULL;
+    }
+
+    count = spsc_ring_available(&imu_service.ring);
+    if (count > (size_t)(out.len / (Py_ssize_t)sizeof(float) / IMU_SAMPLE_LEN))
+        count = (size_t)(out.len / (Py_ssize_t)sizeof(float) / IMU_SAMPLE_LEN);
+
+    stamps.obj = NULL;
+    if (values[1] != Py_None) {
+        if (PyObject_GetBuffer(values[1], &stamps, PyBUF_WRITABLE | PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) < 0) {
+            PyBuffer_Release(&out);
+            PyErr_SetString(PyExc_ValueError, "Writable contiguous buffer (timestamps) required.");
+            return NULL;
+        }
+        if ((stamps.itemsize != 8) || (stamps.format == NULL) ||
+            (strchr("qQ", stamps.format[strlen(stamps.format) - 1]) == NULL)) {
+            PyBuffer_Release(&stamps);
+            PyBuffer_Release(&out);
+            PyErr_SetString(PyExc_ValueError, "Buffer (timestamps) has to hold 64 bit integer ('q' or 'Q') values.");
+            return NULL;
+        }
+        if (count > (size_t)(stamps.len / 8))
+            count = (size_t)(stamps.len / 8);
+    }
+
+    for (i = 0; i < count; i++) {
+        sample = spsc_ring_peek(&imu_service.ring, i);
+        rcIMUSampleToRow(sample, (float *)out.buf + i * IMU_SAMPLE_LEN);
+        if (stamps.obj != NULL)
+            ((uint64_t *)stamps.buf)[i] = sample->nanos;
+    }
+    spsc_ring_consume(&imu_service.ring, count);
+
+    if (stamps.obj != NULL)
+        PyBuffer_Release(&stamps);
+    PyBuffer_Release(&out);
+
+    return PyLong_FromSize_t(count);
+}
+
+static void *rcIMUCallbackThread(void *arg) {
+    PyGILState_STATE gstate;
+    PyObject *callback;
+    PyObject *object;
+    PyObject *result;
+    imu_sample_t sample;
+    uint64_t samples;
+
+    pthread_mutex_lock(&imu_service.lock);
+    samples = imu_service.samples;
+    pthread_mutex_unlock(&imu_service.lock);
+
+    for (;;) {
+        pthread_mutex_lock(&imu_service.lock);
+        while ((imu_service.samples == samples) &&
+               atomic_load_explicit(&imu_service.dispatching, memory_order_acquire))
+            pthread_cond_wait(&imu_service.cond, &imu_service.lock);
+        samples = imu_service.samples;
+        sample = imu_service.latest;
+        pthread_mutex_unlock(&imu_service.lock);
+
+        if (!atomic_load_explicit(&imu_service.dispatching, memory_order_acquire))
+            break;
+
+        // Samples arriving while the callback runs are coalesced into
+        // the newest one; the ring still holds every sample
+        gstate = PyGILState_Ensure();
+
+        callback = imu_service.callback;
+        if (callback != NULL) {
+            Py_INCREF(callback);
+            object = rcIMUSampleObject(&sample);
+
+            result = (object == NULL) ? NULL : PyObject_CallFunctionObjArgs(callback, object, NULL);
+            if (result == NULL)
+                PyErr_WriteUnraisable(callback);
+
+            Py_XDECREF(result);
+            Py_XDECREF(object);
+            Py_DECREF(callback);
+        }
+
+        PyGILState_Release(gstate);
+    }
+
+    return NULL;
+}
+
+static void rcStopIMUCallbackThread(void) {
+    if (!atomic_load(&imu_service.dispatching))
+        return;
+
+    pthread_mutex_lock(&imu_service.lock);
+    atomic_store_explicit(&imu_service.dispatching, 0, memory_order_release);
+    pthread_cond_broadcast(&imu_service.cond);
+    pthread_mutex_unlock(&imu_service.lock);
+    imu_service.stopping = 1;
+
+    // The thread may be waiting for the GIL to finish a callback
+    Py_BEGIN_ALLOW_THREADS
+    pthread_join(imu_service.thread, NULL);
+    Py_END_ALLOW_THREADS
+
+    Py_CLEAR(imu_service.callback);
+    imu_service.stopping = 0;
+}
+
+static PyObject *rcSetIMUCallback(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    PyObject *previous;
+
+    if ((nargs != 1) || ((args[0] != Py_None) && !PyCallable_Check(args[0]))) {
+        PyErr_SetString(PyExc_ValueError, "Callable or None argument (callback) required.");
+        return NULL;
+    }
+
+    if (args[0] == Py_None) {
+        rcStopIMUCallbackThread();
+        return PyLong_FromLong(0);
+    }
+
+    if (imu_service.stopping) {
+        PyErr_SetString(PyExc_RuntimeError, "IMU callback is still stopping.");
+        return NULL;
+    }
+
+    // The thread only reads callback with the GIL held, so a running
+    // thread can simply be handed the new one
+    previous = imu_service.callback;
+    Py_INCREF(args[0]);
+    imu_service.callback = args[0];
+    Py_XDECREF(previous);
+
+    if (atomic_load(&imu_service.dispatching))
+        return PyLong_FromLong(0);
+
+    atomic_store(&imu_service.dispatching, 1);
+    if (pthread_create(&imu_service.thread, NULL, rcIMUCallbackThread, NULL) != 0) {
+        atomic_store(&imu_service.dispatching, 0);
+        Py_CLEAR(imu_service.callback);
+        PyErr_SetString(PyExc_RuntimeError, "Starting IMU callback thread failed.");
+        return NULL;
+    }
+
+    return PyLong_FromLong(0);
+}
+
+static PyObject *rcGetIMUServiceStatus(PyObject *self, PyObject *args) {
+    int running;
+    size_t available = 0;
+    unsigned long long overruns = 0;
+
+    running = atomic_load(&imu_service.running);
+    if (running) {
+        available = spsc_ring_available(&imu_service.ring);
+        overruns = atomic_load(&imu_service.ring.overruns);
+    }
+
+    return Py_BuildValue("(inK)", running, (Py_ssize_t)available, overruns);
+}
+
+/*
+ * Stop the FIFO and, if enable is set, restart it empty collecting
+ * accel and gyro records every divider + 1 ms. Must be called with
+ * i2c_bus_lock[IMU_I2C_BUS] held.
+ */
+static int rcIMUFIFOConfigure(int enable, int divider) {
+    uint8_t user_ctrl;
+    uint8_t status;
+
+    if ((rc_i2c_set_device_address(IMU_I2C_BUS, IMU_I2C_ADDRESS) < 0) ||
+        (rc_i2c_read_byte(IMU_I2C_BUS, MPU_USER_CTRL, &user_ctrl) < 0))
+        return -1;
+
+    user_ctrl &= (uint8_t)~MPU_USER_CTRL_FIFO_EN;
+    if ((rc_i2c_write_byte(IMU_I2C_BUS, MPU_USER_CTRL, user_ctrl) < 0) ||
+        (rc_i2c_write_byte(IMU_I2C_BUS, MPU_FIFO_EN, enable ? MPU_FIFO_ACCEL_GYRO : 0) < 0))
+        return -1;
+
+    if (!enable)
+        return 0;
+
+    // Reading INT_STATUS clears a stale overflow flag
+    if ((rc_i2c_write_byte(IMU_I2C_BUS, MPU_SMPLRT_DIV, (uint8_t)divider) < 0) ||
+        (rc_i2c_write_byte(IMU_I2C_BUS, MPU_USER_CTRL, user_ctrl | MPU_USER_CTRL_FIFO_RST) < 0) ||
+        (rc_i2c_read_byte(IMU_I2C_BUS, MPU_INT_STATUS, &status) < 0) ||
+        (rc_i2c_write_byte(IMU_I2C_BUS, MPU_USER_CTRL, user_ctrl | MPU_USER_CTRL_FIFO_EN) < 0))
+        return -1;
+
+    return 0;
+}
+
+/*
+ * Number of bytes in the FIFO. Must be called with
+ * i2c_bus_lock[IMU_I2C_BUS] held.
+ */
+static int rcIMUFIFOCount(void) {
+    uint8_t count[2];
+
+    if ((rc_i2c_set_device_address(IMU_I2C_BUS, IMU_I2C_ADDRESS) < 0) ||
+        (rc_i2c_read_bytes(IMU_I2C_BUS, MPU_FIFO_COUNTH, 2, count) < 0))
+        return -1;
+
+    return ((count[0] & 0x1f) << 8) | count[1];
+}
+
+/*
+ * Convert count FIFO records (big-endian int16 accel xyz, gyro xyz)
+ * into rows of IMU_FIFO_LEN floats in m/s² and °/s.
+ */
+static void rcDecodeIMUFIFO(const uint8_t *raw, size_t count, float accel_scale, float gyro_scale, float *out) {
+    const float scale[IMU_FIFO_LEN] = {
+        accel_scale, accel_scale, accel_scale, gyro_scale, gyro_scale, gyro_scale
+    };
+    size_t i;
+    int j;
+
+    for (i = 0; i < count; i++) {
+        for (j = 0; j < IMU_FIFO_LEN; j++)
+            out[j] = (float)(int16_t)((raw[2 * j] << 8) | raw[2 * j + 1]) * scale[j];
+        raw += IMU_FIFO_RECORD;
+        out += IMU_FIFO_LEN;
+    }
+}
+
+static PyObject *rcStartIMUFIFO(PyObject *self, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames) {
+    static const char *const kwlist[] = {"rate_hz", NULL};
+    PyObject *values[1] = {NULL};
+    int rate_hz = 1000;
+    int retval = 0;
+    int state = 0;
+
+    if ((rcUnpackArgs(args, nargs, kwnames, kwlist, values) < 0) ||
+        ((values[0] != NULL) && (rcArgToInt(values[0], &rate_hz) < 0))) {
+        PyErr_SetString(PyExc_ValueError, "Optional integer argument (sample rate in Hz) required.");
+        return NULL;
+    }
+
+    if ((rate_hz < 4) || (rate_hz > 1000) || (1000 % rate_hz != 0)) {
+        PyErr_SetString(PyExc_ValueError, "Sample rate has to be 1000 Hz divided by an integer, >= 4.");
+        return NULL;
+    }
+
+    // Without the gyro low pass filter the sample rate divider is bypassed
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&i2c_bus_lock[IMU_I2C_BUS]);
+    if (!imu_fifo.initialized)
+        state = -1;
+    else if (imu_service.config.gyro_dlpf == GYRO_DLPF_OFF)
+        state = -2;
+    else if (imu_fifo.running)
+        state = 1;
+    else {
+        retval = rcIMUFIFOConfigure(1, 1000 / rate_hz - 1);
+        if (retval == 0) {
+            imu_fifo.running = 1;
+            imu_fifo.divider = 1000 / rate_hz - 1;
+            imu_fifo.overflows = 0;
+        }
+    }
+    pthread_mutex_unlock(&i2c_bus_lock[IMU_I2C_BUS]);
+    Py_END_ALLOW_THREADS
+
+    if (state == -1) {
+        PyErr_SetString(PyExc_RuntimeError, "IMU is not initialized for polled reads.");
+        return NULL;
+    }
+
+    if (state == -2) {
+        PyErr_SetString(PyExc_RuntimeError, "IMU FIFO needs the gyro low pass filter enabled.");
+        return NULL;
+    }
+
+    if (state > 0) {
+        PyErr_SetString(PyExc_RuntimeError, "IMU FIFO is already running.");
+        return NULL;
+    }
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcStopIMUFIFO(PyObject *self, PyObject *args) {
+    int retval = 0;
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&i2c_bus_lock[IMU_I2C_BUS]);
+    if (imu_fifo.running) {
+        retval = rcIMUFIFOConfigure(0, 0);
+        imu_fifo.running = 0;
+    }
+    pthread_mutex_unlock(&i2c_bus_lock[IMU_I2C_BUS]);
+    Py_END_ALLOW_THREADS
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcReadIMUFIFO(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    Py_buffer out;
+    uint8_t raw[IMU_FIFO_SIZE];
+    uint8_t status;
+    float accel_scale;
+    float gyro_scale;
+    size_t count = 0;
+    size_t length;
+    size_t offset;
+    int retval = 0;
+    int running;
+
+    if (nargs != 1) {
+        PyErr_SetString(PyExc_ValueError, "Writable float buffer (out) required.");
+        return NULL;
+    }
+
+    if (PyObject_GetBuffer(args[0], &out, PyBUF_WRITABLE | PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) < 0) {
+        PyErr_SetString(PyExc_ValueError, "Writable contiguous buffer (out) required.");
+        return NULL;
+    }
+
+    if ((out.format == NULL) || (strcmp(out.format, "f") != 0)) {
+        PyBuffer_Release(&out);
+        PyErr_SetString(PyExc_ValueError, "Buffer (out) has to hold float ('f') values.");
+        return NULL;
+    }
+
+    // One FIFO worth of records is fetched in as few bursts as the
+    // transfer limit allows and decoded after the bus has been released
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&i2c_bus_lock[IMU_I2C_BUS]);
+    running = imu_fifo.running;
+    accel_scale = imu_service.data.accel_to_ms2;
+    gyro_scale = imu_service.data.gyro_to_degs;
+    if (running) {
+        if ((rc_i2c_set_device_address(IMU_I2C_BUS, IMU_I2C_ADDRESS) < 0) ||
+            (rc_i2c_read_byte(IMU_I2C_BUS, MPU_INT_STATUS, &status) < 0))
+            retval = -1;
+        else if (status & MPU_INT_STATUS_FIFO_OFLOW) {
+            // Records overwritten by the chip leave the stream misaligned
+            imu_fifo.overflows++;
+            retval = rcIMUFIFOConfigure(1, imu_fifo.divider);
+        } else if ((retval = rcIMUFIFOCount()) >= 0) {
+            // The count register is not trusted beyond what fits into raw
+            count = (size_t)retval / IMU_FIFO_RECORD;
+            if (count > IMU_FIFO_SIZE / IMU_FIFO_RECORD)
+                count = IMU_FIFO_SIZE / IMU_FIFO_RECORD;
+            if (count > (size_t)(out.len / (Py_ssize_t)sizeof(float) / IMU_FIFO_LEN))
+                count = (size_t)(out.len / (Py_ssize_t)sizeof(float) / IMU_FIFO_LEN);
+            for (offset = 0; (retval >= 0) && (offset < count * IMU_FIFO_RECORD); offset += length) {
+                length = count * IMU_FIFO_RECORD - offset;
+                if (length > (I2C_MAX_BYTES / IMU_FIFO_RECORD) * IMU_FIFO_RECORD)
+                    length = (I2C_MAX_BYTES / IMU_FIFO_RECORD) * IMU_FIFO_RECORD;
+                retval = rc_i2c_read_bytes(IMU_I2C_BUS, MPU_FIFO_R_W, (uint8_t)length, raw + offset);
+            }
+        }
+    }
+    pthread_mutex_unlock(&i2c_bus_lock[IMU_I2C_BUS]);
+
+    if (running && (retval >= 0))
+        rcDecodeIMUFIFO(raw, count, accel_scale, gyro_scale, (float *)out.buf);
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release(&out);
+
+    if (!running) {
+        PyErr_SetString(PyExc_RuntimeError, "IMU FIFO is not running.");
+        return NULL;
+    }
+
+    if (retval < 0) {
+        PyErr_SetString(PyExc_ValueError, "Reading IMU FIFO failed.");
+        return NULL;
+    }
+
+    return PyLong_FromSize_t(count);
+}
+
+static PyObject *rcGetIMUFIFOStatus(PyObject *self, PyObject *args) {
+    int running;
+    int available = 0;
+    unsigned long long overflows;
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&i2c_bus_lock[IMU_I2C_BUS]);
+    running = imu_fifo.running;
+    if (running)
+        available = rcIMUFIFOCount();
+    overflows = imu_fifo.overflows;
+    pthread_mutex_unlock(&i2c_bus_lock[IMU_I2C_BUS]);
+    Py_END_ALLOW_THREADS
+
+    if (available < 0) {
+        PyErr_SetString(PyExc_ValueError, "Reading IMU FIFO count failed.");
+        return NULL;
+    }
+
+    return Py_BuildValue("(inK)", running, (Py_ssize_t)(available / IMU_FIFO_RECORD), overflows);
+}
+
+static PyObject *_rcInitializeBarometer(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int retval;
+    int oversample;
+    int filter;
+    int mode = ALT_FILTER_NONE;
+    float a = 0.0;
+    float b = 0.0;
+
+    if ((nargs < 2) || (nargs > 5) ||
+        (rcArgToInt(args[0], &oversample) < 0) || (rcArgToInt(args[1], &filter) < 0) ||
+        ((nargs > 2) && (rcArgToInt(args[2], &mode) < 0)) ||
+        ((nargs > 3) && (rcArgToFloat(args[3], &a) < 0)) ||
+        ((nargs > 4) && (rcArgToFloat(args[4], &b) < 0))) {
+        PyErr_SetString(PyExc_ValueError, "Two integer arguments (oversample setting, filter setting), optionally integer (altitude filter) and two float (filter parameters) arguments required.");
+        return NULL;
+    }
+
+    if ((oversample < 4) || (oversample > 20) || (oversample % 4 != 0)) {
+        PyErr_SetString(PyExc_ValueError, "Allowed oversample values: 4, 8, 12, 16, or 20.");
+        return NULL;
+    }
+
+    if ((filter < 0) || (filter > 16) || (filter % 4 != 0)) {
+        PyErr_SetString(PyExc_ValueError, "Allowed filter values: 0, 4, 8, 12, or 16.");
+        return NULL;
+    }
+
+    if ((mode < ALT_FILTER_NONE) || (mode > ALT_FILTER_KALMAN)) {
+        PyErr_SetString(PyExc_ValueError, "Altitude filter has to be >= 0 and <= 3.");
+        return NULL;
+    }
+
+    if ((mode == ALT_FILTER_LOWPASS) && !(a > 0.0)) {
+        PyErr_SetString(PyExc_ValueError, "Low-pass time constant must be > 0.");
+        return NULL;
+    }
+
+    if ((mode == ALT_FILTER_ALPHA_BETA) && !((a > 0.0) && (a <= 1.0) && (b > 0.0) && (b < 4.0 - 2.0 * a))) {
+        PyErr_SetString(PyExc_ValueError, "Alpha has to be > 0 and <= 1, beta > 0 and < 4 - 2 * alpha.");
+        return NULL;
+    }
+
+    if ((mode == ALT_FILTER_KALMAN) && !((a > 0.0) && (b > 0.0))) {
+        PyErr_SetString(PyExc_ValueError, "Kalman noise variances must be > 0.");
+        return NULL;
+    }
+
+    // The service thread owns the filter state and oversample setting
+    if (atomic_load(&bmp_service.running) || bmp_service.stopping) {
+        PyErr_SetString(PyExc_RuntimeError, "Barometer service is running.");
+        return NULL;
+    }
+
+    if (rcCheckI2COwner(BMP_I2C_BUS) < 0)
+        return NULL;
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&i2c_bus_lock[BMP_I2C_BUS]);
+    retval = rc_initialize_barometer(oversample, filter);
+    memset(&bmp_service.filter, 0, sizeof(bmp_service.filter));
+    bmp_service.filter.mode = mode;
+    bmp_service.filter.a = a;
+    bmp_service.filter.b = b;
+    pthread_mutex_unlock(&i2c_bus_lock[BMP_I2C_BUS]);
+    Py_END_ALLOW_THREADS
+
+    if (retval == 0)
+        bmp_service.oversample = oversample;
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcPowerOffBarometer(PyObject *self, PyObject *args) {
+    int retval;
+
+    if (rcCheckI2COwner(BMP_I2C_BUS) < 0)
+        return NULL;
+
+    rcStopBarometerThread();
+    bmp_service.oversample = 0;
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&i2c_bus_lock[BMP_I2C_BUS]);
+    retval = rc_power_off_barometer();
+    pthread_mutex_unlock(&i2c_bus_lock[BMP_I2C_BUS]);
+    Py_END_ALLOW_THREADS
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcReadBarometer(PyObject *self, PyObject *args) {
+    bmp_sample_t sample;
+    int retval;
+
+    if (rcCheckI2COwner(BMP_I2C_BUS) < 0)
+        return NULL;
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&i2c_bus_lock[BMP_I2C_BUS]);
+    retval = rcBarometerSample(&sample);
+    pthread_mutex_unlock(&i2c_bus_lock[BMP_I2C_BUS]);
+    Py_END_ALLOW_THREADS
+
+    if (retval == 0) {
+        pthread_mutex_lock(&bmp_service.latest_lock);
+        bmp_service.latest = sample;
+        pthread_mutex_unlock(&bmp_service.latest_lock);
+    }
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcGetBMPTemperature(PyObject *self, PyObject *args) {
+    float celsius;
+
+    celsius = rc_bmp_get_temperature();
+
+    return PyFloat_FromDouble(celsius);
+}
+
+static PyObject *rcGetBMPPressurePa(PyObject *self, PyObject *args) {
+    float pa;
+
+    pa = rc_bmp_get_pressure_pa();
+
+    return PyFloat_FromDouble(pa);
+}
+
+static PyObject *rcGetBMPAltitudeM(PyObject *self, PyObject *args) {
+    float meters;
+
+    meters = rc_bmp_get_altitude_m();
+
+    return PyFloat_FromDouble(meters);
+}
+
+static PyObject *rcGetBMPFilteredAltitudeM(PyObject *self, PyObject *args) {
+    float meters;
+
+    pthread_mutex_lock(&bmp_service.latest_lock);
+    meters = bmp_service.latest.filtered_altitude_m;
+    pthread_mutex_unlock(&bmp_service.latest_lock);
+
+    return PyFloat_FromDouble(meters);
+}
+
+static PyObject *rcGetBMPVerticalSpeedMS(PyObject *self, PyObject *args) {
+    float speed;
+
+    pthread_mutex_lock(&bmp_service.latest_lock);
+    speed = bmp_service.latest.vertical_speed_ms;
+    pthread_mutex_unlock(&bmp_service.latest_lock);
+
+    return PyFloat_FromDouble(speed);
+}
+
+static PyObject *rcSetBMPSeaLevelPressurePa(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int retval;
+    float pa;
+
+    if ((nargs != 1) || (rcArgToFloat(args[0], &pa) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Float argument (pressure in pascal) required.");
+        return NULL;
+    }
+
+    if ((pa < 80000.0) || (pa > 120000.0)) {
+        PyErr_SetString(PyExc_ValueError, "Pressure in pascal must be >= 80,000 and <= 120,000.");
+        return NULL;
+    }
+
+    // Altitudes jump with the new reference, start the filter over
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&i2c_bus_lock[BMP_I2C_BUS]);
+    retval = rc_set_sea_level_pressure_pa(pa);
+    bmp_service.filter.primed = 0;
+    pthread_mutex_unlock(&i2c_bus_lock[BMP_I2C_BUS]);
+    Py_END_ALLOW_THREADS
+
+    return PyLong_FromLong(retval);
+}
+
+/*
+ * Feed one altitude measurement into the configured filter. dt comes
+ * from the measurement timestamps, so samples from the service thread
+ * and from rcReadBarometer can be mixed.
+ */
+static void rcAltitudeFilterStep(altitude_filter_t *filter, uint64_t nanos, float altitude) {
+    double dt;
+    double k;
+    double residual;
+    double previous;
+    double p00, p01, p11;
+    double q;
+
+    if (!filter->primed || (nanos <= filter->nanos)) {
+        if (!filter->primed) {
+            filter->altitude = altitude;
+            filter->speed = 0.0;
+            filter->p[0][0] = filter->b;
+            filter->p[0][1] = filter->p[1][0] = 0.0;
+            filter->p[1][1] = 1.0;
+            filter->nanos = nanos;
+            filter->primed = 1;
+        }
+        return;
+    }
+
+    dt = (double)(nanos - filter->nanos) * 1e-9;
+    filter->nanos = nanos;
+
+    switch (filter->mode) {
+    case ALT_FILTER_LOWPASS:
+        // First order low-pass on altitude, speed is the low-passed
+        // derivative of the filtered altitude
+        k = dt / (filter->a + dt);
+        previous = filter->altitude;
+        filter->altitude += k * (altitude - filter->altitude);
+        filter->speed += k * ((filter->altitude - previous) / dt - filter->speed);
+        break;
+
+    case ALT_FILTER_ALPHA_BETA:
+        filter->altitude += filter->speed * dt;
+        residual = altitude - filter->altitude;
+        filter->altitude += filter->a * residual;
+        filter->speed += filter->b / dt * residual;
+        break;
+
+    case ALT_FILTER_KALMAN:
+        // Constant speed model driven by white acceleration noise a,
+        // measured altitude with noise b
+        filter->altitude += filter->speed * dt;
+        q = filter->a;
+        p00 = filter->p[0][0] + dt * (2.0 * filter->p[0][1] + dt * filter->p[1][1]) + q * dt * dt * dt * dt / 4.0;
+        p01 = filter->p[0][1] + dt * filter->p[1][1] + q * dt * dt * dt / 2.0;
+        p11 = filter->p[1][1] + q * dt * dt;
+
+        residual = altitude - filter->altitude;
+        k = 1.0 / (p00 + filter->b);
+        filter->altitude += p00 * k * residual;
+        filter->speed += p01 * k * residual;
+
+        filter->p[0][0] = p00 - p00 * p00 * k;
+        filter->p[0][1] = filter->p[1][0] = p01 - p00 * p01 * k;
+        filter->p[1][1] = p11 - p01 * p01 * k;
+        break;
+
+    default:
+        filter->altitude = altitude;
+        break;
+    }
+}
+
+/*
+ * Read the barometer into sample and run the altitude filter. Caller
+ * holds i2c_bus_lock[BMP_I2C_BUS]. Returns the rc_read_barometer result.
+ */
+static int rcBarometerSample(bmp_sample_t *sample) {
+    int retval;
+
+    sample->nanos = rcNanosMonotonic();
+    retval = rc_read_barometer();
+    if (retval != 0)
+        return retval;
+
+    sample->temperature = rc_bmp_get_temperature();
+    sample->pressure_pa = rc_bmp_get_pressure_pa();
+    sample->altitude_m = rc_bmp_get_altitude_m();
+
+    rcAltitudeFilterStep(&bmp_service.filter, sample->nanos, sample->altitude_m);
+    sample->filtered_altitude_m = (float)bmp_service.filter.altitude;
+    sample->vertical_speed_ms = (bmp_service.filter.mode == ALT_FILTER_NONE) ? NAN : (float)bmp_service.filter.speed;
+
+    return 0;
+}
+
+static void *rcBarometerThread(void *arg) {
+    bmp_sample_t sample;
+    uint64_t next;
+    uint64_t now;
+    int retval;
+
+    next = rcNanosMonotonic();
+
+    while (atomic_load_explicit(&bmp_service.running, memory_order_acquire)) {
+        pthread_mutex_lock(&i2c_bus_lock[BMP_I2C_BUS]);
+        retval = rcBarometerSample(&sample);
+        pthread_mutex_unlock(&i2c_bus_lock[BMP_I2C_BUS]);
+
+        if (retval == 0) {
+            spsc_ring_push(&bmp_service.ring, &sample);
+
+            pthread_mutex_lock(&bmp_service.latest_lock);
+            bmp_service.latest = sample;
+            pthread_mutex_unlock(&bmp_service.latest_lock);
+        }
+
+        next += bmp_service.period_ns;
+        now = rcNanosMonotonic();
+        while (next <= now)
+            next += bmp_service.period_ns;
+
+        rcSleepUntil(next);
+    }
+
+    return NULL;
+}
+
+static void rcStopBarometerThread(void) {
+    if (!atomic_load(&bmp_service.running))
+        return;
+
+    atomic_store_explicit(&bmp_service.running, 0, memory_order_release);
+    bmp_service.stopping = 1;
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_join(bmp_service.thread, NULL);
+    Py_END_ALLOW_THREADS
+
+    spsc_ring_free(&bmp_service.ring);
+    bmp_service.stopping = 0;
+}
+
+static PyObject *rcStartBarometerService(PyObject *self, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames) {
+    static const char *const kwlist[] = {"capacity", NULL};
+    // BMP280 update rates for oversample settings 4, 8, 12, 16, 20
+    static const float rates_hz[] = {182.0, 133.0, 87.0, 51.0, 28.0};
+    PyObject *values[1] = {NULL};
+    int capacity = 256;
+
+    if ((rcUnpackArgs(args, nargs, kwnames, kwlist, values) < 0) ||
+        ((values[0] != NULL) && (rcArgToInt(values[0], &capacity) < 0))) {
+        PyErr_SetString(PyExc_ValueError, "Optional integer argument (capacity in samples) required.");
+        return NULL;
+    }
+
+    if (capacity < 1) {
+        PyErr_SetString(PyExc_ValueError, "Capacity must be > 0.");
+        return NULL;
+    }
+
+    if (bmp_service.oversample == 0) {
+        PyErr_SetString(PyExc_RuntimeError, "Barometer is not initialized.");
+        return NULL;
+    }
+
+    if (atomic_load(&bmp_service.running)) {
+        PyErr_SetString(PyExc_RuntimeError, "Barometer service is already running.");
+        return NULL;
+    }
+
+    if (bmp_service.stopping) {
+        PyErr_SetString(PyExc_RuntimeError, "Barometer service is still stopping.");
+        return NULL;
+    }
+
+    if (rcCheckI2COwner(BMP_I2C_BUS) < 0)
+        return NULL;
+
+    if (spsc_ring_alloc(&bmp_service.ring, sizeof(bmp_sample_t), (size_t)capacity) < 0)
+        return PyErr_NoMemory();
+
+    bmp_service.period_ns = (uint64_t)(1e9 / rates_hz[bmp_service.oversample / 4 - 1]);
+    atomic_store(&bmp_service.running, 1);
+
+    if (pthread_create(&bmp_service.thread, NULL, rcBarometerThread, NULL) != 0) {
+        atomic_store(&bmp_service.running, 0);
+        spsc_ring_free(&bmp_service.ring);
+        PyErr_SetString(PyExc_RuntimeError, "Starting barometer service thread failed.");
+        return NULL;
+    }
+
+    return PyLong_FromLong(0);
+}
+
+static PyObject *rcStopBarometerService(PyObject *self, PyObject *args) {
+    rcStopBarometerThread();
+
+    return PyLong_FromLong(0);
+}
+
+static PyObject *rcGetBarometerSample(PyObject *self, PyObject *args) {
+    bmp_sample_t sample;
+
+    pthread_mutex_lock(&bmp_service.latest_lock);
+    sample = bmp_service.latest;
+    pthread_mutex_unlock(&bmp_service.latest_lock);
+
+    if (sample.nanos == 0)
+        Py_RETURN_NONE;
+
+    return Py_BuildValue("(Kfffff)", (unsigned long long)sample.nanos,
+                         sample.temperature, sample.pressure_pa, sample.altitude_m,
+                         sample.filtered_altitude_m, sample.vertical_speed_ms);
+}
+
+static PyObject *rcReadBarometerSamples(PyObject *self, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames) {
+    static const char *const kwlist[] = {"out", "timestamps", NULL};
+    PyObject *values[2] = {NULL, Py_None};
+    Py_buffer out;
+    Py_buffer stamps;
+    const bmp_sample_t *sample;
+    float *row;
+    size_t count;
+    size_t i;
+
+    if ((rcUnpackArgs(args, nargs, kwnames, kwlist, values) < 0) || (values[0] == NULL)) {
+        PyErr_SetString(PyExc_ValueError, "Writable float buffer (out) and optional timestamp buffer required.");
+        return NULL;
+    }
+
+    if (!atomic_load(&bmp_service.running)) {
+        PyErr_SetString(PyExc_RuntimeError, "Barometer service is not running.");
+        return NULL;
+    }
+
+    if (PyObject_GetBuffer(values[0], &out, PyBUF_WRITABLE | PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) < 0) {
+        PyErr_SetString(PyExc_ValueError, "Writable contiguous buffer (out) required.");
+        return NULL;
+    }
+
+    if ((out.format == NULL) || (strcmp(out.format, "f") != 0)) {
+        PyBuffer_Release(&out);
+        PyErr_SetString(PyExc_ValueError, "Buffer (out) has to hold float ('f') values.");
+        return NULL;
+    }
+
+    count = spsc_ring_available(&bmp_service.ring);
+    if (count > (size_t)(out.len / (Py_ssize_t)sizeof(float) / BMP_SAMPLE_LEN))
+        count = (size_t)(out.len / (Py_ssize_t)sizeof(float) / BMP_SAMPLE_LEN);
+
+    stamps.obj = NULL;
+    if (values[1] != Py_None) {
+        if (PyObject_GetBuffer(values[1], &stamps, PyBUF_WRITABLE | PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) < 0) {
+            PyBuffer_Release(&out);
+            PyErr_SetString(PyExc_ValueError, "Writable contiguous buffer (timestamps) required.");
+            return NULL;
+        }
+        if ((stamps.itemsize != 8) || (stamps.format == NULL) ||
+            (strchr("qQ", stamps.format[strlen(stamps.format) - 1]) == NULL)) {
+            PyBuffer_Release(&stamps);
+            PyBuffer_Release(&out);
+            PyErr_SetString(PyExc_ValueError, "Buffer (timestamps) has to hold 64 bit integer ('q' or 'Q') values.");
+            return NULL;
+        }
+        if (count > (size_t)(stamps.len / 8))
+            count = (size_t)(stamps.len / 8);
+    }
+
+    for (i = 0; i < count; i++) {
+        sample = spsc_ring_peek(&bmp_service.ring, i);
+        row = (float *)out.buf + i * BMP_SAMPLE_LEN;
+        row[0] = sample->temperature;
+        row[1] = sample->pressure_pa;
+        row[2] = sample->altitude_m;
+        row[3] = sample->filtered_altitude_m;
+        row[4] = sample->vertical_speed_ms;
+        if (stamps.obj != NULL)
+            ((uint64_t *)stamps.buf)[i] = sample->nanos;
+    }
+    spsc_ring_consume(&bmp_service.ring, count);
+
+    if (stamps.obj != NULL)
+        PyBuffer_Release(&stamps);
+    PyBuffer_Release(&out);
+
+    return PyLong_FromSize_t(count);
+}
+
+static PyObject *rcGetBarometerServiceStatus(PyObject *self, PyObject *args) {
+    int running;
+    size_t available = 0;
+    unsigned long long overruns = 0;
+
+    running = atomic_load(&bmp_service.running);
+    if (running) {
+        available = spsc_ring_available(&bmp_service.ring);
+        overruns = atomic_load(&bmp_service.ring.overruns);
+    }
+
+    return Py_BuildValue("(inK)", running, (Py_ssize_t)available, overruns);
+}
+
+/*
+ * Checks that bus is not in use by the IMU in DMP mode, setting a
+ * RuntimeError and returning -1 otherwise. The library's interrupt
+ * thread reads the IMU without i2c_bus_lock, so no other transfer on
+ * its bus is safe meanwhile.
+ */
+static int rcCheckI2COwner(int bus) {
+    if (atomic_load(&imu_service.running) && (bus == IMU_I2C_BUS)) {
+        PyErr_SetString(PyExc_RuntimeError, "I²C bus is in use by the IMU in DMP mode.");
+        return -1;
+    }
+
+    return 0;
+}
+
+static PyObject *rcInitializeI2C(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int retval;
+    int bus;
+    int address;
+
+    if ((nargs != 2) || (rcArgToInt(args[0], &bus) < 0) ||
+        (rcArgToInt(args[1], &address) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Two integer arguments (bus number, device address) required.");
+        return NULL;
+    }
+
+    if ((bus < 1) || (bus > 2)) {
+        PyErr_SetString(PyExc_ValueError, "Bus number must be 1 or 2.");
+        return NULL;
+    }
+
+    if (rcCheckI2COwner(bus) < 0)
+        return NULL;
+
+    if ((address < 0x03) || (address > 0x77)) {
+        PyErr_SetString(PyExc_ValueError, "Device address must be >= 0x03 and <= 0x77.");
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&i2c_bus_lock[bus]);
+    retval = rc_i2c_init(bus, (uint8_t)address);
+    pthread_mutex_unlock(&i2c_bus_lock[bus]);
+    Py_END_ALLOW_THREADS
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcCloseI2C(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int retval;
+    int bus;
+
+    if ((nargs != 1) || (rcArgToInt(args[0], &bus) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Integer argument (bus number) required.");
+        return NULL;
+    }
+
+    if ((bus < 1) || (bus > 2)) {
+        PyErr_SetString(PyExc_ValueError, "Bus number must be 1 or 2.");
+        return NULL;
+    }
+
+    if (rcCheckI2COwner(bus) < 0)
+        return NULL;
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&i2c_bus_lock[bus]);
+    retval = rc_i2c_close(bus);
+    pthread_mutex_unlock(&i2c_bus_lock[bus]);
+    Py_END_ALLOW_THREADS
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcSetI2CDeviceAddress(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int retval;
+    int bus;
+    int address;
+
+    if ((nargs != 2) || (rcArgToInt(args[0], &bus) < 0) ||
+        (rcArgToInt(args[1], &address) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Two integer arguments (bus number, device address) required.");
+        return NULL;
+    }
+
+    if ((bus < 1) || (bus > 2)) {
+        PyErr_SetString(PyExc_ValueError, "Bus number must be 1 or 2.");
+        return NULL;
+    }
+
+    if (rcCheckI2COwner(bus) < 0)
+        return NULL;
+
+    if ((address < 0x03) || (address > 0x77)) {
+        PyErr_SetString(PyExc_ValueError, "Device address must be >= 0x03 and <= 0x77.");
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&i2c_bus_lock[bus]);
+    retval = rc_i2c_set_device_address(bus, (uint8_t)address);
+    pthread_mutex_unlock(&i2c_bus_lock[bus]);
+    Py_END_ALLOW_THREADS
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcClaimI2CBus(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int retval;
+    int bus;
+
+    if ((nargs != 1) || (rcArgToInt(args[0], &bus) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Integer argument (bus number) required.");
+        return NULL;
+    }
+
+    if ((bus < 1) || (bus > 2)) {
+        PyErr_SetString(PyExc_ValueError, "Bus number must be 1 or 2.");
+        return NULL;
+    }
+
+    retval = rc_i2c_claim_bus(bus);
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcReleaseI2CBus(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int retval;
+    int bus;
+
+    if ((nargs != 1) || (rcArgToInt(args[0], &bus) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Integer argument (bus number) required.");
+        return NULL;
+    }
+
+    if ((bus < 1) || (bus > 2)) {
+        PyErr_SetString(PyExc_ValueError, "Bus number must be 1 or 2.");
+        return NULL;
+    }
+
+    retval = rc_i2c_release_bus(bus);
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcGetI2CBusInUse(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int state;
+    int bus;
+
+    if ((nargs != 1) || (rcArgToInt(args[0], &bus) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Integer argument (bus number) required.");
+        return NULL;
+    }
+
+    if ((bus < 1) || (bus > 2)) {
+        PyErr_SetString(PyExc_ValueError, "Bus number must be 1 or 2.");
+        return NULL;
+    }
+
+    state = rc_i2c_get_in_use_state(bus);
+
+    return PyLong_FromLong(state);
+}
+
+static PyObject *rcReadI2CByte(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int retval;
+    int bus;
+    int address;
+    uint8_t data;
+
+    if ((nargs != 2) || (rcArgToInt(args[0], &bus) < 0) ||
+        (rcArgToInt(args[1], &address) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Two integer arguments (bus number, register address) required.");
+        return NULL;
+    }
+
+    if ((bus < 1) || (bus > 2)) {
+        PyErr_SetString(PyExc_ValueError, "Bus number must be 1 or 2.");
+        return NULL;
+    }
+
+    if (rcCheckI2COwner(bus) < 0)
+        return NULL;
+
+    if ((address < 0x00) || (address > 0xff)) {
+        PyErr_SetString(PyExc_ValueError, "Register address must be >= 0x00 and <= 0xff.");
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&i2c_bus_lock[bus]);
+    retval = rc_i2c_read_byte(bus, (uint8_t)address, &data);
+    pthread_mutex_unlock(&i2c_bus_lock[bus]);
+    Py_END_ALLOW_THREADS
+
+    if (retval < 0) {
+        PyErr_SetString(PyExc_ValueError, "Reading one byte from I²C device failed.");
+        return NULL;
+    }
+
+    return PyLong_FromLong(data);
+}
+
+static PyObject *rcReadI2CBytes(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int retval;
+    int bus;
+    int address;
+    int length;
+    PyObject *result = NULL;
+    Py_buffer data;
+
+    if ((nargs != 3) || (rcArgToInt(args[0], &bus) < 0) ||
+        (rcArgToInt(args[1], &address) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Two integer arguments (bus number, register address) and data length or writable buffer required.");
+        return NULL;
+    }
+
+    if ((bus < 1) || (bus > 2)) {
+        PyErr_SetString(PyExc_ValueError, "Bus number must be 1 or 2.");
+        return NULL;
+    }
+
+    if (rcCheckI2COwner(bus) < 0)
+        return NULL;
+
+    if ((address < 0x00) || (address > 0xff)) {
+        PyErr_SetString(PyExc_ValueError, "Register address must be >= 0x00 and <= 0xff.");
+        return NULL;
+    }
+
+    // Either read into a new bytes object of the given length, or
+    // straight into the memory of a caller supplied writable buffer
+    if (PyLong_Check(args[2])) {
+        if (rcArgToInt(args[2], &length) < 0) {
+            PyErr_SetString(PyExc_ValueError, "Data length must be an integer.");
+            return NULL;
+        }
+        if ((length < 1) || (length > I2C_MAX_BYTES)) {
+            PyErr_Format(PyExc_ValueError, "Data length must be > 0 and <= %d.", I2C_MAX_BYTES);
+            return NULL;
+        }
+        result = PyBytes_FromStringAndSize(NULL, length);
+        if (result == NULL)
+            return NULL;
+        if (PyObject_GetBuffer(result, &data, PyBUF_SIMPLE) < 0) {
+            Py_DECREF(result);
+            return NULL;
+        }
+    } else {
+        if (PyObject_GetBuffer(args[2], &data, PyBUF_WRITABLE | PyBUF_C_CONTIGUOUS) < 0) {
+            PyErr_SetString(PyExc_ValueError, "Data length or writable contiguous buffer required.");
+            return NULL;
+        }
+        length = (int)data.len;
+        if ((data.len < 1) || (data.len > I2C_MAX_BYTES)) {
+            PyBuffer_Release(&data);
+            PyErr_Format(PyExc_ValueError, "Buffer size must be > 0 and <= %d bytes.", I2C_MAX_BYTES);
+            return NULL;
+        }
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&i2c_bus_lock[bus]);
+    retval = rc_i2c_read_bytes(bus, (uint8_t)address, (uint8_t)length, (uint8_t *)data.buf);
+    pthread_mutex_unlock(&i2c_bus_lock[bus]);
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release(&data);
+
+    if (retval < 0) {
+        Py_XDECREF(result);
+        PyErr_SetString(PyExc_ValueError, "Reading several bytes from I²C device failed.");
+        return NULL;
+    }
+
+    if (result != NULL)
+        return result;
+
+    return PyLong_FromLong(length);
+}
+
+static PyObject *rcReadI2CWord(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int retval;
+    int bus;
+    int address;
+    uint16_t data;
+
+    if ((nargs != 2) || (rcArgToInt(args[0], &bus) < 0) ||
+        (rcArgToInt(args[1], &address) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Two integer arguments (bus number, register address) required.");
+        return NULL;
+    }
+
+    if ((bus < 1) || (bus > 2)) {
+        PyErr_SetString(PyExc_ValueError, "Bus number must be 1 or 2.");
+        return NULL;
+    }
+
+    if (rcCheckI2COwner(bus) < 0)
+        return NULL;
+
+    if ((address < 0x00) || (address > 0xff)) {
+        PyErr_SetString(PyExc_ValueError, "Register address must be >= 0x00 and <= 0xff.");
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&i2c_bus_lock[bus]);
+    retval = rc_i2c_read_word(bus, (uint8_t)address, &data);
+    pthread_mutex_unlock(&i2c_bus_lock[bus]);
+    Py_END_ALLOW_THREADS
+
+    if (retval < 0) {
+        PyErr_SetString(PyExc_ValueError, "Reading one word from I²C device failed.");
+        return NULL;
+    }
+
+    return PyLong_FromLong(data);
+}
+
+static PyObject *rcReadI2CWords(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int retval;
+    int bus;
+    int address;
+    int length;
+    int i;
+    uint16_t words[I2C_MAX_BYTES / 2];
+    uint16_t *data = words;
+    PyObject *result;
+    PyObject *item;
+    Py_buffer view;
+
+    if ((nargs != 3) || (rcArgToInt(args[0], &bus) < 0) ||
+        (rcArgToInt(args[1], &address) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Two integer arguments (bus number, register address) and word count or writable buffer required.");
+        return NULL;
+    }
+
+    if ((bus < 1) || (bus > 2)) {
+        PyErr_SetString(PyExc_ValueError, "Bus number must be 1 or 2.");
+        return NULL;
+    }
+
+    if (rcCheckI2COwner(bus) < 0)
+        return NULL;
+
+    if ((address < 0x00) || (address > 0xff)) {
+        PyErr_SetString(PyExc_ValueError, "Register address must be >= 0x00 and <= 0xff.");
+        return NULL;
+    }
+
+    view.obj = NULL;
+    if (PyLong_Check(args[2])) {
+        if (rcArgToInt(args[2], &length) < 0) {
+            PyErr_SetString(PyExc_ValueError, "Word count must be an integer.");
+            return NULL;
+        }
+    } else {
+        // Words are converted from the bus' big endian byte order to host
+        // order by the library, so the buffer must hold 16 bit integers
+        if (PyObject_GetBuffer(args[2], &view, PyBUF_WRITABLE | PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) < 0) {
+            PyErr_SetString(PyExc_ValueError, "Word count or writable contiguous buffer required.");
+            return NULL;
+        }
+        if ((view.itemsize != 2) || (view.format == NULL) ||
+            (strchr("Hh", view.format[strlen(view.format) - 1]) == NULL)) {
+            PyBuffer_Release(&view);
+            PyErr_SetString(PyExc_ValueError, "Buffer has to hold 16 bit integer ('H' or 'h') values.");
+            return NULL;
+        }
+        length = (int)(view.len / 2);
+        data = (uint16_t *)view.buf;
+    }
+
+    if ((length < 1) || (length > I2C_MAX_BYTES / 2)) {
+        if (view.obj != NULL)
+            PyBuffer_Release(&view);
+        PyErr_Format(PyExc_ValueError, "Word count must be > 0 and <= %d.", I2C_MAX_BYTES / 2);
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&i2c_bus_lock[bus]);
+    retval = rc_i2c_read_words(bus, (uint8_t)address, (uint8_t)length, data);
+    pthread_mutex_unlock(&i2c_bus_lock[bus]);
+    Py_END_ALLOW_THREADS
+
+    if (view.obj != NULL)
+        PyBuffer_Release(&view);
+
+    if (retval < 0) {
+        PyErr_SetString(PyExc_ValueError, "Reading several words from I²C device failed.");
+        return NULL;
+    }
+
+    if (data != words)
+        return PyLong_FromLong(length);
+
+    result = PyTuple_New(length);
+    if (result == NULL)
+        return NULL;
+
+    for (i = 0; i < length; i++) {
+        item = PyLong_FromLong(words[i]);
+        if (item == NULL) {
+            Py_DECREF(result);
+            return NULL;
+        }
+        PyTuple_SET_ITEM(result, i, item);
+    }
+
+    return result;
+}
+
+static PyObject *rcReadI2CBit(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int retval;
+    int bus;
+    int address;
+    int bitnum;
+    uint8_t data;
+
+    if ((nargs != 3) || (rcArgToInt(args[0], &bus) < 0) ||
+        (rcArgToInt(args[1], &address) < 0) || (rcArgToInt(args[2], &bitnum) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Three integer arguments (bus number, register address, bit number) required.");
+        return NULL;
+    }
+
+    if ((bus < 1) || (bus > 2)) {
+        PyErr_SetString(PyExc_ValueError, "Bus number must be 1 or 2.");
+        return NULL;
+    }
+
+    if (rcCheckI2COwner(bus) < 0)
+        return NULL;
+
+    if ((address < 0x00) || (address > 0xff)) {
+        PyErr_SetString(PyExc_ValueError, "Register address must be >= 0x00 and <= 0xff.");
+        return NULL;
+    }
+
+    if ((bitnum < 0) || (bitnum > 15)) {
+        PyErr_SetString(PyExc_ValueError, "Bit number must be >= 0 and <= 15.");
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&i2c_bus_lock[bus]);
+    retval = rc_i2c_read_bit(bus, (uint8_t)address, (uint8_t)bitnum, &data);
+    pthread_mutex_unlock(&i2c_bus_lock[bus]);
+    Py_END_ALLOW_THREADS
+
+    if (retval < 0) {
+        PyErr_SetString(PyExc_ValueError, "Reading one bit from I²C device failed.");
+        return NULL;
+    }
+
+    return PyLong_FromLong(data);
+}
+
+static PyObject *rcWriteI2CByte(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int retval;
+    int bus;
+    int address;
+    int data;
+
+    if ((nargs != 3) || (rcArgToInt(args[0], &bus) < 0) ||
+        (rcArgToInt(args[1], &address) < 0) || (rcArgToInt(args[2], &data) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Three integer arguments (bus number, register address, data byte) required.");
+        return NULL;
+    }
+
+    if ((bus < 1) || (bus > 2)) {
+        PyErr_SetString(PyExc_ValueError, "Bus number must be 1 or 2.");
+        return NULL;
+    }
+
+    if (rcCheckI2COwner(bus) < 0)
+        return NULL;
+
+    if ((address < 0x00) || (address > 0xff)) {
+        PyErr_SetString(PyExc_ValueError, "Register address must be >= 0x00 and <= 0xff.");
+        return NULL;
+    }
+
+    if ((data < 0x00) || (data > 0xff)) {
+        PyErr_SetString(PyExc_ValueError, "Data byte must be >= 0x00 and <= 0xff.");
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&i2c_bus_lock[bus]);
+    retval = rc_i2c_write_byte(bus, (uint8_t)address, (uint8_t)data);
+    pthread_mutex_unlock(&i2c_bus_lock[bus]);
+    Py_END_ALLOW_THREADS
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcWriteI2CBytes(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int retval;
+    int bus;
+    int address;
+    Py_buffer data;
+
+    if ((nargs != 3) || (rcArgToInt(args[0], &bus) < 0) ||
+        (rcArgToInt(args[1], &address) < 0) ||
+        (PyObject_GetBuffer(args[2], &data, PyBUF_C_CONTIGUOUS) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Two integer arguments (bus number, register address) and bytes-like data required.");
+        return NULL;
+    }
+
+    if ((bus < 1) || (bus > 2)) {
+        PyBuffer_Release(&data);
+        PyErr_SetString(PyExc_ValueError, "Bus number must be 1 or 2.");
+        return NULL;
+    }
+
+    if (rcCheckI2COwner(bus) < 0) {
+        PyBuffer_Release(&data);
+        return NULL;
+    }
+
+    if ((address < 0x00) || (address > 0xff)) {
+        PyBuffer_Release(&data);
+        PyErr_SetString(PyExc_ValueError, "Register address must be >= 0x00 and <= 0xff.");
+        return NULL;
+    }
+
+    if ((data.len < 1) || (data.len > I2C_MAX_BYTES)) {
+        PyBuffer_Release(&data);
+        PyErr_Format(PyExc_ValueError, "Data size must be > 0 and <= %d bytes.", I2C_MAX_BYTES);
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&i2c_bus_lock[bus]);
+    retval = rc_i2c_write_bytes(bus, (uint8_t)address, (uint8_t)data.len, (uint8_t *)data.buf);
+    pthread_mutex_unlock(&i2c_bus_lock[bus]);
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release(&data);
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcWriteI2CWord(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int retval;
+    int bus;
+    int address;
+    int data;
+
+    if ((nargs != 3) || (rcArgToInt(args[0], &bus) < 0) ||
+        (rcArgToInt(args[1], &address) < 0) || (rcArgToInt(args[2], &data) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Three integer arguments (bus number, register address, data word) required.");
+        return NULL;
+    }
+
+    if ((bus < 1) || (bus > 2)) {
+        PyErr_SetString(PyExc_ValueError, "Bus number must be 1 or 2.");
+        return NULL;
+    }
+
+    if (rcCheckI2COwner(bus) < 0)
+        return NULL;
+
+    if ((address < 0x00) || (address > 0xff)) {
+        PyErr_SetString(PyExc_ValueError, "Register address must be >= 0x00 and <= 0xff.");
+        return NULL;
+    }
+
+    if ((data < 0x0000) || (data > 0xffff)) {
+        PyErr_SetString(PyExc_ValueError, "Data word must be >= 0x0000 and <= 0xffff.");
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&i2c_bus_lock[bus]);
+    retval = rc_i2c_write_word(bus, (uint8_t)address, (uint16_t)data);
+    pthread_mutex_unlock(&i2c_bus_lock[bus]);
+    Py_END_ALLOW_THREADS
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcWriteI2CWords(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int retval;
+    int bus;
+    int address;
+    Py_buffer data;
+
+    if ((nargs != 3) || (rcArgToInt(args[0], &bus) < 0) ||
+        (rcArgToInt(args[1], &address) < 0) ||
+        (PyObject_GetBuffer(args[2], &data, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Two integer arguments (bus number, register address) and a buffer of 16 bit words required.");
+        return NULL;
+    }
+
+    if ((bus < 1) || (bus > 2)) {
+        PyBuffer_Release(&data);
+        PyErr_SetString(PyExc_ValueError, "Bus number must be 1 or 2.");
+        return NULL;
+    }
+
+    if (rcCheckI2COwner(bus) < 0) {
+        PyBuffer_Release(&data);
+        return NULL;
+    }
+
+    if ((address < 0x00) || (address > 0xff)) {
+        PyBuffer_Release(&data);
+        PyErr_SetString(PyExc_ValueError, "Register address must be >= 0x00 and <= 0xff.");
+        return NULL;
+    }
+
+    // Words are passed in host order, the library sends them big endian
+    if ((data.itemsize != 2) || (data.format == NULL) ||
+        (strchr("Hh", data.format[strlen(data.format) - 1]) == NULL)) {
+        PyBuffer_Release(&data);
+        PyErr_SetString(PyExc_ValueError, "Buffer has to hold 16 bit integer ('H' or 'h') values.");
+        return NULL;
+    }
+
+    if ((data.len < 2) || (data.len > I2C_MAX_BYTES)) {
+        PyBuffer_Release(&data);
+        PyErr_Format(PyExc_ValueError, "Word count must be > 0 and <= %d.", I2C_MAX_BYTES / 2);
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&i2c_bus_lock[bus]);
+    retval = rc_i2c_write_words(bus, (uint8_t)address, (uint8_t)(data.len / 2), (uint16_t *)data.buf);
+    pthread_mutex_unlock(&i2c_bus_lock[bus]);
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release(&data);
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcWriteI2CBit(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int retval;
+    int bus;
+    int address;
+    int bitnum;
+    int data;
+
+    if ((nargs != 4) || (rcArgToInt(args[0], &bus) < 0) ||
+        (rcArgToInt(args[1], &address) < 0) || (rcArgToInt(args[2], &bitnum) < 0) ||
+        (rcArgToInt(args[3], &data) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Four integer arguments (bus number, register address, bit number, bit value) required.");
+        return NULL;
+    }
+
+    if ((bus < 1) || (bus > 2)) {
+        PyErr_SetString(PyExc_ValueError, "Bus number must be 1 or 2.");
+        return NULL;
+    }
+
+    if (rcCheckI2COwner(bus) < 0)
+        return NULL;
+
+    if ((address < 0x00) || (address > 0xff)) {
+        PyErr_SetString(PyExc_ValueError, "Register address must be >= 0x00 and <= 0xff.");
+        return NULL;
+    }
+
+    if ((bitnum < 0) || (bitnum > 7)) {
+        PyErr_SetString(PyExc_ValueError, "Bit number must be >= 0 and <= 7.");
+        return NULL;
+    }
+
+    if ((data < 0) || (data > 1)) {
+        PyErr_SetString(PyExc_ValueError, "Bit value must be 0 or 1.");
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&i2c_bus_lock[bus]);
+    retval = rc_i2c_write_bit(bus, (uint8_t)address, (uint8_t)bitnum, (uint8_t)data);
+    pthread_mutex_unlock(&i2c_bus_lock[bus]);
+    Py_END_ALLOW_THREADS
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcSendI2CByte(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int retval;
+    int bus;
+    int data;
+
+    if ((nargs != 2) || (rcArgToInt(args[0], &bus) < 0) ||
+        (rcArgToInt(args[1], &data) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Two integer arguments (bus number, data byte) required.");
+        return NULL;
+    }
+
+    if ((bus < 1) || (bus > 2)) {
+        PyErr_SetString(PyExc_ValueError, "Bus number must be 1 or 2.");
+        return NULL;
+    }
+
+    if (rcCheckI2COwner(bus) < 0)
+        return NULL;
+
+    if ((data < 0x00) || (data > 0xff)) {
+        PyErr_SetString(PyExc_ValueError, "Data byte must be >= 0x00 and <= 0xff.");
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&i2c_bus_lock[bus]);
+    retval = rc_i2c_send_byte(bus, (uint8_t)data);
+    pthread_mutex_unlock(&i2c_bus_lock[bus]);
+    Py_END_ALLOW_THREADS
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcSendI2CBytes(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int retval;
+    int bus;
+    int length;
+    Py_buffer data;
+
+    if ((nargs != 3) || (rcArgToInt(args[0], &bus) < 0) ||
+        (rcArgToInt(args[1], &length) < 0) ||
+        (PyObject_GetBuffer(args[2], &data, PyBUF_SIMPLE) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Three arguments (bus number, data length, data bytes) required.");
+        return NULL;
+    }
+
+    if ((bus < 1) || (bus > 2)) {
+        PyBuffer_Release(&data);
+        PyErr_SetString(PyExc_ValueError, "Bus number must be 1 or 2.");
+        return NULL;
+    }
+
+    if (rcCheckI2COwner(bus) < 0) {
+        PyBuffer_Release(&data);
+        return NULL;
+    }
+
+    if ((length < 1) || (length > 255) || (length > data.len)) {
+        PyBuffer_Release(&data);
+        PyErr_SetString(PyExc_ValueError, "Data length must be > 0, <= 255 and must not exceed the data size.");
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&i2c_bus_lock[bus]);
+    retval = rc_i2c_send_bytes(bus, (uint8_t)length, (uint8_t *)data.buf);
+    pthread_mutex_unlock(&i2c_bus_lock[bus]);
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release(&data);
+
+    return PyLong_FromLong(retval);
+}
+
+
+/*
+ * Checks slave, setting a ValueError and returning -1 if it is invalid.
+ */
+static int rcCheckSPISlave(int slave) {
+    if ((slave < 1) || (slave > SPI_SLAVES)) {
+        PyErr_Format(PyExc_ValueError, "Slave must be >= 1 and <= %d.", SPI_SLAVES);
+        return -1;
+    }
+
+    return 0;
+}
+
+static PyObject *rcInitializeSPI(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int retval;
+    int ss_mode;
+    int spi_mode;
+    int speed_hz;
+    int slave;
+
+    if ((nargs != 4) || (rcArgToInt(args[0], &ss_mode) < 0) ||
+        (rcArgToInt(args[1], &spi_mode) < 0) || (rcArgToInt(args[2], &speed_hz) < 0) ||
+        (rcArgToInt(args[3], &slave) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Four integer arguments (slave select mode, SPI mode, speed in Hz, slave) required.");
+        return NULL;
+    }
+
+    if ((ss_mode != SS_MODE_AUTO) && (ss_mode != SS_MODE_MANUAL)) {
+        PyErr_SetString(PyExc_ValueError, "Slave select mode must be 0 (auto) or 1 (manual).");
+        return NULL;
+    }
+
+    if ((spi_mode < 0) || (spi_mode > 3)) {
+        PyErr_SetString(PyExc_ValueError, "SPI mode must be >= 0 and <= 3.");
+        return NULL;
+    }
+
+    if ((speed_hz < SPI_MIN_HZ) || (speed_hz > SPI_MAX_HZ)) {
+        PyErr_Format(PyExc_ValueError, "Speed must be >= %d and <= %d Hz.", SPI_MIN_HZ, SPI_MAX_HZ);
+        return NULL;
+    }
+
+    if (rcCheckSPISlave(slave) < 0)
+        return NULL;
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&spi_bus_lock);
+    retval = rc_spi_init(ss_mode, spi_mode, speed_hz, slave);
+    pthread_mutex_unlock(&spi_bus_lock);
+    Py_END_ALLOW_THREADS
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcCloseSPI(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int retval;
+    int slave;
+
+    if ((nargs != 1) || (rcArgToInt(args[0], &slave) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Integer argument (slave) required.");
+        return NULL;
+    }
+
+    if (rcCheckSPISlave(slave) < 0)
+        return NULL;
+
+    pthread_mutex_lock(&spi_bus_lock);
+    retval = rc_spi_close(slave);
+    pthread_mutex_unlock(&spi_bus_lock);
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcGetSPIFd(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int fd;
+    int slave;
+
+    if ((nargs != 1) || (rcArgToInt(args[0], &slave) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Integer argument (slave) required.");
+        return NULL;
+    }
+
+    if (rcCheckSPISlave(slave) < 0)
+        return NULL;
+
+    fd = rc_spi_fd(slave);
+
+    return PyLong_FromLong(fd);
+}
+
+static PyObject *rcSelectSPISlave(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int retval;
+    int slave;
+
+    if ((nargs != 1) || (rcArgToInt(args[0], &slave) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Integer argument (slave) required.");
+        return NULL;
+    }
+
+    if (rcCheckSPISlave(slave) < 0)
+        return NULL;
+
+    retval = rc_manual_select_spi_slave(slave);
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcDeselectSPISlave(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int retval;
+    int slave;
+
+    if ((nargs != 1) || (rcArgToInt(args[0], &slave) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Integer argument (slave) required.");
+        return NULL;
+    }
+
+    if (rcCheckSPISlave(slave) < 0)
+        return NULL;
+
+    retval = rc_manual_deselect_spi_slave(slave);
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcSendSPIBytes(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int retval;
+    int slave;
+    Py_buffer data;
+
+    if ((nargs != 2) || (rcArgToInt(args[0], &slave) < 0) ||
+        (PyObject_GetBuffer(args[1], &data, PyBUF_C_CONTIGUOUS) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Integer argument (slave) and bytes-like data required.");
+        return NULL;
+    }
+
+    if (rcCheckSPISlave(slave) < 0) {
+        PyBuffer_Release(&data);
+        return NULL;
+    }
+
+    if ((data.len < 1) || (data.len > SPI_MAX_BYTES)) {
+        PyBuffer_Release(&data);
+        PyErr_Format(PyExc_ValueError, "Data size must be > 0 and <= %d bytes.", SPI_MAX_BYTES);
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&spi_bus_lock);
+    retval = rc_spi_send_bytes((char *)data.buf, (int)data.len, slave);
+    pthread_mutex_unlock(&spi_bus_lock);
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release(&data);
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcReadSPIBytes(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int retval;
+    int slave;
+    int length;
+    PyObject *result = NULL;
+    Py_buffer data;
+
+    if ((nargs != 2) || (rcArgToInt(args[0], &slave) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Integer argument (slave) and data length or writable buffer required.");
+        return NULL;
+    }
+
+    if (rcCheckSPISlave(slave) < 0)
+        return NULL;
+
+    // Either read into a new bytes object of the given length, or
+    // straight into the memory of a caller supplied writable buffer
+    if (PyLong_Check(args[1])) {
+        if (rcArgToInt(args[1], &length) < 0) {
+            PyErr_SetString(PyExc_ValueError, "Data length must be an integer.");
+            return NULL;
+        }
+        if ((length < 1) || (length > SPI_MAX_BYTES)) {
+            PyErr_Format(PyExc_ValueError, "Data length must be > 0 and <= %d.", SPI_MAX_BYTES);
+            return NULL;
+        }
+        result = PyBytes_FromStringAndSize(NULL, length);
+        if (result == NULL)
+            return NULL;
+        if (PyObject_GetBuffer(result, &data, PyBUF_SIMPLE) < 0) {
+            Py_DECREF(result);
+            return NULL;
+        }
+    } else {
+        if (PyObject_GetBuffer(args[1], &data, PyBUF_WRITABLE | PyBUF_C_CONTIGUOUS) < 0) {
+            PyErr_SetString(PyExc_ValueError, "Data length or writable contiguous buffer required.");
+            return NULL;
+        }
+        length = (int)data.len;
+        if ((data.len < 1) || (data.len > SPI_MAX_BYTES)) {
+            PyBuffer_Release(&data);
+            PyErr_Format(PyExc_ValueError, "Buffer size must be > 0 and <= %d bytes.", SPI_MAX_BYTES);
+            return NULL;
+        }
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&spi_bus_lock);
+    retval = rc_spi_read_bytes((char *)data.buf, length, slave);
+    pthread_mutex_unlock(&spi_bus_lock);
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release(&data);
+
+    if (retval < 0) {
+        Py_XDECREF(result);
+        PyErr_SetString(PyExc_ValueError, "Reading bytes from SPI slave failed.");
+        return NULL;
+    }
+
+    if (result != NULL)
+        return result;
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcTransferSPI(PyObject *self, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames) {
+    static const char *const kwlist[] = {"slave", "tx", "rx", "transfers", NULL};
+    PyObject *values[4] = {NULL, NULL, Py_None, NULL};
+    PyObject *result = NULL;
+    Py_buffer tx;
+    Py_buffer rx;
+    Py_ssize_t chunk;
+    int slave;
+    int transfers = 1;
+    int retval = 0;
+    int i;
+
+    if ((rcUnpackArgs(args, nargs, kwnames, kwlist, values) < 0) ||
+        (values[0] == NULL) || (values[1] == NULL) || (rcArgToInt(values[0], &slave) < 0) ||
+        ((values[3] != NULL) && (rcArgToInt(values[3], &transfers) < 0))) {
+        PyErr_SetString(PyExc_ValueError, "Integer argument (slave), bytes-like tx data, optional writable rx buffer and integer (transfers) required.");
+        return NULL;
+    }
+
+    if (rcCheckSPISlave(slave) < 0)
+        return NULL;
+
+    if (PyObject_GetBuffer(values[1], &tx, PyBUF_C_CONTIGUOUS) < 0) {
+        PyErr_SetString(PyExc_ValueError, "Contiguous bytes-like tx data required.");
+        return NULL;
+    }
+
+    if ((transfers < 1) || (tx.len < transfers) || (tx.len % transfers != 0) ||
+        (tx.len / transfers > SPI_MAX_BYTES)) {
+        PyBuffer_Release(&tx);
+        PyErr_Format(PyExc_ValueError, "tx data has to split evenly into transfers of > 0 and <= %d bytes each.", SPI_MAX_BYTES);
+        return NULL;
+    }
+    chunk = tx.len / transfers;
+
+    // Received bytes go into a new bytes object, or straight into the
+    // memory of a caller supplied writable buffer
+    if (values[2] == Py_None) {
+        result = PyBytes_FromStringAndSize(NULL, tx.len);
+        if ((result == NULL) || (PyObject_GetBuffer(result, &rx, PyBUF_SIMPLE) < 0)) {
+            Py_XDECREF(result);
+            PyBuffer_Release(&tx);
+            return NULL;
+        }
+    } else {
+        if (PyObject_GetBuffer(values[2], &rx, PyBUF_WRITABLE | PyBUF_C_CONTIGUOUS) < 0) {
+            PyBuffer_Release(&tx);
+            PyErr_SetString(PyExc_ValueError, "Writable contiguous rx buffer required.");
+            return NULL;
+        }
+        if (rx.len < tx.len) {
+            PyBuffer_Release(&rx);
+            PyBuffer_Release(&tx);
+            PyErr_SetString(PyExc_ValueError, "rx buffer must not be smaller than tx data.");
+            return NULL;
+        }
+    }
+
+    // All transfers of one call are clocked out back to back with the
+    // GIL released; in auto mode chip select toggles between them
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&spi_bus_lock);
+    for (i = 0; (retval >= 0) && (i < transfers); i++)
+        retval = rc_spi_transfer((char *)tx.buf + i * chunk, (int)chunk, (char *)rx.buf + i * chunk, slave);
+    pthread_mutex_unlock(&spi_bus_lock);
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release(&rx);
+    PyBuffer_Release(&tx);
+
+    if (retval < 0) {
+        Py_XDECREF(result);
+        PyErr_SetString(PyExc_ValueError, "SPI transfer failed.");
+        return NULL;
+    }
+
+    if (result != NULL)
+        return result;
+
+    return PyLong_FromSsize_t(chunk * transfers);
+}
+
+
+/*
+ * Checks bus, setting a ValueError and returning -1 if it is invalid.
+ */
+static int rcCheckUARTBus(int bus) {
+    if ((bus < 0) || (bus >= UART_BUSES)) {
+        PyErr_Format(PyExc_ValueError, "UART bus must be >= 0 and <= %d.", UART_BUSES - 1);
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * Checks that bus is not owned by the GPS service, setting a
+ * RuntimeError and returning -1 otherwise.
+ */
+static int rcCheckUARTOwner(int bus) {
+    if ((atomic_load(&gps_service.running) || gps_service.stopping) && (gps_service.bus == bus)) {
+        PyErr_SetString(PyExc_RuntimeError, "UART bus is in use by the GPS service.");
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * Like rcUnpackArgs, for calls passing an argument tuple and a keyword
+ * dict (kwds may be NULL), as type constructors do.
+ */
+static int rcUnpackTupleArgs(PyObject *args, PyObject *kwds, const char *const *kwlist, PyObject **values) {
+    Py_ssize_t pos = 0;
+    Py_ssize_t nargs;
+    Py_ssize_t nparams = 0;
+    Py_ssize_t i;
+    Py_ssize_t k;
+    PyObject *name;
+    PyObject *value;
+
+    while (kwlist[nparams] != NULL)
+        nparams++;
+
+    nargs = PyTuple_GET_SIZE(args);
+    if (nargs > nparams) {
+        PyErr_Format(PyExc_ValueError, "At most %zd arguments expected.", nparams);
+        return -1;
+    }
+
+    for (i = 0; i < nargs; i++)
+        values[i] = PyTuple_GET_ITEM(args, i);
+
+    while ((kwds != NULL) && PyDict_Next(kwds, &pos, &name, &value)) {
+        for (k = 0; k < nparams; k++) {
+            if (PyUnicode_Check(name) && (PyUnicode_CompareWithASCIIString(name, kwlist[k]) == 0))
+                break;
+        }
+
+        if (k == nparams) {
+            PyErr_Format(PyExc_ValueError, "Unexpected keyword argument '%S'.", name);
+            return -1;
+        }
+
+        if (k < nargs) {
+            PyErr_Format(PyExc_ValueError, "Argument '%s' given by name and position.", kwlist[k]);
+            return -1;
+        }
+
+        values[k] = value;
+    }
+
+    return 0;
+}
+
+/*
+ * Read up to length bytes into buf. timeout < 0 blocks like the library
+ * (until length bytes or the timeout given to rcInitializeUART), any
+ * other timeout (s, capped at UART_MAX_TIMEOUT) bounds the whole call,
+ * 0 only takes what has already arrived. Returns the number of bytes
+ * read or -1. Must be called with uart_rx_lock[bus] held.
+ */
+static int rcUARTRead(int bus, char *buf, int length, double timeout) {
+    struct pollfd pfd;
+    uint64_t deadline;
+    uint64_t now;
+    int available;
+    int count = 0;
+    int retval;
+
+    if (timeout < 0.0)
+        return rc_uart_read_bytes(bus, length, buf);
+
+    // Keeps the nanosecond deadline and the poll timeout in range
+    if (timeout > UART_MAX_TIMEOUT)
+        timeout = UART_MAX_TIMEOUT;
+
+    pfd.fd = rc_uart_fd(bus);
+    pfd.events = POLLIN;
+    if (pfd.fd < 0)
+        return -1;
+
+    deadline = rcNanosMonotonic() + (uint64_t)(timeout * 1e9);
+
+    // Only bytes already received are read, so the library never blocks
+    while (count < length) {
+        available = rc_uart_bytes_available(bus);
+        if (available < 0)
+            return -1;
+
+        if (available > 0) {
+            if (available > length - count)
+                available = length - count;
+            retval = rc_uart_read_bytes(bus, available, buf + count);
+            if (retval < 0)
+                return -1;
+            count += retval;
+            continue;
+        }
+
+        now = rcNanosMonotonic();
+        if (now >= deadline)
+            break;
+
+        if ((poll(&pfd, 1, (int)((deadline - now + 999999) / 1000000)) < 0) && (errno != EINTR))
+            return -1;
+    }
+
+    return count;
+}
+
+static PyObject *rcInitializeUART(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int retval;
+    int bus;
+    int baudrate;
+    float timeout;
+
+    if ((nargs != 3) || (rcArgToInt(args[0], &bus) < 0) ||
+        (rcArgToInt(args[1], &baudrate) < 0) || (rcArgToFloat(args[2], &timeout) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Two integer arguments (bus, baudrate) and float argument (read timeout in s) required.");
+        return NULL;
+    }
+
+    if ((rcCheckUARTBus(bus) < 0) || (rcCheckUARTOwner(bus) < 0))
+        return NULL;
+
+    if (baudrate < 1) {
+        PyErr_SetString(PyExc_ValueError, "Baudrate must be > 0.");
+        return NULL;
+    }
+
+    if (!((timeout >= 0.0) && (timeout <= UART_MAX_TIMEOUT))) {
+        PyErr_SetString(PyExc_ValueError, "Read timeout has to be >= 0 and <= 25.5 s.");
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&uart_rx_lock[bus]);
+    pthread_mutex_lock(&uart_tx_lock[bus]);
+    retval = rc_uart_init(bus, baudrate, timeout);
+    pthread_mutex_unlock(&uart_tx_lock[bus]);
+    pthread_mutex_unlock(&uart_rx_lock[bus]);
+    Py_END_ALLOW_THREADS
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcCloseUART(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int retval;
+    int bus;
+
+    if ((nargs != 1) || (rcArgToInt(args[0], &bus) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Integer argument (bus) required.");
+        return NULL;
+    }
+
+    if ((rcCheckUARTBus(bus) < 0) || (rcCheckUARTOwner(bus) < 0))
+        return NULL;
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&uart_rx_lock[bus]);
+    pthread_mutex_lock(&uart_tx_lock[bus]);
+    retval = rc_uart_close(bus);
+    pthread_mutex_unlock(&uart_tx_lock[bus]);
+    pthread_mutex_unlock(&uart_rx_lock[bus]);
+    Py_END_ALLOW_THREADS
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcGetUARTFd(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int fd;
+    int bus;
+
+    if ((nargs != 1) || (rcArgToInt(args[0], &bus) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Integer argument (bus) required.");
+        return NULL;
+    }
+
+    if (rcCheckUARTBus(bus) < 0)
+        return NULL;
+
+    fd = rc_uart_fd(bus);
+
+    return PyLong_FromLong(fd);
+}
+
+static PyObject *rcFlushUART(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int retval;
+    int bus;
+
+    if ((nargs != 1) || (rcArgToInt(args[0], &bus) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Integer argument (bus) required.");
+        return NULL;
+    }
+
+    if ((rcCheckUARTBus(bus) < 0) || (rcCheckUARTOwner(bus) < 0))
+        return NULL;
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&uart_rx_lock[bus]);
+    pthread_mutex_lock(&uart_tx_lock[bus]);
+    retval = rc_uart_flush(bus);
+    pthread_mutex_unlock(&uart_tx_lock[bus]);
+    pthread_mutex_unlock(&uart_rx_lock[bus]);
+    Py_END_ALLOW_THREADS
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcSendUARTBytes(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int retval;
+    int bus;
+    Py_buffer data;
+
+    if ((nargs != 2) || (rcArgToInt(args[0], &bus) < 0) ||
+        (PyObject_GetBuffer(args[1], &data, PyBUF_C_CONTIGUOUS) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Integer argument (bus) and bytes-like data required.");
+        return NULL;
+    }
+
+    // No rcCheckUARTOwner: sending stays allowed on the GPS service's
+    // bus so the receiver can be configured; TX leaves its RX stream alone
+    if (rcCheckUARTBus(bus) < 0) {
+        PyBuffer_Release(&data);
+        return NULL;
+    }
+
+    if ((data.len < 1) || (data.len > INT_MAX)) {
+        PyBuffer_Release(&data);
+        PyErr_SetString(PyExc_ValueError, "Data must not be empty.");
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&uart_tx_lock[bus]);
+    retval = rc_uart_send_bytes(bus, (int)data.len, (char *)data.buf);
+    pthread_mutex_unlock(&uart_tx_lock[bus]);
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release(&data);
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcSendUARTByte(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int retval;
+    int bus;
+    int byte;
+
+    if ((nargs != 2) || (rcArgToInt(args[0], &bus) < 0) ||
+        (rcArgToInt(args[1], &byte) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Two integer arguments (bus, byte) required.");
+        return NULL;
+    }
+
+    // Allowed on the GPS service's bus, as for rcSendUARTBytes
+    if (rcCheckUARTBus(bus) < 0)
+        return NULL;
+
+    if ((byte < 0x00) || (byte > 0xff)) {
+        PyErr_SetString(PyExc_ValueError, "Byte must be >= 0x00 and <= 0xff.");
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&uart_tx_lock[bus]);
+    retval = rc_uart_send_byte(bus, (char)byte);
+    pthread_mutex_unlock(&uart_tx_lock[bus]);
+    Py_END_ALLOW_THREADS
+
+    return PyLong_FromLong(retval);
+}
+
+/*
+ * Common part of rcReadUARTBytes and rcReadUARTLine: data is either a
+ * length (returns bytes trimmed to what has been read) or a writable
+ * buffer (returns the count). line selects rc_uart_read_line.
+ */
+static PyObject *rcUARTReadInto(int bus, PyObject *data, double timeout, int line) {
+    PyObject *result = NULL;
+    Py_buffer buffer;
+    int length;
+    int retval;
+
+    if ((rcCheckUARTBus(bus) < 0) || (rcCheckUARTOwner(bus) < 0))
+        return NULL;
+
+    if (PyLong_Check(data)) {
+        if ((rcArgToInt(data, &length) < 0) || (length < 1)) {
+            PyErr_SetString(PyExc_ValueError, "Data length must be an integer > 0.");
+            return NULL;
+        }
+        result = PyBytes_FromStringAndSize(NULL, length);
+        if (result == NULL)
+            return NULL;
+        if (PyObject_GetBuffer(result, &buffer, PyBUF_SIMPLE) < 0) {
+            Py_DECREF(result);
+            return NULL;
+        }
+    } else {
+        if (PyObject_GetBuffer(data, &buffer, PyBUF_WRITABLE | PyBUF_C_CONTIGUOUS) < 0) {
+            PyErr_SetString(PyExc_ValueError, "Data length or writable contiguous buffer required.");
+            return NULL;
+        }
+        if ((buffer.len < 1) || (buffer.len > INT_MAX)) {
+            PyBuffer_Release(&buffer);
+            PyErr_SetString(PyExc_ValueError, "Buffer must not be empty.");
+            return NULL;
+        }
+        length = (int)buffer.len;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&uart_rx_lock[bus]);
+    if (line)
+        retval = rc_uart_read_line(bus, length, (char *)buffer.buf);
+    else
+        retval = rcUARTRead(bus, (char *)buffer.buf, length, timeout);
+    pthread_mutex_unlock(&uart_rx_lock[bus]);
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release(&buffer);
+
+    if (retval < 0) {
+        Py_XDECREF(result);
+        PyErr_SetString(PyExc_ValueError, "Reading from UART failed.");
+        return NULL;
+    }
+
+    if (result == NULL)
+        return PyLong_FromLong(retval);
+
+    if ((retval < length) && (_PyBytes_Resize(&result, retval) < 0))
+        return NULL;
+
+    return result;
+}
+
+static PyObject *rcReadUARTBytes(PyObject *self, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames) {
+    static const char *const kwlist[] = {"bus", "data", "timeout", NULL};
+    PyObject *values[3] = {NULL, NULL, Py_None};
+    int bus;
+    float timeout = -1.0;
+
+    if ((rcUnpackArgs(args, nargs, kwnames, kwlist, values) < 0) ||
+        (values[0] == NULL) || (values[1] == NULL) || (rcArgToInt(values[0], &bus) < 0) ||
+        ((values[2] != Py_None) && (rcArgToFloat(values[2], &timeout) < 0))) {
+        PyErr_SetString(PyExc_ValueError, "Integer argument (bus), data length or writable buffer and optional float (timeout in s) required.");
+        return NULL;
+    }
+
+    if ((values[2] != Py_None) && !((timeout >= 0.0) && (timeout <= UART_MAX_TIMEOUT))) {
+        PyErr_SetString(PyExc_ValueError, "Timeout has to be >= 0 and <= 25.5 s.");
+        return NULL;
+    }
+
+    return rcUARTReadInto(bus, values[1], timeout, 0);
+}
+
+static PyObject *rcReadUARTLine(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int bus;
+
+    if ((nargs != 2) || (rcArgToInt(args[0], &bus) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Integer argument (bus) and maximum length or writable buffer required.");
+        return NULL;
+    }
+
+    return rcUARTReadInto(bus, args[1], -1.0, 1);
+}
+
+static PyObject *rcUARTBytesAvailable(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int available;
+    int bus;
+
+    if ((nargs != 1) || (rcArgToInt(args[0], &bus) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Integer argument (bus) required.");
+        return NULL;
+    }
+
+    if (rcCheckUARTBus(bus) < 0)
+        return NULL;
+
+    available = rc_uart_bytes_available(bus);
+
+    return PyLong_FromLong(available);
+}
+
+
+static void *rcGPSServiceThread(void *arg) {
+    uint8_t buf[GPS_READ_LEN];
+    struct pollfd pfd;
+    uint64_t seq;
+    uint64_t now;
+    int updated;
+    int count;
+    int i;
+
+    pfd.fd = rc_uart_fd(gps_service.bus);
+    pfd.events = POLLIN;
+
+    while (atomic_load_explicit(&gps_service.running, memory_order_acquire)) {
+        // Wake up as soon as data arrives, but check running regularly
+        if (poll(&pfd, 1, GPS_POLL_MS) <= 0)
+            continue;
+
+        pthread_mutex_lock(&uart_rx_lock[gps_service.bus]);
+        count = rcUARTRead(gps_service.bus, (char *)buf, GPS_READ_LEN, 0.0);
+        pthread_mutex_unlock(&uart_rx_lock[gps_service.bus]);
+        now = rcNanosMonotonic();
+
+        if (count < 0) {
+            rcSleepUntil(now + GPS_POLL_MS * 1000000ULL);
+            continue;
+        }
+
+        updated = 0;
+        for (i = 0; i < count; i++)
+            updated |= gps_parser_feed(&gps_service.parser, buf[i]);
+
+        atomic_store_explicit(&gps_service.messages, gps_service.parser.messages, memory_order_relaxed);
+        atomic_store_explicit(&gps_service.errors, gps_service.parser.errors, memory_order_relaxed);
+
+        if (!updated)
+            continue;
+
+        // Sentences of one read are published together
+        seq = atomic_load_explicit(&gps_service.seq, memory_order_relaxed);
+        atomic_store_explicit(&gps_service.seq, seq + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        gps_service.fix = gps_service.parser.fix;
+        gps_service.fix.nanos = now;
+        atomic_store_explicit(&gps_service.seq, seq + 2, memory_order_release);
+    }
+
+    return NULL;
+}
+
+static int rcStopGPSServiceThread(void) {
+    int retval;
+
+    if (!atomic_load(&gps_service.running))
+        return 0;
+
+    atomic_store_explicit(&gps_service.running, 0, memory_order_release);
+    gps_service.stopping = 1;
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_join(gps_service.thread, NULL);
+    pthread_mutex_lock(&uart_rx_lock[gps_service.bus]);
+    pthread_mutex_lock(&uart_tx_lock[gps_service.bus]);
+    retval = rc_uart_close(gps_service.bus);
+    pthread_mutex_unlock(&uart_tx_lock[gps_service.bus]);
+    pthread_mutex_unlock(&uart_rx_lock[gps_service.bus]);
+    Py_END_ALLOW_THREADS
+
+    gps_service.stopping = 0;
+
+    return retval;
+}
+
+static PyObject *rcStartGPSService(PyObject *self, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames) {
+    static const char *const kwlist[] = {"bus", "baudrate", NULL};
+    PyObject *values[2] = {NULL, NULL};
+    int baudrate = 9600;
+    int retval;
+    int bus;
+
+    if ((rcUnpackArgs(args, nargs, kwnames, kwlist, values) < 0) ||
+        (values[0] == NULL) || (rcArgToInt(values[0], &bus) < 0) ||
+        ((values[1] != NULL) && (rcArgToInt(values[1], &baudrate) < 0))) {
+        PyErr_SetString(PyExc_ValueError, "Integer argument (bus) and optional integer argument (baudrate) required.");
+        return NULL;
+    }
+
+    if (rcCheckUARTBus(bus) < 0)
+        return NULL;
+
+    if (baudrate < 1) {
+        PyErr_SetString(PyExc_ValueError, "Baudrate must be > 0.");
+        return NULL;
+    }
+
+    if (atomic_load(&gps_service.running)) {
+        PyErr_SetString(PyExc_RuntimeError, "GPS service is already running.");
+        return NULL;
+    }
+
+    if (gps_service.stopping) {
+        PyErr_SetString(PyExc_RuntimeError, "GPS service is still stopping.");
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&uart_rx_lock[bus]);
+    pthread_mutex_lock(&uart_tx_lock[bus]);
+    retval = rc_uart_init(bus, baudrate, GPS_POLL_MS / 1000.0f);
+    pthread_mutex_unlock(&uart_tx_lock[bus]);
+    pthread_mutex_unlock(&uart_rx_lock[bus]);
+    Py_END_ALLOW_THREADS
+
+    if (retval < 0) {
+        PyErr_SetString(PyExc_RuntimeError, "Initializing UART bus failed.");
+        return NULL;
+    }
+
+    // No reader can be active: the previous fix may be cleared directly
+    gps_service.bus = bus;
+    gps_parser_init(&gps_service.parser);
+    gps_service.fix = gps_service.parser.fix;
+    atomic_store(&gps_service.seq, 0);
+    atomic_store(&gps_service.messages, 0);
+    atomic_store(&gps_service.errors, 0);
+    atomic_store(&gps_service.running, 1);
+
+    if (pthread_create(&gps_service.thread, NULL, rcGPSServiceThread, NULL) != 0) {
+        atomic_store(&gps_service.running, 0);
+        rc_uart_close(bus);
+        PyErr_SetString(PyExc_RuntimeError, "Starting GPS service thread failed.");
+        return NULL;
+    }
+
+    return PyLong_FromLong(0);
+}
+
+static PyObject *rcStopGPSService(PyObject *self, PyObject *args) {
+    int retval;
+
+    retval = rcStopGPSServiceThread();
+
+    return PyLong_FromLong(retval);
+}
+
+static PyObject *rcGetGPSFix(PyObject *self, PyObject *args) {
+    PyObject *result;
+    gps_fix_t fix;
+    uint64_t seq;
+
+    do {
+        seq = atomic_load_explicit(&gps_service.seq, memory_order_acquire);
+        memcpy(&fix, &gps_service.fix, sizeof(fix));
+        atomic_thread_fence(memory_order_acquire);
+    } while ((seq & 1) || (atomic_load_explicit(&gps_service.seq, memory_order_relaxed) != seq));
+
+    if (fix.nanos == 0)
+        Py_RETURN_NONE;
+
+    result = PyStructSequence_New(GPSFixType);
+    if (result == NULL)
+        return NULL;
+
+    PyStructSequence_SET_ITEM(result, 0, PyLong_FromUnsignedLongLong((unsigned long long)fix.nanos));
+    PyStructSequence_SET_ITEM(result, 1, PyFloat_FromDouble(fix.latitude));
+    PyStructSequence_SET_ITEM(result, 2, PyFloat_FromDouble(fix.longitude));
+    PyStructSequence_SET_ITEM(result, 3, PyFloat_FromDouble(fix.altitude_m));
+    PyStructSequence_SET_ITEM(result, 4, PyFloat_FromDouble(fix.speed_ms));
+    PyStructSequence_SET_ITEM(result, 5, PyFloat_FromDouble(fix.heading));
+    PyStructSequence_SET_ITEM(result, 6, PyLong_FromLong(fix.quality));
+    PyStructSequence_SET_ITEM(result, 7, PyLong_FromLong(fix.satellites));
+
+    if (PyErr_Occurred()) {
+        Py_DECREF(result);
+        return NULL;
+    }
+
+    return result;
+}
+
+static PyObject *rcGetGPSServiceStatus(PyObject *self, PyObject *args) {
+    return Py_BuildValue("(iKK)", atomic_load(&gps_service.running),
+                         (unsigned long long)atomic_load(&gps_service.messages),
+                         (unsigned long long)atomic_load(&gps_service.errors));
+}
+
+
+/*
+ * Convert the coefficient sequence obj into coeffs (at most
+ * DFILTER_MAX_ORDER + 1). Returns their number, or -1 with a ValueError
+ * set.
+ */
+static int rcCoefficientsFromObject(PyObject *obj, double *coeffs, const char *name) {
+    PyObject *seq;
+    Py_ssize_t count;
+    Py_ssize_t i;
+
+    seq = PySequence_Fast(obj, "");
+    if ((seq == NULL) || (PySequence_Fast_GET_SIZE(seq) < 1) ||
+        (PySequence_Fast_GET_SIZE(seq) > DFILTER_MAX_ORDER + 1)) {
+        Py_XDECREF(seq);
+        PyErr_Format(PyExc_ValueError, "%s has to be a sequence of 1 to %d coefficients.",
+                     name, DFILTER_MAX_ORDER + 1);
+        return -1;
+    }
+
+    count = PySequence_Fast_GET_SIZE(seq);
+    for (i = 0; i < count; i++) {
+        coeffs[i] = PyFloat_AsDouble(PySequence_Fast_GET_ITEM(seq, i));
+        if (((coeffs[i] == -1.0) && PyErr_Occurred()) || !isfinite(coeffs[i])) {
+            Py_DECREF(seq);
+            PyErr_Format(PyExc_ValueError, "%s has to contain finite float values only.", name);
+            return -1;
+        }
+    }
+    Py_DECREF(seq);
+
+    return (int)count;
+}
+
+/*
+ * One controller step for measurement, with self->lock held. PID
+ * controllers act on the error's proportional and integral parts, but
+ * differentiate the measurement, so setpoint steps do not kick the
+ * output; the derivative is low-passed with time constant tau. The
+ * integrator is frozen (conditional integration) while the output
+ * saturates in the direction it would push it further.
+ */
+static double rcControllerStep(ControllerObject *self, double measurement) {
+    double error;
+    double integral;
+    double output;
+
+    error = self->setpoint - measurement;
+
+    if (self->mode == CONTROLLER_TF) {
+        output = dfilter_march(&self->tf, error);
+    } else {
+        if (!self->primed)
+            self->previous = measurement;
+        self->derivative = (self->tau * self->derivative - self->kd * (measurement - self->previous)) /
+                           (self->tau + self->dt);
+        self->previous = measurement;
+
+        integral = self->integral + self->ki * error * self->dt;
+        output = self->kp * error + integral + self->derivative;
+        if (((output > self->limit) && (error > 0.0)) || ((output < -self->limit) && (error < 0.0)))
+            output = self->kp * error + self->integral + self->derivative;
+        else
+            self->integral = integral;
+
+        if (output > self->limit)
+            output = self->limit;
+        else if (output < -self->limit)
+            output = -self->limit;
+    }
+
+    self->primed = 1;
+    self->measurement = measurement;
+    self->output = output;
+
+    return output;
+}
+
+static void rcControllerResetState(ControllerObject *self) {
+    self->primed = 0;
+    self->integral = 0.0;
+    self->derivative = 0.0;
+    self->previous = 0.0;
+    self->output = 0.0;
+    dfilter_reset(&self->tf);
+}
+
+static void *rcControllerThread(void *arg) {
+    ControllerObject *self = arg;
+    uint64_t period_ns;
+    uint64_t last = 0;
+    uint64_t next;
+    uint64_t now;
+    double measurement;
+    double output;
+    long position;
+    long last_position = 0;
+
+    period_ns = (uint64_t)(self->dt * 1e9);
+    next = rcNanosMonotonic();
+
+    while (atomic_load_explicit(&self->running, memory_order_acquire) &&
+           (rc_get_state() != EXITING)) {
+        now = rcNanosMonotonic();
+        position = (long)rc_get_encoder_pos(self->encoder);
+
+        // Velocities are taken over the actual sampling interval; the
+        // first sample only primes them
+        if (!self->velocity || (last != 0)) {
+            if (self->velocity)
+                measurement = (double)(position - last_position) * self->scale / ((double)(now - last) * 1e-9);
+            else
+                measurement = (double)position * self->scale;
+
+            pthread_mutex_lock(&self->lock);
+            output = rcControllerStep(self, measurement);
+            pthread_mutex_unlock(&self->lock);
+
+            if (self->motor > 0)
+                rc_set_motor(self->motor, (float)fmax(-1.0, fmin(1.0, output)));
+            atomic_fetch_add_explicit(&self->ticks, 1, memory_order_relaxed);
+        }
+        last = now;
+        last_position = position;
+
+        next += period_ns;
+        now = rcNanosMonotonic();
+        while (next <= now) {
+            atomic_fetch_add_explicit(&self->overruns, 1, memory_order_relaxed);
+            next += period_ns;
+        }
+
+        rcSleepUntil(next);
+    }
+
+    // Left on EXITING: the motor must not keep its last output. The
+    // thread stays in running_controllers until stop(), start(), bind()
+    // or rcCleanup joins it
+    if (atomic_load_explicit(&self->running, memory_order_acquire)) {
+        if (self->motor > 0)
+            rc_set_motor(self->motor, 0.0f);
+        atomic_store_explicit(&self->running, 0, memory_order_release);
+    }
+
+    return NULL;
+}
+
+/*
+ * Stop self's timer thread, if any, and free its motor. The thread may
+ * already have ended on EXITING, so it is looked up in
+ * running_controllers rather than by running. Must be called with the
+ * GIL held; may drop the last reference to self.
+ */
+static void rcStopControllerThread(ControllerObject *self) {
+    if ((self->prev_running == NULL) && (running_controllers != self))
+        return;
+
+    atomic_store_explicit(&self->running, 0, memory_order_release);
+
+    // Unlink while the GIL is still held; start() and bind() refuse
+    // until the join below is done
+    self->stopping = 1;
+    if (self->prev_running != NULL)
+        self->prev_running->next_running = self->next_running;
+    else
+        running_controllers = self->next_running;
+    if (self->next_running != NULL)
+        self->next_running->prev_running = self->prev_running;
+    self->next_running = NULL;
+    self->prev_running = NULL;
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_join(self->thread, NULL);
+    if (self->motor > 0)
+        rc_set_motor(self->motor, 0.0f);
+    Py_END_ALLOW_THREADS
+
+    self->stopping = 0;
+    Py_DECREF(self);
+}
+
+static void rcStopControllers(void) {
+    while (running_controllers != NULL)
+        rcStopControllerThread(running_controllers);
+}
+
+static ControllerObject *rcControllerAlloc(PyTypeObject *type, int mode, double dt, double limit) {
+    ControllerObject *self;
+
+    if (!((dt > 0.0) && (dt <= 1.0))) {
+        PyErr_SetString(PyExc_ValueError, "Time step dt must be > 0 and <= 1 s.");
+        return NULL;
+    }
+
+    if (!(limit > 0.0)) {
+        PyErr_SetString(PyExc_ValueError, "Output limit must be > 0.");
+        return NULL;
+    }
+
+    self = (ControllerObject *)type->tp_alloc(type, 0);
+    if (self == NULL)
+        return NULL;
+
+    self->mode = mode;
+    self->dt = dt;
+    self->limit = limit;
+    self->scale = 1.0;
+    pthread_mutex_init(&self->lock, NULL);
+    rcControllerResetState(self);
+
+    return self;
+}
+
+static PyObject *rcControllerNew(PyTypeObject *type, PyObject *args, PyObject *kwds) {
+    static const char *const kwlist[] = {"dt", "kp", "ki", "kd", "tau", "limit", NULL};
+    PyObject *values[6] = {NULL, NULL, NULL, NULL, NULL, NULL};
+    double params[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 1.0};
+    ControllerObject *self;
+    int i;
+
+    if (rcUnpackTupleArgs(args, kwds, kwlist, values) < 0)
+        return NULL;
+
+    for (i = 0; i < 6; i++) {
+        if (values[i] == NULL)
+            continue;
+        params[i] = PyFloat_AsDouble(values[i]);
+        if ((params[i] == -1.0) && PyErr_Occurred())
+            break;
+    }
+
+    if ((values[0] == NULL) || (i < 6) ||
+        !(isfinite(params[1]) && isfinite(params[2]) && isfinite(params[3]))) {
+        PyErr_Clear();
+        PyErr_SetString(PyExc_ValueError, "Float argument (dt in s) and optional float arguments (kp, ki, kd, tau in s, limit) required.");
+        return NULL;
+    }
+
+    if (!((params[4] >= 0.0) && isfinite(params[4]))) {
+        PyErr_SetString(PyExc_ValueError, "Derivative filter time constant tau must be >= 0.");
+        return NULL;
+    }
+
+    self = rcControllerAlloc(type, CONTROLLER_PID, params[0], params[5]);
+    if (self == NULL)
+        return NULL;
+
+    self->kp = params[1];
+    self->ki = params[2];
+    self->kd = params[3];
+    self->tau = params[4];
+
+    return (PyObject *)self;
+}
+
+static void rcControllerDealloc(ControllerObject *self) {
+    PyTypeObject *type = Py_TYPE(self);
+
+    // Running controllers own a reference, so the thread is gone here
+    pthread_mutex_destroy(&self->lock);
+    type->tp_free(self);
+    Py_DECREF(type);
+}
+
+static PyObject *rcControllerTransferFunction(PyObject *cls, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames) {
+    static const char *const kwlist[] = {"num", "den", "dt", "limit", NULL};
+    PyObject *values[4] = {NULL, NULL, NULL, NULL};
+    double num[DFILTER_MAX_ORDER + 1];
+    double den[DFILTER_MAX_ORDER + 1];
+    int num_len;
+    int den_len;
+    float dt;
+    float limit = 1.0;
+    ControllerObject *self;
+
+    if ((rcUnpackArgs(args, nargs, kwnames, kwlist, values) < 0) ||
+        (values[0] == NULL) || (values[1] == NULL) || (values[2] == NULL) ||
+        (rcArgToFloat(values[2], &dt) < 0) ||
+        ((values[3] != NULL) && (rcArgToFloat(values[3], &limit) < 0))) {
+        PyErr_SetString(PyExc_ValueError, "Numerator and denominator sequences, float argument (dt in s) and optional float argument (limit) required.");
+        return NULL;
+    }
+
+    num_len = rcCoefficientsFromObject(values[0], num, "Numerator");
+    if (num_len < 0)
+        return NULL;
+    den_len = rcCoefficientsFromObject(values[1], den, "Denominator");
+    if (den_len < 0)
+        return NULL;
+
+    if ((den[0] == 0.0) || (num_len > den_len)) {
+        PyErr_SetString(PyExc_ValueError, "Transfer function has to be proper (numerator not longer than denominator) with den[0] != 0.");
+        return NULL;
+    }
+
+    self = rcControllerAlloc((PyTypeObject *)cls, CONTROLLER_TF, dt, limit);
+    if (self == NULL)
+        return NULL;
+
+    dfilter_init(&self->tf, num, num_len, den, den_len, -self->limit, self->limit);
+
+    return (PyObject *)self;
+}
 
-    if (!PyArg_ParseTuple(args, "f", &pa)) {
-        PyErr_SetString(PyExc_ValueError, "Float argument (pressure in pascal) required.");
+static PyObject *rcControllerStepMethod(ControllerObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    double measurement;
+    double output;
+
+    if ((nargs != 1) || (((measurement = PyFloat_AsDouble(args[0])) == -1.0) && PyErr_Occurred())) {
+        PyErr_Clear();
+        PyErr_SetString(PyExc_ValueError, "Float argument (measurement) required.");
         return NULL;
     }
 
-    if ((pa < 80000.0) || (pa > 120000.0)) {
-        PyErr_SetString(PyExc_ValueError, "Pressure in pascal must be >= 80,000 and <= 120,000.");
+    if (atomic_load(&self->running)) {
+        PyErr_SetString(PyExc_RuntimeError, "Controller is stepped by its timer.");
         return NULL;
     }
 
-    retval = rc_set_sea_level_pressure_pa(pa);
+    pthread_mutex_lock(&self->lock);
+    output = rcControllerStep(self, measurement);
+    pthread_mutex_unlock(&self->lock);
 
-    return Py_BuildValue("i", retval);
+    return PyFloat_FromDouble(output);
 }
 
-static PyObject *rcInitializeI2C(PyObject *self, PyObject *args) {
-    int retval;
-    int bus;
-    int address;
+static PyObject *rcControllerReset(ControllerObject *self, PyObject *args) {
+    pthread_mutex_lock(&self->lock);
+    rcControllerResetState(self);
+    pthread_mutex_unlock(&self->lock);
 
-    if (!PyArg_ParseTuple(args, "ii", &bus, &address)) {
-        PyErr_SetString(PyExc_ValueError, "Two integer arguments (bus number, device address) required.");
+    Py_RETURN_NONE;
+}
+
+static PyObject *rcControllerBind(ControllerObject *self, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames) {
+    static const char *const kwlist[] = {"encoder", "motor", "scale", "velocity", NULL};
+    PyObject *values[4] = {NULL, NULL, NULL, NULL};
+    int encoder;
+    int motor = 0;
+    float scale = 1.0;
+    int velocity = 0;
+
+    if ((rcUnpackArgs(args, nargs, kwnames, kwlist, values) < 0) ||
+        (values[0] == NULL) || (rcArgToInt(values[0], &encoder) < 0) ||
+        ((values[1] != NULL) && (rcArgToInt(values[1], &motor) < 0)) ||
+        ((values[2] != NULL) && (rcArgToFloat(values[2], &scale) < 0)) ||
+        ((values[3] != NULL) && ((velocity = PyObject_IsTrue(values[3])) < 0))) {
+        PyErr_SetString(PyExc_ValueError, "Integer argument (encoder channel) and optional arguments (motor, scale, velocity) required.");
         return NULL;
     }
 
-    if ((bus < 1) || (bus > 2)) {
-        PyErr_SetString(PyExc_ValueError, "Bus number must be 1 or 2.");
+    if ((encoder < 1) || (encoder > 4)) {
+        PyErr_SetString(PyExc_ValueError, "Encoder channel has to be >= 1 and <= 4.");
         return NULL;
     }
 
-    if ((address < 0x03) || (address > 0x77)) {
-        PyErr_SetString(PyExc_ValueError, "Device address must be >= 0x03 and <= 0x77.");
+    if ((motor < 0) || (motor > 4)) {
+        PyErr_SetString(PyExc_ValueError, "Motor number has to be >= 1 and <= 4, or 0 for none.");
         return NULL;
     }
 
-    retval = rc_i2c_init(bus, (uint8_t)address);
-
-    return Py_BuildValue("i", retval);
-}
+    if (!(isfinite(scale) && (scale != 0.0))) {
+        PyErr_SetString(PyExc_ValueError, "Scale has to be finite and != 0.");
+        return NULL;
+    }
 
-static PyObject *rcCloseI2C(PyObject *self, PyObject *args) {
-    int retval;
-    int bus;
+    // Join a thread that ended on EXITING; the caller's reference keeps
+    // self alive
+    if (!atomic_load(&self->running) && !self->stopping)
+        rcStopControllerThread(self);
 
-    if (!PyArg_ParseTuple(args, "i", &bus)) {
-        PyErr_SetString(PyExc_ValueError, "Integer argument (bus number) required.");
+    if (atomic_load(&self->running)) {
+        PyErr_SetString(PyExc_RuntimeError, "Controller is running.");
         return NULL;
     }
 
-    if ((bus < 1) || (bus > 2)) {
-        PyErr_SetString(PyExc_ValueError, "Bus number must be 1 or 2.");
+    if (self->stopping) {
+        PyErr_SetString(PyExc_RuntimeError, "Controller is still stopping.");
         return NULL;
     }
 
-    retval = rc_i2c_close(bus);
+    self->encoder = encoder;
+    self->motor = motor;
+    self->scale = scale;
+    self->velocity = velocity;
 
-    return Py_BuildValue("i", retval);
+    Py_RETURN_NONE;
 }
 
-static PyObject *rcSetI2CDeviceAddress(PyObject *self, PyObject *args) {
-    int retval;
-    int bus;
-    int address;
+static PyObject *rcControllerStart(ControllerObject *self, PyObject *args) {
+    if (self->encoder == 0) {
+        PyErr_SetString(PyExc_RuntimeError, "Controller is not bound to an encoder.");
+        return NULL;
+    }
 
-    if (!PyArg_ParseTuple(args, "ii", &bus, &address)) {
-        PyErr_SetString(PyExc_ValueError, "Two integer arguments (bus number, device address) required.");
+    // Join a thread that ended on EXITING; the caller's reference keeps
+    // self alive
+    if (!atomic_load(&self->running) && !self->stopping)
+        rcStopControllerThread(self);
+
+    if (atomic_load(&self->running)) {
+        PyErr_SetString(PyExc_RuntimeError, "Controller is already running.");
         return NULL;
     }
 
-    if ((bus < 1) || (bus > 2)) {
-        PyErr_SetString(PyExc_ValueError, "Bus number must be 1 or 2.");
+    if (self->stopping) {
+        PyErr_SetString(PyExc_RuntimeError, "Controller is still stopping.");
         return NULL;
     }
 
-    if ((address < 0x03) || (address > 0x77)) {
-        PyErr_SetString(PyExc_ValueError, "Device address must be >= 0x03 and <= 0x77.");
+    atomic_store(&self->ticks, 0);
+    atomic_store(&self->overruns, 0);
+    atomic_store(&self->running, 1);
+
+    if (pthread_create(&self->thread, NULL, rcControllerThread, self) != 0) {
+        atomic_store(&self->running, 0);
+        PyErr_SetString(PyExc_RuntimeError, "Starting controller thread failed.");
         return NULL;
     }
 
-    retval = rc_i2c_set_device_address(bus, (uint8_t)address);
+    Py_INCREF(self);
+    self->next_running = running_controllers;
+    if (running_controllers != NULL)
+        running_controllers->prev_running = self;
+    running_controllers = self;
 
-    return Py_BuildValue("i", retval);
+    Py_RETURN_NONE;
 }
 
-static PyObject *rcClaimI2CBus(PyObject *self, PyObject *args) {
-    int retval;
-    int bus;
+static PyObject *rcControllerStop(ControllerObject *self, PyObject *args) {
+    rcStopControllerThread(self);
 
-    if (!PyArg_ParseTuple(args, "i", &bus)) {
-        PyErr_SetString(PyExc_ValueError, "Integer argument (bus number) required.");
-        return NULL;
-    }
+    Py_RETURN_NONE;
+}
 
-    if ((bus < 1) || (bus > 2)) {
-        PyErr_SetString(PyExc_ValueError, "Bus number must be 1 or 2.");
-        return NULL;
-    }
+static PyObject *rcControllerStatus(ControllerObject *self, PyObject *args) {
+    return Py_BuildValue("(iKK)", atomic_load(&self->running),
+                         (unsigned long long)atomic_load(&self->ticks),
+                         (unsigned long long)atomic_load(&self->overruns));
+}
 
-    retval = rc_i2c_claim_bus(bus);
+/*
+ * Getters and setters of the double members listed in ControllerGetSet;
+ * closure is the member's offset. Setters take self->lock, so the timer
+ * thread never sees half a change.
+ */
+static PyObject *rcControllerGetDouble(ControllerObject *self, void *closure) {
+    double value;
+
+    pthread_mutex_lock(&self->lock);
+    value = *(double *)((char *)self + (size_t)closure);
+    pthread_mutex_unlock(&self->lock);
 
-    return Py_BuildValue("i", retval);
+    return PyFloat_FromDouble(value);
 }
 
-static PyObject *rcReleaseI2CBus(PyObject *self, PyObject *args) {
-    int retval;
-    int bus;
+static int rcControllerSetDouble(ControllerObject *self, PyObject *arg, void *closure) {
+    size_t offset = (size_t)closure;
+    double value;
 
-    if (!PyArg_ParseTuple(args, "i", &bus)) {
-        PyErr_SetString(PyExc_ValueError, "Integer argument (bus number) required.");
-        return NULL;
+    if ((arg == NULL) || (((value = PyFloat_AsDouble(arg)) == -1.0) && PyErr_Occurred()) || !isfinite(value)) {
+        PyErr_Clear();
+        PyErr_SetString(PyExc_ValueError, "Finite float value required.");
+        return -1;
     }
 
-    if ((bus < 1) || (bus > 2)) {
-        PyErr_SetString(PyExc_ValueError, "Bus number must be 1 or 2.");
-        return NULL;
+    if ((self->mode == CONTROLLER_TF) && (offset != offsetof(ControllerObject, setpoint))) {
+        PyErr_SetString(PyExc_RuntimeError, "Transfer function controllers only take a new setpoint.");
+        return -1;
     }
 
-    retval = rc_i2c_release_bus(bus);
+    if ((offset == offsetof(ControllerObject, tau)) && (value < 0.0)) {
+        PyErr_SetString(PyExc_ValueError, "Derivative filter time constant tau must be >= 0.");
+        return -1;
+    }
+
+    if ((offset == offsetof(ControllerObject, limit)) && !(value > 0.0)) {
+        PyErr_SetString(PyExc_ValueError, "Output limit must be > 0.");
+        return -1;
+    }
+
+    pthread_mutex_lock(&self->lock);
+    *(double *)((char *)self + offset) = value;
+    pthread_mutex_unlock(&self->lock);
 
-    return Py_BuildValue("i", retval);
+    return 0;
 }
 
-static PyObject *rcGetI2CBusInUse(PyObject *self, PyObject *args) {
-    int state;
-    int bus;
 
-    if (!PyArg_ParseTuple(args, "i", &bus)) {
-        PyErr_SetString(PyExc_ValueError, "Integer argument (bus number) required.");
+static DiscreteFilterObject *rcDiscreteFilterAlloc(PyTypeObject *type, double dt) {
+    DiscreteFilterObject *self;
+
+    if (!((dt > 0.0) && isfinite(dt))) {
+        PyErr_SetString(PyExc_ValueError, "Time step dt must be > 0 s.");
         return NULL;
     }
 
-    if ((bus < 1) || (bus > 2)) {
-        PyErr_SetString(PyExc_ValueError, "Bus number must be 1 or 2.");
+    self = (DiscreteFilterObject *)type->tp_alloc(type, 0);
+    if (self == NULL)
         return NULL;
-    }
 
-    state = rc_i2c_get_in_use_state(bus);
+    self->dt = dt;
 
-    return Py_BuildValue("i", state);
+    return self;
 }
 
-static PyObject *rcReadI2CByte(PyObject *self, PyObject *args) {
-    int retval;
-    int bus;
-    int address;
-    uint8_t data;
-
-    if (!PyArg_ParseTuple(args, "ii", &bus, &address)) {
-        PyErr_SetString(PyExc_ValueError, "Two integer arguments (bus number, register address) required.");
+static PyObject *rcDiscreteFilterNew(PyTypeObject *type, PyObject *args, PyObject *kwds) {
+    static const char *const kwlist[] = {"num", "den", "dt", "min", "max", NULL};
+    PyObject *values[5] = {NULL, NULL, NULL, NULL, NULL};
+    double num[DFILTER_MAX_ORDER + 1];
+    double den[DFILTER_MAX_ORDER + 1];
+    double params[3] = {0.0, -INFINITY, INFINITY};
+    DiscreteFilterObject *self;
+    int num_len;
+    int den_len;
+    int i;
+
+    if (rcUnpackTupleArgs(args, kwds, kwlist, values) < 0)
         return NULL;
+
+    for (i = 0; i < 3; i++) {
+        if (values[2 + i] == NULL)
+            continue;
+        params[i] = PyFloat_AsDouble(values[2 + i]);
+        if ((params[i] == -1.0) && PyErr_Occurred())
+            break;
     }
 
-    if ((bus < 1) || (bus > 2)) {
-        PyErr_SetString(PyExc_ValueError, "Bus number must be 1 or 2.");
+    if ((values[0] == NULL) || (values[1] == NULL) || (values[2] == NULL) || (i < 3)) {
+        PyErr_Clear();
+        PyErr_SetString(PyExc_ValueError, "Numerator and denominator sequences, float argument (dt in s) and optional float arguments (min, max) required.");
         return NULL;
     }
 
-    if ((address < 0x00) || (address > 0xff)) {
-        PyErr_SetString(PyExc_ValueError, "Register address must be >= 0x00 and <= 0xff.");
+    if (!(params[1] < params[2])) {
+        PyErr_SetString(PyExc_ValueError, "Saturation min has to be < max.");
         return NULL;
     }
 
-    retval = rc_i2c_read_byte(bus, (uint8_t)address, &data);
+    num_len = rcCoefficientsFromObject(values[0], num, "Numerator");
+    if (num_len < 0)
+        return NULL;
+    den_len = rcCoefficientsFromObject(values[1], den, "Denominator");
+    if (den_len < 0)
+        return NULL;
 
-    if (retval < 0) {
-        PyErr_SetString(PyExc_ValueError, "Reading one byte from I²C device failed.");
+    if ((den[0] == 0.0) || (num_len > den_len)) {
+        PyErr_SetString(PyExc_ValueError, "Transfer function has to be proper (numerator not longer than denominator) with den[0] != 0.");
         return NULL;
     }
 
-    return Py_BuildValue("i", data);
+    self = rcDiscreteFilterAlloc(type, params[0]);
+    if (self == NULL)
+        return NULL;
+
+    dfilter_init(&self->filter, num, num_len, den, den_len, params[1], params[2]);
+
+    return (PyObject *)self;
 }
 
-static PyObject *rcReadI2CBytes(PyObject *self, PyObject *args) {
-    int retval;
-    int bus;
-    int address;
-    int length;
-    uint8_t **data = NULL;
+static void rcDiscreteFilterDealloc(DiscreteFilterObject *self) {
+    PyTypeObject *type = Py_TYPE(self);
 
-    if (!PyArg_ParseTuple(args, "iii", &bus, &address, &length)) {
-        PyErr_SetString(PyExc_ValueError, "Three integer arguments (bus number, register address, data length) required.");
-        return NULL;
-    }
+    type->tp_free(self);
+    Py_DECREF(type);
+}
 
-    if ((bus < 1) || (bus > 2)) {
-        PyErr_SetString(PyExc_ValueError, "Bus number must be 1 or 2.");
+static PyObject *rcDiscreteFilterButterworth(PyObject *cls, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames) {
+    static const char *const kwlist[] = {"order", "dt", "cutoff", "highpass", NULL};
+    PyObject *values[4] = {NULL, NULL, NULL, NULL};
+    DiscreteFilterObject *self;
+    int order;
+    double dt;
+    double cutoff;
+    int highpass = 0;
+
+    if ((rcUnpackArgs(args, nargs, kwnames, kwlist, values) < 0) ||
+        (values[0] == NULL) || (values[1] == NULL) || (values[2] == NULL) ||
+        (rcArgToInt(values[0], &order) < 0) ||
+        (((dt = PyFloat_AsDouble(values[1])) == -1.0) && PyErr_Occurred()) ||
+        (((cutoff = PyFloat_AsDouble(values[2])) == -1.0) && PyErr_Occurred()) ||
+        ((values[3] != NULL) && ((highpass = PyObject_IsTrue(values[3])) < 0))) {
+        PyErr_Clear();
+        PyErr_SetString(PyExc_ValueError, "Integer argument (order), float arguments (dt in s, cutoff in Hz) and optional highpass flag required.");
         return NULL;
     }
 
-    if ((address < 0x00) || (address > 0xff)) {
-        PyErr_SetString(PyExc_ValueError, "Register address must be >= 0x00 and <= 0xff.");
+    if ((order < 1) || (order > DFILTER_MAX_ORDER)) {
+        PyErr_Format(PyExc_ValueError, "Order has to be >= 1 and <= %d.", DFILTER_MAX_ORDER);
         return NULL;
     }
 
-    if ((length < 1) || (length > 128)) {
-        PyErr_SetString(PyExc_ValueError, "Data length must be > 0 and <= 128.");
+    self = rcDiscreteFilterAlloc((PyTypeObject *)cls, dt);
+    if (self == NULL)
         return NULL;
-    }
-
-    retval = rc_i2c_read_bytes(bus, (uint8_t)address, (uint8_t)length, *data);
-
-    printf("retval %d, read %s\n", retval, data);
 
-    if (retval < 0) {
-        PyErr_SetString(PyExc_ValueError, "Reading several bytes from I²C device failed.");
+    if (dfilter_butterworth(&self->filter, order, dt, cutoff, highpass) < 0) {
+        Py_DECREF(self);
+        PyErr_SetString(PyExc_ValueError, "Cutoff has to be > 0 and below the Nyquist frequency 0.5 / dt.");
         return NULL;
     }
 
-    //return Py_BuildValue("y", data);
-    return 0;
+    return (PyObject *)self;
 }
 
-static PyObject *rcReadI2CWord(PyObject *self, PyObject *args) {
-    int retval;
-    int bus;
-    int address;
-    uint16_t data;
-
-    if (!PyArg_ParseTuple(args, "ii", &bus, &address)) {
-        PyErr_SetString(PyExc_ValueError, "Two integer arguments (bus number, register address) required.");
+/*
+ * First order filters with time constant tau, discretized by backward
+ * Euler: y = a x + (1 - a) y' for the lowpass, y = b (y' + x - x') for
+ * the highpass.
+ */
+static PyObject *rcDiscreteFilterFirstOrder(PyObject *cls, PyObject *const *args, Py_ssize_t nargs, int highpass) {
+    DiscreteFilterObject *self;
+    double num[2];
+    double den[2];
+    double dt = -1.0;
+    double tau = -1.0;
+    double a;
+
+    if ((nargs != 2) || (((dt = PyFloat_AsDouble(args[0])) == -1.0) && PyErr_Occurred()) ||
+        (((tau = PyFloat_AsDouble(args[1])) == -1.0) && PyErr_Occurred())) {
+        PyErr_Clear();
+        PyErr_SetString(PyExc_ValueError, "Float arguments (dt in s, time constant tau in s) required.");
         return NULL;
     }
 
-    if ((bus < 1) || (bus > 2)) {
-        PyErr_SetString(PyExc_ValueError, "Bus number must be 1 or 2.");
+    if (!((tau > 0.0) && isfinite(tau))) {
+        PyErr_SetString(PyExc_ValueError, "Time constant tau must be > 0 s.");
         return NULL;
     }
 
-    if ((address < 0x00) || (address > 0xff)) {
-        PyErr_SetString(PyExc_ValueError, "Register address must be >= 0x00 and <= 0xff.");
+    self = rcDiscreteFilterAlloc((PyTypeObject *)cls, dt);
+    if (self == NULL)
         return NULL;
+
+    if (highpass) {
+        a = tau / (tau + dt);
+        num[0] = a;
+        num[1] = -a;
+        den[1] = -a;
+    } else {
+        a = dt / (tau + dt);
+        num[0] = a;
+        num[1] = 0.0;
+        den[1] = a - 1.0;
     }
+    den[0] = 1.0;
 
-    retval = rc_i2c_read_word(bus, (uint8_t)address, &data);
+    dfilter_init(&self->filter, num, 2, den, 2, -INFINITY, INFINITY);
 
-    if (retval < 0) {
-        PyErr_SetString(PyExc_ValueError, "Reading one word from I²C device failed.");
-        return NULL;
-    }
+    return (PyObject *)self;
+}
 
-    return Py_BuildValue("i", data);
+static PyObject *rcDiscreteFilterLowpass(PyObject *cls, PyObject *const *args, Py_ssize_t nargs) {
+    return rcDiscreteFilterFirstOrder(cls, args, nargs, 0);
 }
 
-static PyObject *rcReadI2CWords(PyObject *self, PyObject *args) {
-//int rc_i2c_read_words(int bus, uint8_t regAddr, uint8_t length, uint16_t *data);
-    
+static PyObject *rcDiscreteFilterHighpass(PyObject *cls, PyObject *const *args, Py_ssize_t nargs) {
+    return rcDiscreteFilterFirstOrder(cls, args, nargs, 1);
 }
 
-static PyObject *rcReadI2CBit(PyObject *self, PyObject *args) {
-    int retval;
-    int bus;
-    int address;
-    int bitnum;
-    uint8_t data;
+static PyObject *rcDiscreteFilterMarch(DiscreteFilterObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    double x;
 
-    if (!PyArg_ParseTuple(args, "iii", &bus, &address, &bitnum)) {
-        PyErr_SetString(PyExc_ValueError, "Three integer arguments (bus number, register address, bit number) required.");
+    if ((nargs != 1) || (((x = PyFloat_AsDouble(args[0])) == -1.0) && PyErr_Occurred())) {
+        PyErr_Clear();
+        PyErr_SetString(PyExc_ValueError, "Float argument (input) required.");
         return NULL;
     }
 
-    if ((bus < 1) || (bus > 2)) {
-        PyErr_SetString(PyExc_ValueError, "Bus number must be 1 or 2.");
-        return NULL;
+    self->steps++;
+
+    return PyFloat_FromDouble(dfilter_march(&self->filter, x));
+}
+
+/*
+ * Get a contiguous buffer of 'f' or 'd' values from obj; returns 1 for
+ * doubles, 0 for floats, -1 with a ValueError set.
+ */
+static int rcGetRealBuffer(PyObject *obj, Py_buffer *buffer, int flags, const char *name) {
+    if (PyObject_GetBuffer(obj, buffer, flags | PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) < 0) {
+        PyErr_Format(PyExc_ValueError, "%scontiguous buffer (%s) required.",
+                     (flags & PyBUF_WRITABLE) ? "Writable " : "", name);
+        return -1;
     }
 
-    if ((address < 0x00) || (address > 0xff)) {
-        PyErr_SetString(PyExc_ValueError, "Register address must be >= 0x00 and <= 0xff.");
+    if ((buffer->format != NULL) && (strcmp(buffer->format, "d") == 0))
+        return 1;
+    if ((buffer->format != NULL) && (strcmp(buffer->format, "f") == 0))
+        return 0;
+
+    PyBuffer_Release(buffer);
+    PyErr_Format(PyExc_ValueError, "Buffer (%s) has to hold float ('f') or double ('d') values.", name);
+    return -1;
+}
+
+static PyObject *rcDiscreteFilterApply(DiscreteFilterObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    Py_buffer in;
+    Py_buffer out;
+    int in_double;
+    int out_double;
+    Py_ssize_t count;
+    Py_ssize_t i;
+    double x;
+    double y;
+
+    if (nargs != 2) {
+        PyErr_SetString(PyExc_ValueError, "Input buffer and writable output buffer required.");
         return NULL;
     }
 
-    if ((bitnum < 0) || (bitnum > 15)) {
-        PyErr_SetString(PyExc_ValueError, "Bit number must be >= 0 and <= 15.");
+    in_double = rcGetRealBuffer(args[0], &in, PyBUF_SIMPLE, "in");
+    if (in_double < 0)
+        return NULL;
+    out_double = rcGetRealBuffer(args[1], &out, PyBUF_WRITABLE, "out");
+    if (out_double < 0) {
+        PyBuffer_Release(&in);
         return NULL;
     }
 
-    retval = rc_i2c_read_bit(bus, (uint8_t)address, (uint8_t)bitnum, &data);
-
-    if (retval < 0) {
-        PyErr_SetString(PyExc_ValueError, "Reading one bit from I²C device failed.");
-        return NULL;
+    count = in.len / in.itemsize;
+    if (count > out.len / out.itemsize)
+        count = out.len / out.itemsize;
+
+    // in and out may be the same buffer: every element is read before
+    // it is overwritten
+    for (i = 0; i < count; i++) {
+        x = in_double ? ((double *)in.buf)[i] : ((float *)in.buf)[i];
+        y = dfilter_march(&self->filter, x);
+        if (out_double)
+            ((double *)out.buf)[i] = y;
+        else
+            ((float *)out.buf)[i] = (float)y;
     }
+    self->steps += count;
 
-    return Py_BuildValue("i", data);
-}
+    PyBuffer_Release(&out);
+    PyBuffer_Release(&in);
 
-static PyObject *rcWriteI2CByte(PyObject *self, PyObject *args) {
-//int rc_i2c_write_byte(int bus, uint8_t regAddr, uint8_t data);
-    
+    return PyLong_FromSsize_t(count);
 }
 
-static PyObject *rcWriteI2CBytes(PyObject *self, PyObject *args) {
-//int rc_i2c_write_bytes(int bus, uint8_t regAddr, uint8_t length, uint8_t* data);
-    
-}
+static PyObject *rcDiscreteFilterPrefill(DiscreteFilterObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    double x;
 
-static PyObject *rcWriteI2CWord(PyObject *self, PyObject *args) {
-//int rc_i2c_write_word(int bus, uint8_t regAddr, uint16_t data);
-    
-}
+    if ((nargs != 1) || (((x = PyFloat_AsDouble(args[0])) == -1.0) && PyErr_Occurred())) {
+        PyErr_Clear();
+        PyErr_SetString(PyExc_ValueError, "Float argument (input) required.");
+        return NULL;
+    }
+
+    if (dfilter_prefill(&self->filter, x) < 0) {
+        PyErr_SetString(PyExc_RuntimeError, "Filter has no finite DC gain to prefill with.");
+        return NULL;
+    }
 
-static PyObject *rcWriteI2CWords(PyObject *self, PyObject *args) {
-//int rc_i2c_write_words(int bus, uint8_t regAddr, uint8_t length, uint16_t* data);
-    
+    Py_RETURN_NONE;
 }
 
-static PyObject *rcWriteI2CBit(PyObject *self, PyObject *args) {
-//int rc_i2c_write_bit(int bus, uint8_t regAddr, uint8_t bitNum, uint8_t data);
-    
+static PyObject *rcDiscreteFilterReset(DiscreteFilterObject *self, PyObject *args) {
+    dfilter_reset(&self->filter);
+    self->steps = 0;
+
+    Py_RETURN_NONE;
 }
 
-static PyObject *rcSendI2CByte(PyObject *self, PyObject *args) {
-    int retval;
-    int bus;
-    uint8_t data;
+static PyObject *rcDiscreteFilterGetCoefficients(DiscreteFilterObject *self, void *closure) {
+    const double *coeffs = closure ? self->filter.den : self->filter.num;
+    PyObject *result;
+    PyObject *value;
+    int i;
 
-    if (!PyArg_ParseTuple(args, "iB", &bus, &data)) {
-        PyErr_SetString(PyExc_ValueError, "Two integer arguments (bus number, data byte) required.");
+    result = PyTuple_New(self->filter.order + 1);
+    if (result == NULL)
         return NULL;
-    }
 
-    if ((bus < 1) || (bus > 2)) {
-        PyErr_SetString(PyExc_ValueError, "Bus number must be 1 or 2.");
-        return NULL;
+    for (i = 0; i <= self->filter.order; i++) {
+        value = PyFloat_FromDouble(coeffs[i]);
+        if (value == NULL) {
+            Py_DECREF(result);
+            return NULL;
+        }
+        PyTuple_SET_ITEM(result, i, value);
     }
 
-    retval = rc_i2c_send_byte(bus, data);
+    return result;
+}
 
-    return Py_BuildValue("i", retval);
+static PyObject *rcDiscreteFilterGetDouble(DiscreteFilterObject *self, void *closure) {
+    return PyFloat_FromDouble(*(double *)((char *)self + (size_t)closure));
 }
 
-static PyObject *rcSendI2CBytes(PyObject *self, PyObject *args) {
-    int retval;
-    int bus;
-    uint8_t length;
-    uint8_t *data;
+static int rcDiscreteFilterSetLimit(DiscreteFilterObject *self, PyObject *arg, void *closure) {
+    int is_max = ((size_t)closure == offsetof(DiscreteFilterObject, filter.max));
+    double value;
 
-    if (!PyArg_ParseTuple(args, "iBy*", &bus, &length, &data)) {
-        PyErr_SetString(PyExc_ValueError, "Three integer arguments (bus number, data length, data bytes) required.");
-        return NULL;
+    if ((arg == NULL) || (((value = PyFloat_AsDouble(arg)) == -1.0) && PyErr_Occurred()) || isnan(value)) {
+        PyErr_Clear();
+        PyErr_SetString(PyExc_ValueError, "Float value required.");
+        return -1;
     }
 
-    if ((bus < 1) || (bus > 2)) {
-        PyErr_SetString(PyExc_ValueError, "Bus number must be 1 or 2.");
-        return NULL;
+    if (is_max ? !(value > self->filter.min) : !(value < self->filter.max)) {
+        PyErr_SetString(PyExc_ValueError, "Saturation min has to be < max.");
+        return -1;
     }
 
-    retval = rc_i2c_send_bytes(bus, length, data);
+    if (is_max)
+        self->filter.max = value;
+    else
+        self->filter.min = value;
+
+    return 0;
+}
 
-    return Py_BuildValue("i", retval);
+static PyObject *rcDiscreteFilterGetInt(DiscreteFilterObject *self, void *closure) {
+    return closure ? PyLong_FromUnsignedLongLong(self->steps) : PyLong_FromLong(self->filter.order);
 }
 
 
-static PyObject *rcSetCPUFreq(PyObject *self, PyObject *args) {
+static PyObject *rcSetCPUFreq(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
     int retval;
     int frequency;
 
-    if (!PyArg_ParseTuple(args, "i", &frequency)) {
+    if ((nargs != 1) || (rcArgToInt(args[0], &frequency) < 0)) {
         PyErr_SetString(PyExc_ValueError, "Integer argument (frequency enumeration) required.");
         return NULL;
     }
@@ -1091,7 +6841,7 @@ static PyObject *rcSetCPUFreq(PyObject *self, PyObject *args) {
 
     retval = rc_set_cpu_freq(frequency);
 
-    return Py_BuildValue("i", retval);
+    return PyLong_FromLong(retval);
 }
 
 static PyObject *rcGetCPUFreq(PyObject *self, PyObject *args) {
@@ -1099,7 +6849,7 @@ static PyObject *rcGetCPUFreq(PyObject *self, PyObject *args) {
 
     frequency = rc_get_cpu_freq();
 
-    return Py_BuildValue("i", frequency);
+    return PyLong_FromLong(frequency);
 }
 
 static PyObject *rcGetBBModel(PyObject *self, PyObject *args) {
@@ -1107,7 +6857,159 @@ static PyObject *rcGetBBModel(PyObject *self, PyObject *args) {
 
     model = rc_get_bb_model();
 
-    return Py_BuildValue("i", model);
+    return PyLong_FromLong(model);
+}
+
+
+static void rcRecordCall(Py_ssize_t index, uint64_t start) {
+    method_stats_t *stats = &method_stats[index];
+    uint64_t elapsed;
+    uint64_t max;
+    int bucket;
+
+    elapsed = rcNanosMonotonic() - start;
+
+    bucket = (elapsed == 0) ? 0 : 64 - __builtin_clzll(elapsed);
+    if (bucket >= STATS_BUCKETS)
+        bucket = STATS_BUCKETS - 1;
+
+    atomic_fetch_add_explicit(&stats->calls, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stats->total_ns, elapsed, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stats->buckets[bucket], 1, memory_order_relaxed);
+
+    max = atomic_load_explicit(&stats->max_ns, memory_order_relaxed);
+    while ((elapsed > max) &&
+           !atomic_compare_exchange_weak_explicit(&stats->max_ns, &max, elapsed,
+                                                  memory_order_relaxed, memory_order_relaxed))
+        ;
+}
+
+/*
+ * Trampolines for the three calling conventions used in the method
+ * table. self is the index of the wrapped entry in RoboticsCapeMethods.
+ */
+static PyObject *rcTimedNoArgs(PyObject *self, PyObject *args) {
+    Py_ssize_t index = PyLong_AsSsize_t(self);
+    PyCFunction func = RoboticsCapeMethods[index].ml_meth;
+    PyObject *result;
+    uint64_t start;
+
+    if (!atomic_load_explicit(&stats_enabled, memory_order_relaxed))
+        return func(self, args);
+
+    start = rcNanosMonotonic();
+    result = func(self, args);
+    rcRecordCall(index, start);
+
+    return result;
+}
+
+static PyObject *rcTimedFastcall(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    Py_ssize_t index = PyLong_AsSsize_t(self);
+    _PyCFunctionFast func = (_PyCFunctionFast)(void (*)(void))RoboticsCapeMethods[index].ml_meth;
+    PyObject *result;
+    uint64_t start;
+
+    if (!atomic_load_explicit(&stats_enabled, memory_order_relaxed))
+        return func(self, args, nargs);
+
+    start = rcNanosMonotonic();
+    result = func(self, args, nargs);
+    rcRecordCall(index, start);
+
+    return result;
+}
+
+static PyObject *rcTimedFastcallKeywords(PyObject *self, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames) {
+    Py_ssize_t index = PyLong_AsSsize_t(self);
+    _PyCFunctionFastWithKeywords func = (_PyCFunctionFastWithKeywords)(void (*)(void))RoboticsCapeMethods[index].ml_meth;
+    PyObject *result;
+    uint64_t start;
+
+    if (!atomic_load_explicit(&stats_enabled, memory_order_relaxed))
+        return func(self, args, nargs, kwnames);
+
+    start = rcNanosMonotonic();
+    result = func(self, args, nargs, kwnames);
+    rcRecordCall(index, start);
+
+    return result;
+}
+
+static PyObject *rcEnableStats(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    int enable;
+
+    if ((nargs != 1) || (rcArgToInt(args[0], &enable) < 0)) {
+        PyErr_SetString(PyExc_ValueError, "Integer argument (off = 0, on = 1) required.");
+        return NULL;
+    }
+
+    if ((enable < 0) || (enable > 1)) {
+        PyErr_SetString(PyExc_ValueError, "Argument has to be off (0) or on (1).");
+        return NULL;
+    }
+
+    atomic_store(&stats_enabled, enable);
+
+    return PyLong_FromLong(0);
+}
+
+static PyObject *rcGetStats(PyObject *self, PyObject *args) {
+    PyObject *result;
+    PyObject *entry;
+    PyObject *histogram;
+    Py_ssize_t i;
+    int k;
+    uint64_t calls;
+
+    result = PyDict_New();
+    if (result == NULL)
+        return NULL;
+
+    for (i = 0; i < (Py_ssize_t)NUM_METHODS; i++) {
+        calls = atomic_load(&method_stats[i].calls);
+        if (calls == 0)
+            continue;
+
+        histogram = PyTuple_New(STATS_BUCKETS);
+        if (histogram == NULL) {
+            Py_DECREF(result);
+            return NULL;
+        }
+        for (k = 0; k < STATS_BUCKETS; k++)
+            PyTuple_SET_ITEM(histogram, k,
+                             PyLong_FromUnsignedLongLong(atomic_load(&method_stats[i].buckets[k])));
+
+        entry = Py_BuildValue("{s:K,s:K,s:K,s:N}",
+                              "calls", (unsigned long long)calls,
+                              "total_ns", (unsigned long long)atomic_load(&method_stats[i].total_ns),
+                              "max_ns", (unsigned long long)atomic_load(&method_stats[i].max_ns),
+                              "histogram", histogram);
+        if ((entry == NULL) ||
+            (PyDict_SetItemString(result, RoboticsCapeMethods[i].ml_name, entry) < 0)) {
+            Py_XDECREF(entry);
+            Py_DECREF(result);
+            return NULL;
+        }
+        Py_DECREF(entry);
+    }
+
+    return result;
+}
+
+static PyObject *rcResetStats(PyObject *self, PyObject *args) {
+    Py_ssize_t i;
+    int k;
+
+    for (i = 0; i < (Py_ssize_t)NUM_METHODS; i++) {
+        atomic_store(&method_stats[i].calls, 0);
+        atomic_store(&method_stats[i].total_ns, 0);
+        atomic_store(&method_stats[i].max_ns, 0);
+        for (k = 0; k < STATS_BUCKETS; k++)
+            atomic_store(&method_stats[i].buckets[k], 0);
+    }
+
+    return PyLong_FromLong(0);
 }
 
 
@@ -1116,10 +7018,117 @@ PyInit__roboticscape(void)
 {
 	PyObject* m;
 
+	PyObject* name;
+	PyObject* index;
+	PyObject* func;
+	Py_ssize_t i;
+	pthread_condattr_t condattr;
+
 	m = PyModule_Create(&RoboticsCapeModule);
 
     if (m == NULL)
         return NULL;
 
+    name = PyModule_GetNameObject(m);
+    if (name == NULL) {
+        Py_DECREF(m);
+        return NULL;
+    }
+
+    // Replace every function by a timing trampoline bound to its index
+    for (i = 0; i < (Py_ssize_t)NUM_METHODS; i++) {
+        timed_methods[i] = RoboticsCapeMethods[i];
+        if (timed_methods[i].ml_flags == METH_NOARGS)
+            timed_methods[i].ml_meth = rcTimedNoArgs;
+        else if (timed_methods[i].ml_flags == METH_FASTCALL)
+            timed_methods[i].ml_meth = (PyCFunction)rcTimedFastcall;
+        else if (timed_methods[i].ml_flags == (METH_FASTCALL | METH_KEYWORDS))
+            timed_methods[i].ml_meth = (PyCFunction)rcTimedFastcallKeywords;
+        else {
+            // A trampoline of the wrong signature would crash on call
+            PyErr_Format(PyExc_SystemError, "%s: no timing trampoline for method flags 0x%x.",
+                         timed_methods[i].ml_name, timed_methods[i].ml_flags);
+            Py_DECREF(name);
+            Py_DECREF(m);
+            return NULL;
+        }
+
+        index = PyLong_FromSsize_t(i);
+        if (index == NULL) {
+            Py_DECREF(name);
+            Py_DECREF(m);
+            return NULL;
+        }
+        func = PyCFunction_NewEx(&timed_methods[i], index, name);
+        Py_DECREF(index);
+        if ((func == NULL) || (PyModule_AddObject(m, timed_methods[i].ml_name, func) < 0)) {
+            Py_XDECREF(func);
+            Py_DECREF(name);
+            Py_DECREF(m);
+            return NULL;
+        }
+    }
+    Py_DECREF(name);
+
+    DSMFrameType = PyStructSequence_NewType(&DSMFrameDesc);
+    if (DSMFrameType == NULL) {
+        Py_DECREF(m);
+        return NULL;
+    }
+    Py_INCREF(DSMFrameType);
+    PyModule_AddObject(m, "DSMFrame", (PyObject *)DSMFrameType);
+
+    IMUSampleType = PyStructSequence_NewType(&IMUSampleDesc);
+    if (IMUSampleType == NULL) {
+        Py_DECREF(m);
+        return NULL;
+    }
+    Py_INCREF(IMUSampleType);
+    PyModule_AddObject(m, "IMUSample", (PyObject *)IMUSampleType);
+
+    GPSFixType = PyStructSequence_NewType(&GPSFixDesc);
+    if (GPSFixType == NULL) {
+        Py_DECREF(m);
+        return NULL;
+    }
+    Py_INCREF(GPSFixType);
+    PyModule_AddObject(m, "GPSFix", (PyObject *)GPSFixType);
+
+    EncoderEstimateType = PyStructSequence_NewType(&EncoderEstimateDesc);
+    if (EncoderEstimateType == NULL) {
+        Py_DECREF(m);
+        return NULL;
+    }
+    Py_INCREF(EncoderEstimateType);
+    PyModule_AddObject(m, "EncoderEstimate", (PyObject *)EncoderEstimateType);
+
+    ControllerType = (PyTypeObject *)PyType_FromSpec(&ControllerSpec);
+    if (ControllerType == NULL) {
+        Py_DECREF(m);
+        return NULL;
+    }
+    Py_INCREF(ControllerType);
+    PyModule_AddObject(m, "Controller", (PyObject *)ControllerType);
+
+    DiscreteFilterType = (PyTypeObject *)PyType_FromSpec(&DiscreteFilterSpec);
+    if (DiscreteFilterType == NULL) {
+        Py_DECREF(m);
+        return NULL;
+    }
+    Py_INCREF(DiscreteFilterType);
+    PyModule_AddObject(m, "DiscreteFilter", (PyObject *)DiscreteFilterType);
+
+    // rcWaitDSMFrame deadlines are taken from CLOCK_MONOTONIC
+    pthread_condattr_init(&condattr);
+    pthread_condattr_setclock(&condattr, CLOCK_MONOTONIC);
+    pthread_cond_init(&dsm_service.cond, &condattr);
+    pthread_condattr_destroy(&condattr);
+
+#ifdef ROBOTICSCAPE_SIMULATION
+    PyModule_AddIntConstant(m, "RC_SIMULATION", 1);
+#else
+    PyModule_AddIntConstant(m, "RC_SIMULATION", 0);
+#endif
+
 	return m;
 }
@@ -7,11 +7,339 @@
  */
 
 #include <Python.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <time.h>
 #include <roboticscape.h>
+#include "_rcringbuffer.h"
+#include "_rcgpsparser.h"
+#include "_rcdiscretefilter.h"
 
 // Constants
 #define RED_LED 	66	// gpio2.2	P8.7
 #define GRN_LED 	67	// gpio2.3	P8.8
+#define BMP_I2C_BUS	2	// I²C bus the BMP280 barometer is attached to
+#define IMU_I2C_BUS	2	// I²C bus the MPU-9250 IMU is attached to
+#define IMU_I2C_ADDRESS	0x68	// MPU-9250 device address
+#define I2C_MAX_BYTES	128	// longest single I²C register transfer
+#define SPI_SLAVES	2	// slave select lines 1-2 of SPI1
+#define SPI_MIN_HZ	1000	// slowest SPI clock the library accepts
+#define SPI_MAX_HZ	24000000	// fastest SPI clock the library accepts
+#define SPI_MAX_BYTES	4096	// longest single SPI transfer (spidev bufsiz)
+#define UART_BUSES	6	// UART buses 0-5
+#define UART_MAX_TIMEOUT	25.5	// longest read timeout the library accepts (s)
+#define GPS_READ_LEN	256	// most UART bytes the GPS service parses per read
+#define GPS_POLL_MS	100	// GPS service checks for stop at least this often
+#define ADC_CHANNELS	7	// ADC channels 0-6
+#define STATS_BUCKETS	32	// log2 latency buckets, the last one open ended
+#define SERVO_CHANNELS	8	// servo/ESC channels 1-8
+#define DSM_CHANNELS	9	// most channels a DSM frame can carry
+#define DSM_FRAME_LEN	12	// rcGetDSMFrame buffer: channels, resolution, nanos, active
+#define DSM_MAX_TIMEOUT	1e6	// rcWaitDSMFrame waits without deadline from here on (s)
+#define BMP_SAMPLE_LEN	5	// rcReadBarometerSamples row: temperature, pressure, altitude, filtered altitude, vertical speed
+#define ENCODER_ESTIMATE_LEN	12	// rcGetEncoderEstimates buffer: positions, velocities, accelerations of channels 1-4
+#define IMU_SAMPLE_LEN	16	// rcReadIMUSamples row: accel xyz, gyro xyz, mag xyz, quaternion wxyz, Tait-Bryan xyz
+#define IMU_FIFO_SIZE	512	// bytes the MPU-9250 FIFO holds
+#define IMU_FIFO_RECORD	12	// FIFO record: accel xyz, gyro xyz as big-endian int16
+#define IMU_FIFO_LEN	6	// rcReadIMUFIFO row: accel xyz, gyro xyz
+#define DSM_RECORD_MAGIC	"RCDSM01\n"	// 8 byte header of DSM recordings
+
+// Altitude filters of the barometer path, see AltitudeFilter in __init__.py
+#define ALT_FILTER_NONE		0
+#define ALT_FILTER_LOWPASS	1	// a: time constant (s)
+#define ALT_FILTER_ALPHA_BETA	2	// a: alpha, b: beta
+#define ALT_FILTER_KALMAN	3	// a: acceleration noise (m²/s⁴), b: altitude noise (m²)
+
+// MPU-9250 registers and bits used for FIFO streaming
+#define MPU_SMPLRT_DIV			0x19
+#define MPU_FIFO_EN			0x23
+#define MPU_FIFO_ACCEL_GYRO		0x78	// accel, gyro x, y, z
+#define MPU_INT_STATUS			0x3a
+#define MPU_INT_STATUS_FIFO_OFLOW	0x10
+#define MPU_USER_CTRL			0x6a
+#define MPU_USER_CTRL_FIFO_EN		0x40
+#define MPU_USER_CTRL_FIFO_RST		0x04
+#define MPU_FIFO_COUNTH			0x72
+#define MPU_FIFO_R_W			0x74
+
+// Controller kinds
+#define CONTROLLER_PID		0	// Controller(dt, kp, ki, kd, tau, limit)
+#define CONTROLLER_TF		1	// Controller.transfer_function(num, den, dt, limit)
+
+// Pulse types of the servo service, see ServoMode in __init__.py
+#define SERVO_MODE_SERVO	0	// rc_send_servo_pulse_normalized
+#define SERVO_MODE_ESC		1	// rc_send_esc_pulse_normalized
+#define SERVO_MODE_ONESHOT	2	// rc_send_oneshot_pulse_normalized
+
+
+// Type definitions
+typedef struct adc_sample_t {
+    uint64_t nanos;             // CLOCK_MONOTONIC time of the sample
+    float volts[ADC_CHANNELS];  // one value per selected channel
+} adc_sample_t;
+
+typedef struct encoder_estimate_t {
+    uint64_t nanos;             // CLOCK_MONOTONIC time of the sample, 0 = none yet
+    long position[4];           // counts
+    double velocity[4];         // counts/s
+    double acceleration[4];     // counts/s²
+} encoder_estimate_t;
+
+typedef struct encoder_track_t {
+    long position;              // at the previous sample
+    long edge_position;         // at the last count change
+    uint64_t edge_nanos;        // time of the last count change
+    double period_velocity;     // counts over the time between count changes
+    double velocity;            // last filtered estimate
+    uint64_t jumps;             // encoder_estimator.jumps at the last reset
+    discrete_filter_t velocity_filter;
+    discrete_filter_t acceleration_filter;
+} encoder_track_t;
+
+typedef struct bmp_sample_t {
+    uint64_t nanos;             // CLOCK_MONOTONIC time of the reading
+    float temperature;          // °C
+    float pressure_pa;
+    float altitude_m;
+    float filtered_altitude_m;  // altitude_m if no filter is configured
+    float vertical_speed_ms;    // NaN if no filter is configured
+} bmp_sample_t;
+
+typedef struct imu_sample_t {
+    uint64_t nanos;             // CLOCK_MONOTONIC time of the DMP interrupt
+    float accel[3];             // m/s²
+    float gyro[3];              // °/s
+    float mag[3];               // µT, NaN without magnetometer
+    float quat[4];              // w, x, y, z; fused with the magnetometer if enabled
+    float tait_bryan[3];        // rad; fused with the magnetometer if enabled
+} imu_sample_t;
+
+typedef struct altitude_filter_t {
+    int mode;                   // ALT_FILTER_*
+    float a;                    // mode parameters, see ALT_FILTER_*
+    float b;
+    int primed;                 // 0 until the first measurement
+    uint64_t nanos;             // time of the last measurement
+    double altitude;
+    double speed;
+    double p[2][2];             // Kalman error covariance
+} altitude_filter_t;
+
+typedef struct dsm_record_t {
+    uint64_t nanos;                     // CLOCK_MONOTONIC time since recording started
+    float normalized[DSM_CHANNELS];
+    int16_t raw[DSM_CHANNELS];
+    uint8_t num_channels;
+    uint8_t resolution;
+} dsm_record_t;                         // 64 bytes, stored as is in recordings
+
+typedef struct loop_stats_t {
+    uint64_t ticks;             // callback invocations
+    uint64_t overruns;          // deadlines missed because a tick ran too long
+    uint64_t max_latency_ns;    // worst wakeup delay after a deadline
+    uint64_t max_exec_ns;       // worst time from wakeup to motors applied
+    uint64_t total_exec_ns;
+} loop_stats_t;
+
+/*
+ * Instances of the Controller type. The gains, setpoint, state and last
+ * step are guarded by lock; the binding (encoder, motor, scale,
+ * velocity) and dt do not change while running.
+ */
+typedef struct ControllerObject {
+    PyObject_HEAD
+    int mode;                   // CONTROLLER_*
+    double dt;                  // s
+    double kp;
+    double ki;
+    double kd;
+    double tau;                 // derivative filter time constant (s)
+    double limit;               // output saturates at ±limit
+    double setpoint;
+    discrete_filter_t tf;       // CONTROLLER_TF only
+    int primed;                 // 0 until the first step after a reset
+    double integral;
+    double derivative;
+    double previous;            // measurement of the previous step
+    double measurement;         // of the last step
+    double output;              // of the last step
+    int encoder;                // 1-4, 0 = not bound
+    int motor;                  // 1-4, 0 = none
+    double scale;               // measurement per encoder count
+    int velocity;               // 1: measure counts/s rather than counts
+    pthread_mutex_t lock;
+    pthread_t thread;
+    _Atomic int running;
+    int stopping;               // 1 while stop() joins the thread; GIL held
+    _Atomic uint64_t ticks;
+    _Atomic uint64_t overruns;
+    struct ControllerObject *next_running;
+    struct ControllerObject *prev_running;
+} ControllerObject;
+
+/*
+ * Instances of the DiscreteFilter type; only used with the GIL held.
+ */
+typedef struct DiscreteFilterObject {
+    PyObject_HEAD
+    double dt;                  // s
+    discrete_filter_t filter;
+    uint64_t steps;             // inputs since creation or reset
+} DiscreteFilterObject;
+
+typedef struct method_stats_t {
+    _Atomic uint64_t calls;
+    _Atomic uint64_t total_ns;
+    _Atomic uint64_t max_ns;
+    _Atomic uint64_t buckets[STATS_BUCKETS];  // bucket k: < 2^k ns
+} method_stats_t;
+
+
+// Struct sequence definitions
+static PyStructSequence_Field DSMFrameFields[] = {
+    {"channels", "tuple of channel values, normalized or raw"},
+    {"resolution", "DSM resolution in bits, 0 if unknown"},
+    {"nanos_since_last_packet", "nanoseconds since the frame has been received"},
+    {"active", "1 - no timeouts or packet errors | 0 - otherwise"},
+    {NULL, NULL}
+};
+
+static PyStructSequence_Desc DSMFrameDesc = {
+    "_roboticscape.DSMFrame",
+    "One coherent DSM frame as returned by rcGetDSMFrame().",
+    DSMFrameFields,
+    4
+};
+
+static PyStructSequence_Field IMUSampleFields[] = {
+    {"timestamp", "CLOCK_MONOTONIC time of the DMP interrupt in nanoseconds"},
+    {"accel", "(x, y, z) acceleration in m/s²"},
+    {"gyro", "(x, y, z) angular rate in °/s"},
+    {"mag", "(x, y, z) magnetic field in µT, NaN without magnetometer"},
+    {"quaternion", "(w, x, y, z) orientation quaternion"},
+    {"tait_bryan", "(pitch, roll, yaw) Tait-Bryan angles in rad"},
+    {NULL, NULL}
+};
+
+static PyStructSequence_Desc IMUSampleDesc = {
+    "_roboticscape.IMUSample",
+    "One DMP sample as returned by rcGetIMUSample().",
+    IMUSampleFields,
+    6
+};
+
+static PyStructSequence_Field GPSFixFields[] = {
+    {"timestamp", "CLOCK_MONOTONIC time the fix has been received in nanoseconds"},
+    {"latitude", "latitude in °, north positive, NaN without fix"},
+    {"longitude", "longitude in °, east positive, NaN without fix"},
+    {"altitude", "altitude above mean sea level in m, NaN without fix"},
+    {"speed", "speed over ground in m/s, NaN if unknown"},
+    {"heading", "course over ground in ° from true north, NaN if unknown"},
+    {"quality", "fix quality as in NMEA GGA: 0 - none | 1 - GNSS | 2 - DGNSS | 4 - RTK | 5 - RTK float | 6 - estimated"},
+    {"satellites", "number of satellites used"},
+    {NULL, NULL}
+};
+
+static PyStructSequence_Desc GPSFixDesc = {
+    "_roboticscape.GPSFix",
+    "Latest GPS fix as returned by rcGetGPSFix().",
+    GPSFixFields,
+    8
+};
+
+static PyStructSequence_Field EncoderEstimateFields[] = {
+    {"timestamp", "CLOCK_MONOTONIC time of the sample in nanoseconds"},
+    {"position", "positions of channels 1-4 in counts"},
+    {"velocity", "velocities of channels 1-4 in counts/s"},
+    {"acceleration", "accelerations of channels 1-4 in counts/s²"},
+    {NULL, NULL}
+};
+
+static PyStructSequence_Desc EncoderEstimateDesc = {
+    "_roboticscape.EncoderEstimate",
+    "Latest encoder estimates as returned by rcGetEncoderEstimates().",
+    EncoderEstimateFields,
+    4
+};
+
+
+// Helper headers
+static int rcFloatsFromObject(PyObject *obj, float *values, Py_ssize_t maxlen, Py_ssize_t *length);
+static int rcLongsToBuffer(PyObject *out, const long *values, Py_ssize_t count);
+static uint64_t rcNanosMonotonic(void);
+static void rcSleepUntil(uint64_t nanos);
+static int rcArgToInt(PyObject *arg, int *value);
+static int rcArgToFloat(PyObject *arg, float *value);
+static int rcUnpackArgs(PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames,
+                        const char *const *kwlist, PyObject **values);
+static void rcEncoderTrackReset(encoder_track_t *track, long position, uint64_t nanos);
+static double rcEncoderTrackVelocity(encoder_track_t *track, long position, uint64_t nanos,
+                                     double dt, int period_counts);
+static void *rcEncoderEstimatorThread(void *arg);
+static void rcStopEncoderEstimatorThread(void);
+static void *rcADCSamplerThread(void *arg);
+static void rcStopADCSamplerThread(void);
+static void *rcLoopThread(void *arg);
+static PyObject *rcLoopStatsDict(void);
+static int rcCheckPulses(int mode, const float *values, Py_ssize_t count);
+static int rcSendPulses(int mode, const float *values, int count);
+static PyObject *rcSendPulseVector(int mode, PyObject *const *args, Py_ssize_t nargs);
+static void *rcServoServiceThread(void *arg);
+static void rcStopServoServiceThread(void);
+static int rcDSMDataFunc(void);
+static int rcDSMChRaw(int channel);
+static float rcDSMChNormalized(int channel);
+static int rcDSMNumChannels(void);
+static int rcDSMResolution(void);
+static uint64_t rcDSMNanosSinceLastPacket(void);
+static int rcDSMActive(void);
+static void *rcDSMRecorderThread(void *arg);
+static int rcStopDSMRecorderThread(void);
+static void *rcDSMReplayThread(void *arg);
+static void rcStopDSMReplayThread(void);
+static void rcDSMFrameRead(void);
+static void rcAltitudeFilterStep(altitude_filter_t *filter, uint64_t nanos, float altitude);
+static int rcBarometerSample(bmp_sample_t *sample);
+static void *rcBarometerThread(void *arg);
+static void rcStopBarometerThread(void);
+static void *rcDSMCallbackThread(void *arg);
+static int rcIMUConfigFromArgs(PyObject *const *args, Py_ssize_t nargs, rc_imu_config_t *conf);
+static int rcIMUInterruptFunc(void);
+static void rcIMUSampleToRow(const imu_sample_t *sample, float *row);
+static PyObject *rcIMUSampleObject(const imu_sample_t *sample);
+static PyObject *rcIMUVector(int (*read)(rc_imu_data_t *), const float *vector, const char *message);
+static void *rcIMUCallbackThread(void *arg);
+static void rcStopIMUCallbackThread(void);
+static int rcStopIMUService(void);
+static int rcIMUFIFOConfigure(int enable, int divider);
+static int rcIMUFIFOCount(void);
+static void rcDecodeIMUFIFO(const uint8_t *raw, size_t count, float accel_scale, float gyro_scale, float *out);
+static int rcCheckI2COwner(int bus);
+static int rcCheckSPISlave(int slave);
+static int rcCheckUARTBus(int bus);
+static int rcUARTRead(int bus, char *buf, int length, double timeout);
+static PyObject *rcUARTReadInto(int bus, PyObject *data, double timeout, int line);
+static int rcCheckUARTOwner(int bus);
+static void *rcGPSServiceThread(void *arg);
+static int rcStopGPSServiceThread(void);
+static int rcUnpackTupleArgs(PyObject *args, PyObject *kwds, const char *const *kwlist, PyObject **values);
+static int rcCoefficientsFromObject(PyObject *obj, double *coeffs, const char *name);
+static double rcControllerStep(ControllerObject *self, double measurement);
+static void rcControllerResetState(ControllerObject *self);
+static void *rcControllerThread(void *arg);
+static void rcStopControllerThread(ControllerObject *self);
+static void rcStopControllers(void);
+static ControllerObject *rcControllerAlloc(PyTypeObject *type, int mode, double dt, double limit);
+static DiscreteFilterObject *rcDiscreteFilterAlloc(PyTypeObject *type, double dt);
+static PyObject *rcDiscreteFilterFirstOrder(PyObject *cls, PyObject *const *args, Py_ssize_t nargs, int highpass);
+static int rcGetRealBuffer(PyObject *obj, Py_buffer *buffer, int flags, const char *name);
+static void rcStopDSMCallbackThread(void);
+static void rcReadDSMFrame(int normalized, double *values, int *num_channels, uint64_t *nanos);
+static void rcRecordCall(Py_ssize_t index, uint64_t start);
+static PyObject *rcTimedNoArgs(PyObject *self, PyObject *args);
+static PyObject *rcTimedFastcall(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcTimedFastcallKeywords(PyObject *self, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames);
 
 
 // Method headers
@@ -19,47 +347,68 @@ static PyObject *rcInitialize(PyObject *self, PyObject *args);
 static PyObject *rcCleanup(PyObject *self, PyObject *args);
 
 static PyObject *rcGetState(PyObject *self, PyObject *args);
-static PyObject *rcSetState(PyObject *self, PyObject *args);
+static PyObject *rcSetState(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
 
-static PyObject *rcGetLED(PyObject *self, PyObject *args);
-static PyObject *rcSetLED(PyObject *self, PyObject *args);
-static PyObject *rcBlinkLED(PyObject *self, PyObject *args);
+static PyObject *rcGetLED(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcSetLED(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcBlinkLED(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
 
-static PyObject *rcGetButton(PyObject *self, PyObject *args);
+static PyObject *rcGetButton(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
 
 static PyObject *rcEnableMotors(PyObject *self, PyObject *args);
 static PyObject *rcDisableMotors(PyObject *self, PyObject *args);
-static PyObject *rcSetMotor(PyObject *self, PyObject *args);
-static PyObject *rcSetMotorAll(PyObject *self, PyObject *args);
-static PyObject *rcSetMotorFreeSpin(PyObject *self, PyObject *args);
+static PyObject *rcSetMotor(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcSetMotorAll(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcSetMotors(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcSetMotorFreeSpin(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
 static PyObject *rcSetMotorFreeSpinAll(PyObject *self, PyObject *args);
-static PyObject *rcSetMotorBrake(PyObject *self, PyObject *args);
+static PyObject *rcSetMotorBrake(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
 static PyObject *rcSetMotorBrakeAll(PyObject *self, PyObject *args);
 
-static PyObject *rcGetEncoderPos(PyObject *self, PyObject *args);
-static PyObject *rcSetEncoderPos(PyObject *self, PyObject *args);
+static PyObject *rcGetEncoderPos(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcGetEncoderPosAll(PyObject *self, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames);
+static PyObject *rcSetEncoderPos(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcStartEncoderEstimator(PyObject *self, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames);
+static PyObject *rcStopEncoderEstimator(PyObject *self, PyObject *args);
+static PyObject *rcGetEncoderEstimates(PyObject *self, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames);
+static PyObject *rcGetEncoderEstimatorStatus(PyObject *self, PyObject *args);
 
 static PyObject *rcBatteryVoltage(PyObject *self, PyObject *args);
 static PyObject *rcDCJackVoltage(PyObject *self, PyObject *args);
 
-static PyObject *rcADCRaw(PyObject *self, PyObject *args);
-static PyObject *rcADCVolt(PyObject *self, PyObject *args);
+static PyObject *rcADCRaw(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcADCVolt(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcStartADCSampler(PyObject *self, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames);
+static PyObject *rcStopADCSampler(PyObject *self, PyObject *args);
+static PyObject *rcReadADCSamples(PyObject *self, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames);
+static PyObject *rcGetADCSamplerStatus(PyObject *self, PyObject *args);
 
 static PyObject *rcEnableServoPowerRail(PyObject *self, PyObject *args);
 static PyObject *rcDisableServoPowerRail(PyObject *self, PyObject *args);
-static PyObject *rcSendServoPulseUs(PyObject *self, PyObject *args);
-static PyObject *rcSendServoPulseUsAll(PyObject *self, PyObject *args);
-static PyObject *rcSendServoPulseNormalized(PyObject *self, PyObject *args);
-static PyObject *rcSendServoPulseNormalizedAll(PyObject *self, PyObject *args);
-static PyObject *rcSendESCPulseNormalized(PyObject *self, PyObject *args);
-static PyObject *rcSendESCPulseNormalizedAll(PyObject *self, PyObject *args);
-static PyObject *rcSendOneshotPulseNormalized(PyObject *self, PyObject *args);
-static PyObject *rcSendOneshotPulseNormalizedAll(PyObject *self, PyObject *args);
+static PyObject *rcSendServoPulseUs(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcSendServoPulseUsAll(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcSendServoPulseNormalized(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcSendServoPulseNormalizedAll(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcSendESCPulseNormalized(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcSendESCPulseNormalizedAll(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcSendOneshotPulseNormalized(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcSendOneshotPulseNormalizedAll(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcSendServoPulseNormalizedVector(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcSendESCPulseNormalizedVector(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcSendOneshotPulseNormalizedVector(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcStartServoService(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcStopServoService(PyObject *self, PyObject *args);
+static PyObject *rcSetServoSetpoints(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcGetServoServiceStatus(PyObject *self, PyObject *args);
+
+static PyObject *rcRunLoop(PyObject *self, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames);
+static PyObject *rcStopLoop(PyObject *self, PyObject *args);
+static PyObject *rcGetLoopStats(PyObject *self, PyObject *args);
 
 static PyObject *rcInitializeDSM(PyObject *self, PyObject *args);
 static PyObject *rcStopDSMService(PyObject *self, PyObject *args);
-static PyObject *rcGetDSMChRaw(PyObject *self, PyObject *args);
-static PyObject *rcGetDSMChNormalized(PyObject *self, PyObject *args);
+static PyObject *rcGetDSMChRaw(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcGetDSMChNormalized(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
 static PyObject *rcIsDSMNewData(PyObject *self, PyObject *args);
 static PyObject *rcIsDSMActive(PyObject *self, PyObject *args);
 static PyObject *rcNanosSinceLastDSMPacket(PyObject *self, PyObject *args);
@@ -67,43 +416,128 @@ static PyObject *rcGetDSMResolution(PyObject *self, PyObject *args);
 static PyObject *rcNumDSMChannels(PyObject *self, PyObject *args);
 static PyObject *rcBindDSM(PyObject *self, PyObject *args);
 static PyObject *rcCalibrateDSMRoutine(PyObject *self, PyObject *args);
+static PyObject *rcWaitDSMFrame(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcSetDSMCallback(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcGetDSMFrame(PyObject *self, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames);
+static PyObject *rcStartDSMRecording(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcStopDSMRecording(PyObject *self, PyObject *args);
+static PyObject *rcStartDSMReplay(PyObject *self, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames);
+static PyObject *rcStopDSMReplay(PyObject *self, PyObject *args);
 
-// TODO: IMU methods
+static PyObject *_rcInitializeIMU(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *_rcInitializeIMUDMP(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcPowerOffIMU(PyObject *self, PyObject *args);
+static PyObject *rcReadAccelData(PyObject *self, PyObject *args);
+static PyObject *rcReadGyroData(PyObject *self, PyObject *args);
+static PyObject *rcReadMagData(PyObject *self, PyObject *args);
+static PyObject *rcReadIMUTemp(PyObject *self, PyObject *args);
+static PyObject *rcCalibrateGyroRoutine(PyObject *self, PyObject *args);
+static PyObject *rcCalibrateMagRoutine(PyObject *self, PyObject *args);
+static PyObject *rcIsGyroCalibrated(PyObject *self, PyObject *args);
+static PyObject *rcIsMagCalibrated(PyObject *self, PyObject *args);
+static PyObject *rcWasLastIMUReadSuccessful(PyObject *self, PyObject *args);
+static PyObject *rcNanosSinceLastIMUInterrupt(PyObject *self, PyObject *args);
+static PyObject *rcGetIMUSample(PyObject *self, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames);
+static PyObject *rcReadIMUSamples(PyObject *self, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames);
+static PyObject *rcSetIMUCallback(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcGetIMUServiceStatus(PyObject *self, PyObject *args);
+static PyObject *rcStartIMUFIFO(PyObject *self, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames);
+static PyObject *rcStopIMUFIFO(PyObject *self, PyObject *args);
+static PyObject *rcReadIMUFIFO(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcGetIMUFIFOStatus(PyObject *self, PyObject *args);
 
-static PyObject *_rcInitializeBarometer(PyObject *self, PyObject *args);
+static PyObject *_rcInitializeBarometer(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
 static PyObject *rcPowerOffBarometer(PyObject *self, PyObject *args);
 static PyObject *rcReadBarometer(PyObject *self, PyObject *args);
 static PyObject *rcGetBMPTemperature(PyObject *self, PyObject *args);
 static PyObject *rcGetBMPPressurePa(PyObject *self, PyObject *args);
 static PyObject *rcGetBMPAltitudeM(PyObject *self, PyObject *args);
-static PyObject *rcSetBMPSeaLevelPressurePa(PyObject *self, PyObject *args);
-
-static PyObject *rcInitializeI2C(PyObject *self, PyObject *args);
-static PyObject *rcCloseI2C(PyObject *self, PyObject *args);
-static PyObject *rcSetI2CDeviceAddress(PyObject *self, PyObject *args);
-static PyObject *rcClaimI2CBus(PyObject *self, PyObject *args);
-static PyObject *rcReleaseI2CBus(PyObject *self, PyObject *args);
-static PyObject *rcGetI2CBusInUse(PyObject *self, PyObject *args);
-static PyObject *rcReadI2CByte(PyObject *self, PyObject *args);
-static PyObject *rcReadI2CBytes(PyObject *self, PyObject *args);
-static PyObject *rcReadI2CWord(PyObject *self, PyObject *args);
-static PyObject *rcReadI2CWords(PyObject *self, PyObject *args);
-static PyObject *rcReadI2CBit(PyObject *self, PyObject *args);
-static PyObject *rcWriteI2CByte(PyObject *self, PyObject *args);
-static PyObject *rcWriteI2CBytes(PyObject *self, PyObject *args);
-static PyObject *rcWriteI2CWord(PyObject *self, PyObject *args);
-static PyObject *rcWriteI2CWords(PyObject *self, PyObject *args);
-static PyObject *rcWriteI2CBit(PyObject *self, PyObject *args);
-static PyObject *rcSendI2CByte(PyObject *self, PyObject *args);
-static PyObject *rcSendI2CBytes(PyObject *self, PyObject *args);
-
-// TODO: SPI, UART methods
-
-static PyObject *rcSetCPUFreq(PyObject *self, PyObject *args);
+static PyObject *rcGetBMPFilteredAltitudeM(PyObject *self, PyObject *args);
+static PyObject *rcGetBMPVerticalSpeedMS(PyObject *self, PyObject *args);
+static PyObject *rcSetBMPSeaLevelPressurePa(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcStartBarometerService(PyObject *self, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames);
+static PyObject *rcStopBarometerService(PyObject *self, PyObject *args);
+static PyObject *rcGetBarometerSample(PyObject *self, PyObject *args);
+static PyObject *rcReadBarometerSamples(PyObject *self, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames);
+static PyObject *rcGetBarometerServiceStatus(PyObject *self, PyObject *args);
+
+static PyObject *rcInitializeI2C(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcCloseI2C(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcSetI2CDeviceAddress(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcClaimI2CBus(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcReleaseI2CBus(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcGetI2CBusInUse(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcReadI2CByte(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcReadI2CBytes(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcReadI2CWord(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcReadI2CWords(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcReadI2CBit(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcWriteI2CByte(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcWriteI2CBytes(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcWriteI2CWord(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcWriteI2CWords(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcWriteI2CBit(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcSendI2CByte(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcSendI2CBytes(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+
+static PyObject *rcInitializeSPI(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcCloseSPI(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcGetSPIFd(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcSelectSPISlave(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcDeselectSPISlave(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcSendSPIBytes(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcReadSPIBytes(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcTransferSPI(PyObject *self, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames);
+static PyObject *rcInitializeUART(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcCloseUART(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcGetUARTFd(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcFlushUART(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcSendUARTBytes(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcSendUARTByte(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcReadUARTBytes(PyObject *self, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames);
+static PyObject *rcReadUARTLine(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcUARTBytesAvailable(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+
+static PyObject *rcStartGPSService(PyObject *self, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames);
+static PyObject *rcStopGPSService(PyObject *self, PyObject *args);
+static PyObject *rcGetGPSFix(PyObject *self, PyObject *args);
+static PyObject *rcGetGPSServiceStatus(PyObject *self, PyObject *args);
+
+static PyObject *rcControllerNew(PyTypeObject *type, PyObject *args, PyObject *kwds);
+static void rcControllerDealloc(ControllerObject *self);
+static PyObject *rcControllerTransferFunction(PyObject *cls, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames);
+static PyObject *rcControllerStepMethod(ControllerObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcControllerReset(ControllerObject *self, PyObject *args);
+static PyObject *rcControllerBind(ControllerObject *self, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames);
+static PyObject *rcControllerStart(ControllerObject *self, PyObject *args);
+static PyObject *rcControllerStop(ControllerObject *self, PyObject *args);
+static PyObject *rcControllerStatus(ControllerObject *self, PyObject *args);
+static PyObject *rcControllerGetDouble(ControllerObject *self, void *closure);
+static int rcControllerSetDouble(ControllerObject *self, PyObject *arg, void *closure);
+
+static PyObject *rcDiscreteFilterNew(PyTypeObject *type, PyObject *args, PyObject *kwds);
+static void rcDiscreteFilterDealloc(DiscreteFilterObject *self);
+static PyObject *rcDiscreteFilterButterworth(PyObject *cls, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames);
+static PyObject *rcDiscreteFilterLowpass(PyObject *cls, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcDiscreteFilterHighpass(PyObject *cls, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcDiscreteFilterMarch(DiscreteFilterObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcDiscreteFilterApply(DiscreteFilterObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcDiscreteFilterPrefill(DiscreteFilterObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcDiscreteFilterReset(DiscreteFilterObject *self, PyObject *args);
+static PyObject *rcDiscreteFilterGetCoefficients(DiscreteFilterObject *self, void *closure);
+static PyObject *rcDiscreteFilterGetDouble(DiscreteFilterObject *self, void *closure);
+static int rcDiscreteFilterSetLimit(DiscreteFilterObject *self, PyObject *arg, void *closure);
+static PyObject *rcDiscreteFilterGetInt(DiscreteFilterObject *self, void *closure);
+
+static PyObject *rcSetCPUFreq(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
 static PyObject *rcGetCPUFreq(PyObject *self, PyObject *args);
 
 static PyObject *rcGetBBModel(PyObject *self, PyObject *args);
 
+static PyObject *rcEnableStats(PyObject *self, PyObject *const *args, Py_ssize_t nargs);
+static PyObject *rcGetStats(PyObject *self, PyObject *args);
+static PyObject *rcResetStats(PyObject *self, PyObject *args);
+
 
 // Method definitions
 static PyMethodDef RoboticsCapeMethods[] = {
@@ -113,71 +547,111 @@ static PyMethodDef RoboticsCapeMethods[] = {
         "Shut down RoboticsCape library and functions."},
     {"rcGetState", rcGetState, METH_NOARGS,
         "Get high level robot state."},
-    {"rcSetState", rcSetState, METH_VARARGS,
+    {"rcSetState", (PyCFunction)rcSetState, METH_FASTCALL,
         "Set high level robot state."},
-    {"rcGetLED", rcGetLED, METH_VARARGS,
+    {"rcGetLED", (PyCFunction)rcGetLED, METH_FASTCALL,
         "Get state of green or red LED (0 = off, 1 = on)."},
-    {"rcSetLED", rcSetLED, METH_VARARGS,
+    {"rcSetLED", (PyCFunction)rcSetLED, METH_FASTCALL,
         "Turn on/off green or red LED (0 = off, 1 = on)."},
-    {"rcBlinkLED", rcBlinkLED, METH_VARARGS,
+    {"rcBlinkLED", (PyCFunction)rcBlinkLED, METH_FASTCALL,
         "Blink green or red LED with a given frequency (Hz) for a finite period (s)."},
-    {"rcGetButton", rcGetButton, METH_VARARGS,
+    {"rcGetButton", (PyCFunction)rcGetButton, METH_FASTCALL,
         "Get state of pause (0) or mode (1) button (0 = released, 1 = pressed)."},
     {"rcEnableMotors", rcEnableMotors, METH_NOARGS,
         "Enable motor controller."},
     {"rcDisableMotors", rcDisableMotors, METH_NOARGS,
         "Disable motor controller."},
-    {"rcSetMotor", rcSetMotor, METH_VARARGS,
+    {"rcSetMotor", (PyCFunction)rcSetMotor, METH_FASTCALL,
         "Set direction and power of a single motor."},
-    {"rcSetMotorAll", rcSetMotorAll, METH_VARARGS,
+    {"rcSetMotorAll", (PyCFunction)rcSetMotorAll, METH_FASTCALL,
         "Set direction and power of all motors."},
-    {"rcSetMotorFreeSpin", rcSetMotorFreeSpin, METH_VARARGS,
+    {"rcSetMotors", (PyCFunction)rcSetMotors, METH_FASTCALL,
+        "Set direction and power of motors 1-4 from a sequence or buffer of up to 4 duty cycles."},
+    {"rcSetMotorFreeSpin", (PyCFunction)rcSetMotorFreeSpin, METH_FASTCALL,
         "Let a single motor spin freely."},
     {"rcSetMotorFreeSpinAll", rcSetMotorFreeSpinAll, METH_NOARGS,
         "Let all motors spin freely."},
-    {"rcSetMotorBrake", rcSetMotorBrake, METH_VARARGS,
+    {"rcSetMotorBrake", (PyCFunction)rcSetMotorBrake, METH_FASTCALL,
         "Engage brake on a single motor."},
     {"rcSetMotorBrakeAll", rcSetMotorBrakeAll, METH_NOARGS,
         "Engage brake on all motors."},
-    {"rcGetEncoderPos", rcGetEncoderPos, METH_VARARGS,
+    {"rcGetEncoderPos", (PyCFunction)rcGetEncoderPos, METH_FASTCALL,
         "Get quadrature encoder position for given channel (1-4)."},
-    {"rcSetEncoderPos", rcSetEncoderPos, METH_VARARGS,
+    {"rcGetEncoderPosAll", (PyCFunction)rcGetEncoderPosAll, METH_FASTCALL | METH_KEYWORDS,
+        "Get positions of encoder channels 1-4 in one call, optionally into a buffer 'out', plus a monotonic timestamp (ns)."},
+    {"rcSetEncoderPos", (PyCFunction)rcSetEncoderPos, METH_FASTCALL,
         "Set quadrature encoder position for given channel (1-4)."},
+    {"rcStartEncoderEstimator", (PyCFunction)rcStartEncoderEstimator, METH_FASTCALL | METH_KEYWORDS,
+        "Sample encoder channels 1-4 at rate_hz on a native thread and estimate velocity and acceleration (2nd order Butterworth at cutoff_hz, default 25, 0 for none; period based below period_counts counts per sample, default 2)."},
+    {"rcStopEncoderEstimator", rcStopEncoderEstimator, METH_NOARGS,
+        "Stop the encoder estimator."},
+    {"rcGetEncoderEstimates", (PyCFunction)rcGetEncoderEstimates, METH_FASTCALL | METH_KEYWORDS,
+        "Get the latest encoder estimates as EncoderEstimate, or into a writable 'd' buffer 'out' of 12 values (returns timestamp ns); None before the first one."},
+    {"rcGetEncoderEstimatorStatus", rcGetEncoderEstimatorStatus, METH_NOARGS,
+        "Get encoder estimator status as (running, samples, overruns)."},
     {"rcBatteryVoltage", rcBatteryVoltage, METH_NOARGS,
         "Get LiPo battery voltage."},
     {"rcDCJackVoltage", rcDCJackVoltage, METH_NOARGS,
         "Get DC jack voltage."},
-    {"rcADCRaw", rcADCRaw, METH_VARARGS,
+    {"rcADCRaw", (PyCFunction)rcADCRaw, METH_FASTCALL,
         "Get raw ADC value for given channel (0-6)."},
-    {"rcADCVolt", rcADCVolt, METH_VARARGS,
+    {"rcADCVolt", (PyCFunction)rcADCVolt, METH_FASTCALL,
         "Get ADC voltage for given channel (0-6)."},
+    {"rcStartADCSampler", (PyCFunction)rcStartADCSampler, METH_FASTCALL | METH_KEYWORDS,
+        "Start sampling the given ADC channels (0-6) at rate_hz on a native thread into a ring buffer of capacity samples."},
+    {"rcStopADCSampler", rcStopADCSampler, METH_NOARGS,
+        "Stop the native ADC sampling thread and free its ring buffer."},
+    {"rcReadADCSamples", (PyCFunction)rcReadADCSamples, METH_FASTCALL | METH_KEYWORDS,
+        "Drain sampled voltages into a writable 'f' buffer (samples x channels), optionally timestamps (ns) into a 'q'/'Q' buffer. Returns the number of samples."},
+    {"rcGetADCSamplerStatus", rcGetADCSamplerStatus, METH_NOARGS,
+        "Get ADC sampler state as (running, samples available, samples dropped)."},
     {"rcEnableServoPowerRail", rcEnableServoPowerRail, METH_NOARGS,
         "Enable servo 6V power rail."},
     {"rcDisableServoPowerRail", rcDisableServoPowerRail, METH_NOARGS,
         "Disable servo 6V power rail."},
-    {"rcSendServoPulseUs", rcSendServoPulseUs, METH_VARARGS,
+    {"rcSendServoPulseUs", (PyCFunction)rcSendServoPulseUs, METH_FASTCALL,
         "Send a single pulse with duration as milliseconds to the given servo channel."},
-    {"rcSendServoPulseUsAll", rcSendServoPulseUsAll, METH_VARARGS,
+    {"rcSendServoPulseUsAll", (PyCFunction)rcSendServoPulseUsAll, METH_FASTCALL,
         "Send a single pulse with duration as milliseconds to all servo channels."},
-    {"rcSendServoPulseNormalized", rcSendServoPulseNormalized, METH_VARARGS,
+    {"rcSendServoPulseNormalized", (PyCFunction)rcSendServoPulseNormalized, METH_FASTCALL,
         "Send a normalized pulse (range -1.5 ~ 1.5) to the given servo channel."},
-    {"rcSendServoPulseNormalizedAll", rcSendServoPulseNormalizedAll, METH_VARARGS,
+    {"rcSendServoPulseNormalizedAll", (PyCFunction)rcSendServoPulseNormalizedAll, METH_FASTCALL,
         "Send a normalized pulse (range -1.5 ~ 1.5) to all servo channels."},
-    {"rcSendESCPulseNormalized", rcSendESCPulseNormalized, METH_VARARGS,
+    {"rcSendESCPulseNormalized", (PyCFunction)rcSendESCPulseNormalized, METH_FASTCALL,
         "Send a normalized pulse (range -0.1 ~ 1.0) to the given ESC channel."},
-    {"rcSendESCPulseNormalizedAll", rcSendESCPulseNormalizedAll, METH_VARARGS,
+    {"rcSendESCPulseNormalizedAll", (PyCFunction)rcSendESCPulseNormalizedAll, METH_FASTCALL,
         "Send a normalized pulse (range -0.1 ~ 1.0) to all ESC channels."},
-    {"rcSendOneshotPulseNormalized", rcSendOneshotPulseNormalized, METH_VARARGS,
+    {"rcSendOneshotPulseNormalized", (PyCFunction)rcSendOneshotPulseNormalized, METH_FASTCALL,
         "Send a normalized oneshot pulse (range -0.1 ~ 1.0) to the given ESC channel."},
-    {"rcSendOneshotPulseNormalizedAll", rcSendOneshotPulseNormalizedAll, METH_VARARGS,
+    {"rcSendOneshotPulseNormalizedAll", (PyCFunction)rcSendOneshotPulseNormalizedAll, METH_FASTCALL,
         "Send a normalized oneshot pulse (range -0.1 ~ 1.0) to all ESC channels."},
+    {"rcSendServoPulseNormalizedVector", (PyCFunction)rcSendServoPulseNormalizedVector, METH_FASTCALL,
+        "Send one normalized pulse (range -1.5 ~ 1.5) per servo channel 1-n from a sequence or buffer of up to 8 floats (NaN = skip channel)."},
+    {"rcSendESCPulseNormalizedVector", (PyCFunction)rcSendESCPulseNormalizedVector, METH_FASTCALL,
+        "Send one normalized pulse (range -0.1 ~ 1.0) per ESC channel 1-n from a sequence or buffer of up to 8 floats (NaN = skip channel)."},
+    {"rcSendOneshotPulseNormalizedVector", (PyCFunction)rcSendOneshotPulseNormalizedVector, METH_FASTCALL,
+        "Send one normalized oneshot pulse (range -0.1 ~ 1.0) per ESC channel 1-n from a sequence or buffer of up to 8 floats (NaN = skip channel)."},
+    {"rcStartServoService", (PyCFunction)rcStartServoService, METH_FASTCALL,
+        "Start a native thread sending servo (0), ESC (1) or oneshot (2) pulses to channels 1-8 at rate_hz."},
+    {"rcStopServoService", rcStopServoService, METH_NOARGS,
+        "Stop the native servo pulse thread."},
+    {"rcSetServoSetpoints", (PyCFunction)rcSetServoSetpoints, METH_FASTCALL,
+        "Atomically replace the normalized setpoints of channels 1-n from a sequence or buffer of up to 8 floats (NaN = no pulses)."},
+    {"rcGetServoServiceStatus", rcGetServoServiceStatus, METH_NOARGS,
+        "Get servo service state as (running, pulse trains sent, missed periods)."},
+    {"rcRunLoop", (PyCFunction)rcRunLoop, METH_FASTCALL | METH_KEYWORDS,
+        "Run callback(inputs) at hz on a native (optionally SCHED_FIFO) thread and apply the returned motor duties; blocks until rcStopLoop, an exception or EXITING state."},
+    {"rcStopLoop", rcStopLoop, METH_NOARGS,
+        "Ask the loop started by rcRunLoop to stop after the current tick."},
+    {"rcGetLoopStats", rcGetLoopStats, METH_NOARGS,
+        "Get tick, overrun and timing statistics of the current or last rcRunLoop."},
     {"rcInitializeDSM", rcInitializeDSM, METH_NOARGS,
         "Start the DSM reception background service."},
     {"rcStopDSMService", rcStopDSMService, METH_NOARGS,
         "Stop the DSM reception background service."},
-    {"rcGetDSMChRaw", rcGetDSMChRaw, METH_VARARGS,
+    {"rcGetDSMChRaw", (PyCFunction)rcGetDSMChRaw, METH_FASTCALL,
         "Get the pulse width send by the transmitter to the given channel."},
-    {"rcGetDSMChNormalized", rcGetDSMChNormalized, METH_VARARGS,
+    {"rcGetDSMChNormalized", (PyCFunction)rcGetDSMChNormalized, METH_FASTCALL,
         "Get normalized values (range -1.0 ~ 1.0) of the given channel according to (mandatory) calibration."},
     {"rcIsDSMNewData", rcIsDSMNewData, METH_NOARGS,
         "Check whether new DSM data is available (1 - true | 0 - false)."},
@@ -193,9 +667,66 @@ static PyMethodDef RoboticsCapeMethods[] = {
         "Put DSM receiver in bind mode."},
     {"rcCalibrateDSMRoutine", rcCalibrateDSMRoutine, METH_NOARGS,
         "Start DSM calibration routine."},
+    {"rcWaitDSMFrame", (PyCFunction)rcWaitDSMFrame, METH_FASTCALL,
+        "Block until an unread DSM frame is available or the optional timeout (s) expires (1 - new frame | 0 - timeout or service stopped)."},
+    {"rcSetDSMCallback", (PyCFunction)rcSetDSMCallback, METH_FASTCALL,
+        "Call callback(channels) with a tuple of all normalized channels once per DSM frame on a native thread; None removes it. The callback consumes the frame, so rcIsDSMNewData reports 0 after it has run."},
+    {"rcGetDSMFrame", (PyCFunction)rcGetDSMFrame, METH_FASTCALL | METH_KEYWORDS,
+        "Get all channels (normalized or raw) of one DSM frame plus resolution, nanoseconds since the packet and active flag, as DSMFrame or into a 'd' buffer 'out' of 12 values (returns number of channels)."},
+    {"rcStartDSMRecording", (PyCFunction)rcStartDSMRecording, METH_FASTCALL,
+        "Stream every received DSM frame with its timestamp to the given file."},
+    {"rcStopDSMRecording", rcStopDSMRecording, METH_NOARGS,
+        "Stop DSM recording and close the file. Returns the number of frames written."},
+    {"rcStartDSMReplay", (PyCFunction)rcStartDSMReplay, METH_FASTCALL | METH_KEYWORDS,
+        "Serve the frames of a DSM recording through the rcGetDSM*/rcIsDSM* functions, at original timing (realtime=True) or each as soon as the previous one has been read."},
+    {"rcStopDSMReplay", rcStopDSMReplay, METH_NOARGS,
+        "Stop DSM replay. Returns the number of frames replayed."},
+
+    {"_rcInitializeIMU", (PyCFunction)_rcInitializeIMU, METH_FASTCALL,
+        "Power on and initialize the IMU for polled reads with the given accel/gyro full scale ranges, low pass filters and magnetometer flag."},
+    {"_rcInitializeIMUDMP", (PyCFunction)_rcInitializeIMUDMP, METH_FASTCALL,
+        "Initialize the IMU in DMP interrupt mode like _rcInitializeIMU, plus sample rate, orientation, compass time constant and sample ring buffer capacity. While running, the barometer and other transfers on its I²C bus are refused."},
+    {"rcPowerOffIMU", rcPowerOffIMU, METH_NOARGS,
+        "Stop DMP interrupts and the IMU callback, free the sample buffer and power off the IMU."},
+    {"rcReadAccelData", rcReadAccelData, METH_NOARGS,
+        "Read acceleration (x, y, z) in m/s² (polled mode only)."},
+    {"rcReadGyroData", rcReadGyroData, METH_NOARGS,
+        "Read angular rate (x, y, z) in °/s (polled mode only)."},
+    {"rcReadMagData", rcReadMagData, METH_NOARGS,
+        "Read magnetic field (x, y, z) in µT (polled mode with magnetometer only)."},
+    {"rcReadIMUTemp", rcReadIMUTemp, METH_NOARGS,
+        "Read IMU temperature in °C (polled mode only)."},
+    {"rcCalibrateGyroRoutine", rcCalibrateGyroRoutine, METH_NOARGS,
+        "Run the gyro calibration routine; keep the board still."},
+    {"rcCalibrateMagRoutine", rcCalibrateMagRoutine, METH_NOARGS,
+        "Run the magnetometer calibration routine; spin the board around all axes."},
+    {"rcIsGyroCalibrated", rcIsGyroCalibrated, METH_NOARGS,
+        "Check whether gyro calibration data exists."},
+    {"rcIsMagCalibrated", rcIsMagCalibrated, METH_NOARGS,
+        "Check whether magnetometer calibration data exists."},
+    {"rcWasLastIMUReadSuccessful", rcWasLastIMUReadSuccessful, METH_NOARGS,
+        "Check whether the last IMU read (polled or DMP) succeeded."},
+    {"rcNanosSinceLastIMUInterrupt", rcNanosSinceLastIMUInterrupt, METH_NOARGS,
+        "Get nanoseconds since the last DMP interrupt."},
+    {"rcGetIMUSample", (PyCFunction)rcGetIMUSample, METH_FASTCALL | METH_KEYWORDS,
+        "Get the newest DMP sample as IMUSample, or into a writable 'f' buffer 'out' of 16 values (returns timestamp ns); None before the first one."},
+    {"rcReadIMUSamples", (PyCFunction)rcReadIMUSamples, METH_FASTCALL | METH_KEYWORDS,
+        "Drain DMP samples into a writable 'f' buffer (samples x accel xyz, gyro xyz, mag xyz, quaternion wxyz, Tait-Bryan xyz), optionally timestamps (ns) into a 'q'/'Q' buffer. Returns the number of samples."},
+    {"rcSetIMUCallback", (PyCFunction)rcSetIMUCallback, METH_FASTCALL,
+        "Call callback(IMUSample) from a native thread for every DMP sample (samples arriving during a call are coalesced); None removes it."},
+    {"rcGetIMUServiceStatus", rcGetIMUServiceStatus, METH_NOARGS,
+        "Get DMP sample delivery state as (running, samples available, samples dropped)."},
+    {"rcStartIMUFIFO", (PyCFunction)rcStartIMUFIFO, METH_FASTCALL | METH_KEYWORDS,
+        "Start collecting accel and gyro samples at rate_hz (1000 divided by an integer) in the IMU's hardware FIFO (polled mode only)."},
+    {"rcStopIMUFIFO", rcStopIMUFIFO, METH_NOARGS,
+        "Stop collecting samples in the IMU's hardware FIFO."},
+    {"rcReadIMUFIFO", (PyCFunction)rcReadIMUFIFO, METH_FASTCALL,
+        "Drain the IMU's hardware FIFO in burst reads into a writable 'f' buffer (samples x accel xyz m/s², gyro xyz °/s). Returns the number of samples; 0 after an overflow, which restarts the FIFO."},
+    {"rcGetIMUFIFOStatus", rcGetIMUFIFOStatus, METH_NOARGS,
+        "Get IMU FIFO state as (running, samples available, overflows)."},
 
-    {"_rcInitializeBarometer", _rcInitializeBarometer, METH_VARARGS,
-        "Power on and initialize barometer with the given oversample and filter settings."},
+    {"_rcInitializeBarometer", (PyCFunction)_rcInitializeBarometer, METH_FASTCALL,
+        "Power on and initialize barometer with the given oversample and filter settings, optionally altitude filter mode and its two parameters."},
     {"rcPowerOffBarometer", rcPowerOffBarometer, METH_NOARGS,
         "Power off barometer."},
     {"rcReadBarometer", rcReadBarometer, METH_NOARGS,
@@ -206,55 +737,246 @@ static PyMethodDef RoboticsCapeMethods[] = {
         "Get pressure in pascal transmitted during last rcReadBarometer call."},
     {"rcGetBMPAltitudeM", rcGetBMPAltitudeM, METH_NOARGS,
         "Get altitude in meters transmitted during last rcReadBarometer call."},
-    {"rcSetBMPSeaLevelPressurePa", rcSetBMPSeaLevelPressurePa, METH_VARARGS,
+    {"rcGetBMPFilteredAltitudeM", rcGetBMPFilteredAltitudeM, METH_NOARGS,
+        "Get altitude in meters after the altitude filter, as of the last barometer reading."},
+    {"rcGetBMPVerticalSpeedMS", rcGetBMPVerticalSpeedMS, METH_NOARGS,
+        "Get vertical speed in m/s estimated by the altitude filter (NaN without filter), as of the last barometer reading."},
+    {"rcSetBMPSeaLevelPressurePa", (PyCFunction)rcSetBMPSeaLevelPressurePa, METH_FASTCALL,
         "Set current sea level pressure to correct altitude reading."},
-    {"rcInitializeI2C", rcInitializeI2C, METH_VARARGS,
+    {"rcStartBarometerService", (PyCFunction)rcStartBarometerService, METH_FASTCALL | METH_KEYWORDS,
+        "Read the barometer on a native thread at the update rate of its oversample setting into a ring buffer of capacity samples."},
+    {"rcStopBarometerService", rcStopBarometerService, METH_NOARGS,
+        "Stop the native barometer thread and free its ring buffer."},
+    {"rcGetBarometerSample", rcGetBarometerSample, METH_NOARGS,
+        "Get the newest barometer sample as (timestamp ns, temperature, pressure Pa, altitude m, filtered altitude m, vertical speed m/s), None before the first one."},
+    {"rcReadBarometerSamples", (PyCFunction)rcReadBarometerSamples, METH_FASTCALL | METH_KEYWORDS,
+        "Drain barometer samples into a writable 'f' buffer (samples x temperature, pressure, altitude, filtered altitude, vertical speed), optionally timestamps (ns) into a 'q'/'Q' buffer. Returns the number of samples."},
+    {"rcGetBarometerServiceStatus", rcGetBarometerServiceStatus, METH_NOARGS,
+        "Get barometer service state as (running, samples available, samples dropped)."},
+    {"rcInitializeI2C", (PyCFunction)rcInitializeI2C, METH_FASTCALL,
         "Initialize I²C bus with given bus number and device address."},
-    {"rcCloseI2C", rcCloseI2C, METH_VARARGS,
+    {"rcCloseI2C", (PyCFunction)rcCloseI2C, METH_FASTCALL,
         "Close I²C bus with given bus number and release file descriptors."},
-    {"rcSetI2CDeviceAddress", rcSetI2CDeviceAddress, METH_VARARGS,
+    {"rcSetI2CDeviceAddress", (PyCFunction)rcSetI2CDeviceAddress, METH_FASTCALL,
         "Switch to another device address on an initialized I²C bus."},
-    {"rcClaimI2CBus", rcClaimI2CBus, METH_VARARGS,
+    {"rcClaimI2CBus", (PyCFunction)rcClaimI2CBus, METH_FASTCALL,
         "Convenience method to mark I²C bus as being in use."},
-    {"rcReleaseI2CBus", rcReleaseI2CBus, METH_VARARGS,
+    {"rcReleaseI2CBus", (PyCFunction)rcReleaseI2CBus, METH_FASTCALL,
         "Convenience method to mark I²C bus as not being in use."},
-    {"rcGetI2CBusInUse", rcGetI2CBusInUse, METH_VARARGS,
+    {"rcGetI2CBusInUse", (PyCFunction)rcGetI2CBusInUse, METH_FASTCALL,
         "Convenience method to check whether I²C bus is in use."},
-    {"rcReadI2CByte", rcReadI2CByte, METH_VARARGS,
+    {"rcReadI2CByte", (PyCFunction)rcReadI2CByte, METH_FASTCALL,
         "Read one byte from a particular I²C device and register."},
-    {"rcReadI2CBytes", rcReadI2CBytes, METH_VARARGS,
-        "Read a given number of bytes from a particular I²C device and register."},
-    {"rcReadI2CWord", rcReadI2CWord, METH_VARARGS,
+    {"rcReadI2CBytes", (PyCFunction)rcReadI2CBytes, METH_FASTCALL,
+        "Read bytes from a particular I²C device and register, either a given number (returns bytes) or into a writable buffer (returns count)."},
+    {"rcReadI2CWord", (PyCFunction)rcReadI2CWord, METH_FASTCALL,
         "Read one word from a particular I²C device and register."},
-    {"rcReadI2CWords", rcReadI2CWords, METH_VARARGS,
-        "Read a given number of words from a particular I²C device and register."},
-    {"rcReadI2CBit", rcReadI2CBit, METH_VARARGS,
+    {"rcReadI2CWords", (PyCFunction)rcReadI2CWords, METH_FASTCALL,
+        "Read words from a particular I²C device and register, either a given number (returns tuple) or into a writable 'H'/'h' buffer (returns count)."},
+    {"rcReadI2CBit", (PyCFunction)rcReadI2CBit, METH_FASTCALL,
         "Read one bit from a particular I²C device and register."},
-    {"rcWriteI2CByte", rcWriteI2CByte, METH_VARARGS,
+    {"rcWriteI2CByte", (PyCFunction)rcWriteI2CByte, METH_FASTCALL,
         "Write one byte to a particular I²C device and register."},
-    {"rcWriteI2CBytes", rcWriteI2CBytes, METH_VARARGS,
-        "Write a given number of bytes to a particular I²C device and register."},
-    {"rcWriteI2CWord", rcWriteI2CWord, METH_VARARGS,
+    {"rcWriteI2CBytes", (PyCFunction)rcWriteI2CBytes, METH_FASTCALL,
+        "Write the bytes of a bytes-like object to a particular I²C device and register."},
+    {"rcWriteI2CWord", (PyCFunction)rcWriteI2CWord, METH_FASTCALL,
         "Write one word to a particular I²C device and register."},
-    {"rcWriteI2CWords", rcWriteI2CWords, METH_VARARGS,
-        "Write a given number of words to a particular I²C device and register."},
-    {"rcWriteI2CBit", rcWriteI2CBit, METH_VARARGS,
+    {"rcWriteI2CWords", (PyCFunction)rcWriteI2CWords, METH_FASTCALL,
+        "Write the words of an 'H'/'h' buffer to a particular I²C device and register."},
+    {"rcWriteI2CBit", (PyCFunction)rcWriteI2CBit, METH_FASTCALL,
         "Write one bit to a particular I²C device and register."},
-    {"rcSendI2CByte", rcSendI2CByte, METH_VARARGS,
+    {"rcSendI2CByte", (PyCFunction)rcSendI2CByte, METH_FASTCALL,
         "Write one byte to the I²C bus (= I²C broadcast)."},
-    {"rcSendI2CBytes", rcSendI2CBytes, METH_VARARGS,
+    {"rcSendI2CBytes", (PyCFunction)rcSendI2CBytes, METH_FASTCALL,
         "Write a given number of bytes to the I²C bus (= I²C broadcast)."},
 
-    {"rcSetCPUFreq", rcSetCPUFreq, METH_VARARGS,
+    {"rcInitializeSPI", (PyCFunction)rcInitializeSPI, METH_FASTCALL,
+        "Initialize SPI slave with given slave select mode (auto/manual), SPI mode (0-3), clock speed in Hz and slave number."},
+    {"rcCloseSPI", (PyCFunction)rcCloseSPI, METH_FASTCALL,
+        "Close SPI slave and release its file descriptor."},
+    {"rcGetSPIFd", (PyCFunction)rcGetSPIFd, METH_FASTCALL,
+        "Get the spidev file descriptor of an initialized SPI slave."},
+    {"rcSelectSPISlave", (PyCFunction)rcSelectSPISlave, METH_FASTCALL,
+        "Pull the slave select line of a manual mode SPI slave low."},
+    {"rcDeselectSPISlave", (PyCFunction)rcDeselectSPISlave, METH_FASTCALL,
+        "Release the slave select line of a manual mode SPI slave."},
+    {"rcSendSPIBytes", (PyCFunction)rcSendSPIBytes, METH_FASTCALL,
+        "Write the bytes of a bytes-like object to an SPI slave."},
+    {"rcReadSPIBytes", (PyCFunction)rcReadSPIBytes, METH_FASTCALL,
+        "Read bytes from an SPI slave, either a given number (returns bytes) or into a writable buffer (returns count)."},
+    {"rcTransferSPI", (PyCFunction)rcTransferSPI, METH_FASTCALL | METH_KEYWORDS,
+        "Full-duplex transfer of bytes-like tx data to an SPI slave, split into 'transfers' equal transfers; received bytes are returned, or written to a writable buffer 'rx' (returns count)."},
+
+    {"rcInitializeUART", (PyCFunction)rcInitializeUART, METH_FASTCALL,
+        "Initialize UART bus with given baudrate and read timeout in seconds."},
+    {"rcCloseUART", (PyCFunction)rcCloseUART, METH_FASTCALL,
+        "Close UART bus and release its file descriptor."},
+    {"rcGetUARTFd", (PyCFunction)rcGetUARTFd, METH_FASTCALL,
+        "Get the file descriptor of an initialized UART bus."},
+    {"rcFlushUART", (PyCFunction)rcFlushUART, METH_FASTCALL,
+        "Discard all bytes received but not read yet and all bytes not sent yet."},
+    {"rcSendUARTBytes", (PyCFunction)rcSendUARTBytes, METH_FASTCALL,
+        "Write the bytes of a bytes-like object to a UART bus."},
+    {"rcSendUARTByte", (PyCFunction)rcSendUARTByte, METH_FASTCALL,
+        "Write one byte to a UART bus."},
+    {"rcReadUARTBytes", (PyCFunction)rcReadUARTBytes, METH_FASTCALL | METH_KEYWORDS,
+        "Read from a UART bus, either a given number of bytes (returns bytes) or into a writable buffer (returns count), until full or timeout: the bus' timeout if None, else timeout seconds (<= 25.5) for the whole call (0: only bytes already received)."},
+    {"rcReadUARTLine", (PyCFunction)rcReadUARTLine, METH_FASTCALL,
+        "Read one line (without newline) of at most a given number of bytes (returns bytes) or into a writable buffer (returns count) from a UART bus."},
+    {"rcUARTBytesAvailable", (PyCFunction)rcUARTBytesAvailable, METH_FASTCALL,
+        "Get the number of bytes received on a UART bus and not read yet."},
+
+    {"rcStartGPSService", (PyCFunction)rcStartGPSService, METH_FASTCALL | METH_KEYWORDS,
+        "Open UART bus at baudrate (default 9600) and parse its NMEA (GGA, RMC) and UBX (NAV-PVT) stream on a native thread."},
+    {"rcStopGPSService", rcStopGPSService, METH_NOARGS,
+        "Stop the GPS service and close its UART bus."},
+    {"rcGetGPSFix", rcGetGPSFix, METH_NOARGS,
+        "Get the latest fix of the GPS service as GPSFix, None before the first one."},
+    {"rcGetGPSServiceStatus", rcGetGPSServiceStatus, METH_NOARGS,
+        "Get GPS service status as (running, valid messages, checksum errors)."},
+
+    {"rcSetCPUFreq", (PyCFunction)rcSetCPUFreq, METH_FASTCALL,
         "Set CPU frequency."},
     {"rcGetCPUFreq", rcGetCPUFreq, METH_NOARGS,
         "Get CPU frequency setting."},
     {"rcGetBBModel", rcGetBBModel, METH_NOARGS,
         "Get the BeagleBone model."},
 
+    {"rcEnableStats", (PyCFunction)rcEnableStats, METH_FASTCALL,
+        "Turn per-function call count and latency recording on (1) or off (0)."},
+    {"rcGetStats", rcGetStats, METH_NOARGS,
+        "Get call count, total/max latency (ns) and log2 latency histogram of every called function."},
+    {"rcResetStats", rcResetStats, METH_NOARGS,
+        "Clear all recorded call counts and latencies."},
+
     {NULL, NULL, 0, NULL}        /* Sentinel */
 };
 
+#define NUM_METHODS (sizeof(RoboticsCapeMethods) / sizeof(PyMethodDef) - 1)
+
+
+// Controller type definition
+static PyMethodDef ControllerMethods[] = {
+    {"transfer_function", (PyCFunction)rcControllerTransferFunction, METH_FASTCALL | METH_KEYWORDS | METH_CLASS,
+        "Create a controller applying the discrete transfer function num/den (coefficients of z, highest power first) to the error, saturated at ±limit (default 1.0)."},
+    {"step", (PyCFunction)rcControllerStepMethod, METH_FASTCALL,
+        "Feed one measurement and return the new output; refused while the timer steps the controller."},
+    {"reset", (PyCFunction)rcControllerReset, METH_NOARGS,
+        "Clear integrator, derivative and filter state."},
+    {"bind", (PyCFunction)rcControllerBind, METH_FASTCALL | METH_KEYWORDS,
+        "Take measurements from encoder channel (counts times scale, default 1.0; per second if velocity is true) and drive motor (1-4, default 0 for none) when started."},
+    {"start", (PyCFunction)rcControllerStart, METH_NOARGS,
+        "Step the bound controller every dt seconds on a native timer thread."},
+    {"stop", (PyCFunction)rcControllerStop, METH_NOARGS,
+        "Stop the timer thread and set the bound motor to 0."},
+    {"status", (PyCFunction)rcControllerStatus, METH_NOARGS,
+        "Get timer status as (running, steps, overruns)."},
+    {NULL, NULL, 0, NULL}
+};
+
+static PyGetSetDef ControllerGetSet[] = {
+    {"kp", (getter)rcControllerGetDouble, (setter)rcControllerSetDouble,
+        "proportional gain", (void *)offsetof(ControllerObject, kp)},
+    {"ki", (getter)rcControllerGetDouble, (setter)rcControllerSetDouble,
+        "integral gain (1/s)", (void *)offsetof(ControllerObject, ki)},
+    {"kd", (getter)rcControllerGetDouble, (setter)rcControllerSetDouble,
+        "derivative gain (s)", (void *)offsetof(ControllerObject, kd)},
+    {"tau", (getter)rcControllerGetDouble, (setter)rcControllerSetDouble,
+        "derivative filter time constant (s), 0 for none", (void *)offsetof(ControllerObject, tau)},
+    {"limit", (getter)rcControllerGetDouble, (setter)rcControllerSetDouble,
+        "output saturates at ±limit", (void *)offsetof(ControllerObject, limit)},
+    {"setpoint", (getter)rcControllerGetDouble, (setter)rcControllerSetDouble,
+        "setpoint in measurement units", (void *)offsetof(ControllerObject, setpoint)},
+    {"dt", (getter)rcControllerGetDouble, NULL,
+        "time step (s)", (void *)offsetof(ControllerObject, dt)},
+    {"measurement", (getter)rcControllerGetDouble, NULL,
+        "measurement of the last step", (void *)offsetof(ControllerObject, measurement)},
+    {"output", (getter)rcControllerGetDouble, NULL,
+        "output of the last step", (void *)offsetof(ControllerObject, output)},
+    {NULL, NULL, NULL, NULL, NULL}
+};
+
+static PyType_Slot ControllerSlots[] = {
+    {Py_tp_doc, "Controller(dt, kp=0.0, ki=0.0, kd=0.0, tau=0.0, limit=1.0)\n\n"
+                "PID controller with conditional integration anti-windup and a\n"
+                "low-passed derivative on the measurement, or a discrete transfer\n"
+                "function (Controller.transfer_function). Stepped from Python by\n"
+                "step(), or bound to an encoder and motor and stepped natively."},
+    {Py_tp_new, rcControllerNew},
+    {Py_tp_dealloc, rcControllerDealloc},
+    {Py_tp_methods, ControllerMethods},
+    {Py_tp_getset, ControllerGetSet},
+    {0, NULL}
+};
+
+static PyType_Spec ControllerSpec = {
+    "_roboticscape.Controller",
+    sizeof(ControllerObject),
+    0,
+    Py_TPFLAGS_DEFAULT,
+    ControllerSlots
+};
+
+
+// DiscreteFilter type definition
+static PyMethodDef DiscreteFilterMethods[] = {
+    {"butterworth", (PyCFunction)rcDiscreteFilterButterworth, METH_FASTCALL | METH_KEYWORDS | METH_CLASS,
+        "Create a Butterworth lowpass (or highpass if highpass is true) of order 1-10 for time step dt (s) and cutoff frequency (Hz)."},
+    {"lowpass", (PyCFunction)rcDiscreteFilterLowpass, METH_FASTCALL | METH_CLASS,
+        "Create a first order lowpass for time step dt (s) and time constant tau (s)."},
+    {"highpass", (PyCFunction)rcDiscreteFilterHighpass, METH_FASTCALL | METH_CLASS,
+        "Create a first order highpass for time step dt (s) and time constant tau (s)."},
+    {"march", (PyCFunction)rcDiscreteFilterMarch, METH_FASTCALL,
+        "Feed one input value and return the new output."},
+    {"apply", (PyCFunction)rcDiscreteFilterApply, METH_FASTCALL,
+        "Feed every value of buffer 'in' and write the outputs to the writable buffer 'out' ('f' or 'd' each, may be the same); returns the count."},
+    {"prefill", (PyCFunction)rcDiscreteFilterPrefill, METH_FASTCALL,
+        "Set the filter state to the steady state of a constant input."},
+    {"reset", (PyCFunction)rcDiscreteFilterReset, METH_NOARGS,
+        "Clear the filter state."},
+    {NULL, NULL, 0, NULL}
+};
+
+static PyGetSetDef DiscreteFilterGetSet[] = {
+    {"num", (getter)rcDiscreteFilterGetCoefficients, NULL,
+        "normalized numerator coefficients, highest power of z first", NULL},
+    {"den", (getter)rcDiscreteFilterGetCoefficients, NULL,
+        "normalized denominator coefficients, highest power of z first", (void *)1},
+    {"min", (getter)rcDiscreteFilterGetDouble, (setter)rcDiscreteFilterSetLimit,
+        "outputs saturate at min", (void *)offsetof(DiscreteFilterObject, filter.min)},
+    {"max", (getter)rcDiscreteFilterGetDouble, (setter)rcDiscreteFilterSetLimit,
+        "outputs saturate at max", (void *)offsetof(DiscreteFilterObject, filter.max)},
+    {"dt", (getter)rcDiscreteFilterGetDouble, NULL,
+        "time step (s)", (void *)offsetof(DiscreteFilterObject, dt)},
+    {"output", (getter)rcDiscreteFilterGetDouble, NULL,
+        "most recent output", (void *)offsetof(DiscreteFilterObject, filter.out)},
+    {"order", (getter)rcDiscreteFilterGetInt, NULL,
+        "filter order", NULL},
+    {"steps", (getter)rcDiscreteFilterGetInt, NULL,
+        "inputs since creation or the last reset", (void *)1},
+    {NULL, NULL, NULL, NULL, NULL}
+};
+
+static PyType_Slot DiscreteFilterSlots[] = {
+    {Py_tp_doc, "DiscreteFilter(num, den, dt, min=-inf, max=inf)\n\n"
+                "Discrete SISO transfer function num/den (coefficients of z, highest\n"
+                "power first) with outputs saturated to [min, max]. See also the\n"
+                "butterworth, lowpass and highpass constructors."},
+    {Py_tp_new, rcDiscreteFilterNew},
+    {Py_tp_dealloc, rcDiscreteFilterDealloc},
+    {Py_tp_methods, DiscreteFilterMethods},
+    {Py_tp_getset, DiscreteFilterGetSet},
+    {0, NULL}
+};
+
+static PyType_Spec DiscreteFilterSpec = {
+    "_roboticscape.DiscreteFilter",
+    sizeof(DiscreteFilterObject),
+    0,
+    Py_TPFLAGS_DEFAULT,
+    DiscreteFilterSlots
+};
+
 
 // Module defintion
 static struct PyModuleDef RoboticsCapeModule = {
@@ -0,0 +1,1661 @@
+/*
+ * rc_sim.c - Simulated libroboticscape for building and benchmarking
+ * the Python bindings off-target
+ *
+ * Copyright (C) 2017 Torsten Kurbad <beaglebone@tk-webart.de>
+ *
+ * All device state lives in memory and is guarded by sim_lock. Bus
+ * transactions sleep for a fixed time derived from the SIM_* constants
+ * in roboticscape.h (outside the lock), so timing is deterministic and
+ * concurrent callers behave like on the real hardware.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <poll.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "roboticscape.h"
+
+#define SIM_RED_LED		66
+#define SIM_GRN_LED		67
+#define SIM_MOTORS		4
+#define SIM_ENCODERS		4
+#define SIM_ADC_CHANNELS	7
+#define SIM_SERVOS		8
+#define SIM_DSM_CHANNELS	6
+#define SIM_I2C_BUSSES		3
+#define SIM_SPI_SLAVES		2
+#define SIM_UART_BUSES		6
+#define SIM_LIPO_ADC_CH		6
+#define SIM_DC_JACK_ADC_CH	5
+#define SIM_V_DIV_RATIO		11.0f
+#define SIM_IMU_BUS		2
+#define SIM_IMU_ADDR		0x68
+#define SIM_MPU_SMPLRT_DIV	0x19
+#define SIM_MPU_FIFO_EN		0x23
+#define SIM_MPU_INT_STATUS	0x3a
+#define SIM_MPU_USER_CTRL	0x6a
+#define SIM_MPU_FIFO_COUNTH	0x72
+#define SIM_MPU_FIFO_R_W	0x74
+#define SIM_MPU_FIFO_SIZE	512
+
+static pthread_mutex_t sim_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static rc_state_t state = UNINITIALIZED;
+static int led_state[2];
+static rc_cpu_freq_t cpu_freq = FREQ_ONDEMAND;
+
+// Motors drive the encoders: position integrates duty over CLOCK_MONOTONIC
+// time, the clock the encoder estimator and controllers time samples by
+static int motors_enabled;
+static float motor_duty[SIM_MOTORS];
+static double encoder_pos[SIM_ENCODERS];
+static uint64_t encoder_nanos;
+
+// Raw 12 bit readings: 1.0 V on channels 0-4, 12 V DC jack, 7.4 V LiPo
+static const int adc_raw[SIM_ADC_CHANNELS] = {2275, 2275, 2275, 2275, 2275, 2482, 1530};
+
+static int servo_rail;
+static int servo_last_us[SIM_SERVOS];
+static uint64_t servo_pulses[SIM_SERVOS];
+
+static pthread_t dsm_thread;
+static int dsm_running;
+static int dsm_new_data;
+static int dsm_raw[SIM_DSM_CHANNELS];
+static uint64_t dsm_last_packet;
+static uint64_t dsm_frames;
+static int (*dsm_data_func)(void);
+
+static int bmp_initialized;
+static rc_bmp_oversample_t bmp_oversample;
+static float bmp_temperature;
+static float bmp_pressure;
+static float bmp_sea_level_pa = 101325.0f;
+
+static const float imu_accel_fsr_g[] = {2.0f, 4.0f, 8.0f, 16.0f};
+static const float imu_gyro_fsr_dps[] = {250.0f, 500.0f, 1000.0f, 2000.0f};
+static int imu_initialized;
+static rc_imu_config_t imu_config;
+static uint64_t imu_start_nanos;
+static int imu_gyro_calibrated;
+static int imu_mag_calibrated;
+static int imu_last_read_ok;
+static pthread_t imu_thread;
+static int imu_dmp_running;
+static rc_imu_data_t *imu_dmp_data;
+static uint64_t imu_last_interrupt;
+static int (*imu_interrupt_func)(void);
+
+// MPU-9250 FIFO: records are generated lazily from the elapsed time
+static uint64_t mpu_fifo_nanos;		// time up to which records exist
+static uint64_t mpu_fifo_records;	// records produced since reset
+static uint64_t mpu_fifo_read;		// bytes consumed since reset
+
+static int spi_initialized[SIM_SPI_SLAVES + 1];
+static ss_mode_t spi_ss_mode[SIM_SPI_SLAVES + 1];
+static int spi_speed_hz[SIM_SPI_SLAVES + 1];
+static int spi_selected[SIM_SPI_SLAVES + 1];
+
+// Each UART is a pipe: TX is looped back to RX
+static int uart_pipe[SIM_UART_BUSES][2] = {
+	{-1, -1}, {-1, -1}, {-1, -1}, {-1, -1}, {-1, -1}, {-1, -1}
+};
+static int uart_baudrate[SIM_UART_BUSES];
+static int uart_timeout_ms[SIM_UART_BUSES];
+
+static uint8_t i2c_regs[SIM_I2C_BUSSES][128][256];
+static uint8_t i2c_address[SIM_I2C_BUSSES];
+static int i2c_initialized[SIM_I2C_BUSSES];
+static int i2c_in_use[SIM_I2C_BUSSES];
+static int i2c_regs_loaded;
+
+
+static uint64_t sim_nanos(clockid_t clock) {
+	struct timespec ts;
+
+	clock_gettime(clock, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void sim_delay(uint64_t nanos) {
+	struct timespec ts;
+
+	ts.tv_sec = (time_t)(nanos / 1000000000ULL);
+	ts.tv_nsec = (long)(nanos % 1000000000ULL);
+
+	while (nanosleep(&ts, &ts) == -1 && errno == EINTR)
+		;
+}
+
+static void sim_i2c_delay(int bytes) {
+	sim_delay(SIM_I2C_SETUP_NS + (uint64_t)bytes * SIM_I2C_BYTE_NS);
+}
+
+// Must be called with sim_lock held
+static void sim_update_encoders(void) {
+	uint64_t now = sim_nanos(CLOCK_MONOTONIC);
+	double dt;
+	int i;
+
+	if (encoder_nanos != 0 && motors_enabled) {
+		dt = (double)(now - encoder_nanos) * 1e-9;
+		for (i = 0; i < SIM_ENCODERS; i++)
+			encoder_pos[i] += motor_duty[i] * SIM_ENCODER_COUNTS_PER_S * dt;
+	}
+	encoder_nanos = now;
+}
+
+// Must be called with sim_lock held
+static int sim_mpu_fifo_record_size(void) {
+	uint8_t enabled = i2c_regs[SIM_IMU_BUS][SIM_IMU_ADDR][SIM_MPU_FIFO_EN];
+
+	return ((enabled & 0x80) ? 2 : 0) + ((enabled & 0x08) ? 6 : 0)
+		+ ((enabled & 0x40) ? 2 : 0) + ((enabled & 0x20) ? 2 : 0) + ((enabled & 0x10) ? 2 : 0);
+}
+
+// Must be called with sim_lock held; the sample rate assumes the DLPF is on
+static uint64_t sim_mpu_fifo_period(void) {
+	return 1000000ULL * (1 + i2c_regs[SIM_IMU_BUS][SIM_IMU_ADDR][SIM_MPU_SMPLRT_DIV]);
+}
+
+// Must be called with sim_lock held
+static void sim_mpu_fifo_reset(void) {
+	mpu_fifo_nanos = sim_nanos(CLOCK_MONOTONIC);
+	mpu_fifo_records = 0;
+	mpu_fifo_read = 0;
+	i2c_regs[SIM_IMU_BUS][SIM_IMU_ADDR][SIM_MPU_INT_STATUS] &= (uint8_t)~0x10;
+}
+
+// Must be called with sim_lock held. A full FIFO overwrites its oldest
+// bytes, which (as on the chip) breaks record alignment.
+static uint64_t sim_mpu_fifo_update(void) {
+	uint64_t now = sim_nanos(CLOCK_MONOTONIC);
+	uint64_t period = sim_mpu_fifo_period();
+	uint64_t size = (uint64_t)sim_mpu_fifo_record_size();
+	uint64_t n;
+
+	if (!(i2c_regs[SIM_IMU_BUS][SIM_IMU_ADDR][SIM_MPU_USER_CTRL] & 0x40) || size == 0) {
+		mpu_fifo_nanos = now;
+		return mpu_fifo_records * size - mpu_fifo_read;
+	}
+
+	n = (now - mpu_fifo_nanos) / period;
+	mpu_fifo_records += n;
+	mpu_fifo_nanos += n * period;
+
+	if (mpu_fifo_records * size - mpu_fifo_read > SIM_MPU_FIFO_SIZE) {
+		mpu_fifo_read = mpu_fifo_records * size - SIM_MPU_FIFO_SIZE;
+		i2c_regs[SIM_IMU_BUS][SIM_IMU_ADDR][SIM_MPU_INT_STATUS] |= 0x10;
+	}
+
+	return mpu_fifo_records * size - mpu_fifo_read;
+}
+
+// Must be called with sim_lock held; record k of a level board with
+// 0.5 m/s² of 80 Hz vibration along z
+static void sim_mpu_fifo_record(uint64_t k, uint8_t *record) {
+	uint8_t enabled = i2c_regs[SIM_IMU_BUS][SIM_IMU_ADDR][SIM_MPU_FIFO_EN];
+	double t = (double)(k * sim_mpu_fifo_period()) * 1e-9;
+	float accel_lsb = 9.80665f * imu_accel_fsr_g[imu_config.accel_fsr] / 32768.0f;
+	float gyro_lsb = imu_gyro_fsr_dps[imu_config.gyro_fsr] / 32768.0f;
+	int16_t values[7];
+	int count = 0;
+	int i;
+
+	if (enabled & 0x08) {
+		values[count++] = 0;
+		values[count++] = 0;
+		values[count++] = (int16_t)lrintf((9.80665f + 0.5f * (float)sin(2.0 * M_PI * 80.0 * t)) / accel_lsb);
+	}
+	if (enabled & 0x80)
+		values[count++] = (int16_t)lrintf((30.0f - 21.0f) * 333.87f);
+	if (enabled & 0x40)
+		values[count++] = 0;
+	if (enabled & 0x20)
+		values[count++] = 0;
+	if (enabled & 0x10)
+		values[count++] = (int16_t)lrint(SIM_IMU_YAW_DEG_S / gyro_lsb);
+
+	for (i = 0; i < count; i++) {
+		record[2 * i] = (uint8_t)((uint16_t)values[i] >> 8);
+		record[2 * i + 1] = (uint8_t)values[i];
+	}
+}
+
+// Must be called with sim_lock held; serves the MPU-9250 registers
+// backed by the FIFO model. Returns 1 if regAddr is one of them.
+static int sim_mpu_read(uint8_t regAddr, uint8_t length, uint8_t *data) {
+	uint8_t record[14];
+	uint64_t available;
+	uint64_t size;
+	uint64_t offset;
+	int i;
+
+	if (regAddr == SIM_MPU_INT_STATUS) {
+		sim_mpu_fifo_update();
+		data[0] = i2c_regs[SIM_IMU_BUS][SIM_IMU_ADDR][SIM_MPU_INT_STATUS];
+		i2c_regs[SIM_IMU_BUS][SIM_IMU_ADDR][SIM_MPU_INT_STATUS] = 0;
+		for (i = 1; i < length; i++)
+			data[i] = i2c_regs[SIM_IMU_BUS][SIM_IMU_ADDR][(uint8_t)(regAddr + i)];
+		return 1;
+	}
+
+	if (regAddr == SIM_MPU_FIFO_COUNTH) {
+		available = sim_mpu_fifo_update();
+		data[0] = (uint8_t)(available >> 8);
+		if (length > 1)
+			data[1] = (uint8_t)available;
+		if (length > 2)
+			sim_mpu_read(SIM_MPU_FIFO_R_W, length - 2, data + 2);
+		return 1;
+	}
+
+	if (regAddr == SIM_MPU_FIFO_R_W) {
+		available = sim_mpu_fifo_update();
+		size = (uint64_t)sim_mpu_fifo_record_size();
+		for (i = 0; i < length; i++) {
+			if ((uint64_t)i >= available || size == 0) {
+				data[i] = 0xff;
+				continue;
+			}
+			offset = mpu_fifo_read + (uint64_t)i;
+			sim_mpu_fifo_record(offset / size, record);
+			data[i] = record[offset % size];
+		}
+		mpu_fifo_read += (uint64_t)length < available ? length : available;
+		return 1;
+	}
+
+	return 0;
+}
+
+// Must be called with sim_lock held, after the register map has been
+// written. FIFO_RST is self clearing.
+static void sim_mpu_write(uint8_t regAddr, uint8_t length) {
+	uint8_t *user_ctrl = &i2c_regs[SIM_IMU_BUS][SIM_IMU_ADDR][SIM_MPU_USER_CTRL];
+
+	if ((uint8_t)(SIM_MPU_USER_CTRL - regAddr) < length && (*user_ctrl & 0x04)) {
+		*user_ctrl &= (uint8_t)~0x04;
+		sim_mpu_fifo_reset();
+	}
+}
+
+// Must be called with sim_lock held
+static void sim_load_i2c_regs(void) {
+	if (i2c_regs_loaded)
+		return;
+
+	i2c_regs[2][0x68][0x75] = 0x71;		// MPU-9250 WHO_AM_I
+	i2c_regs[2][0x76][0xd0] = 0x58;		// BMP280 chip id
+	i2c_regs_loaded = 1;
+}
+
+
+// Flow control, LEDs and buttons
+int rc_initialize(void) {
+	pthread_mutex_lock(&sim_lock);
+	sim_load_i2c_regs();
+	state = PAUSED;
+	pthread_mutex_unlock(&sim_lock);
+
+	return 0;
+}
+
+int rc_cleanup(void) {
+	rc_stop_dsm_service();
+
+	pthread_mutex_lock(&sim_lock);
+	state = EXITING;
+	motors_enabled = 0;
+	pthread_mutex_unlock(&sim_lock);
+
+	return 0;
+}
+
+rc_state_t rc_get_state(void) {
+	rc_state_t current;
+
+	pthread_mutex_lock(&sim_lock);
+	current = state;
+	pthread_mutex_unlock(&sim_lock);
+
+	return current;
+}
+
+int rc_set_state(rc_state_t new_state) {
+	pthread_mutex_lock(&sim_lock);
+	state = new_state;
+	pthread_mutex_unlock(&sim_lock);
+
+	return 0;
+}
+
+int rc_set_led(int led, int on) {
+	if (led < 0 || led > 1)
+		return -1;
+
+	pthread_mutex_lock(&sim_lock);
+	led_state[led] = on ? 1 : 0;
+	pthread_mutex_unlock(&sim_lock);
+
+	return 0;
+}
+
+int rc_blink_led(int led, float hz, float period) {
+	if (led < 0 || led > 1 || hz <= 0.0f || period <= 0.0f)
+		return -1;
+
+	return 0;
+}
+
+int rc_gpio_get_value_mmap(int pin) {
+	int value;
+
+	pthread_mutex_lock(&sim_lock);
+	if (pin == SIM_GRN_LED)
+		value = led_state[0];
+	else if (pin == SIM_RED_LED)
+		value = led_state[1];
+	else
+		value = 0;
+	pthread_mutex_unlock(&sim_lock);
+
+	return value;
+}
+
+int rc_get_pause_button(void) {
+	return 0;
+}
+
+int rc_get_mode_button(void) {
+	return 0;
+}
+
+
+// Motors
+int rc_enable_motors(void) {
+	pthread_mutex_lock(&sim_lock);
+	sim_update_encoders();
+	motors_enabled = 1;
+	pthread_mutex_unlock(&sim_lock);
+
+	return 0;
+}
+
+int rc_disable_motors(void) {
+	pthread_mutex_lock(&sim_lock);
+	sim_update_encoders();
+	motors_enabled = 0;
+	pthread_mutex_unlock(&sim_lock);
+
+	return 0;
+}
+
+int rc_set_motor(int motor, float duty) {
+	if (motor < 1 || motor > SIM_MOTORS)
+		return -1;
+
+	if (duty > 1.0f)
+		duty = 1.0f;
+	else if (duty < -1.0f)
+		duty = -1.0f;
+
+	pthread_mutex_lock(&sim_lock);
+	sim_update_encoders();
+	motor_duty[motor - 1] = duty;
+	pthread_mutex_unlock(&sim_lock);
+
+	return 0;
+}
+
+int rc_set_motor_all(float duty) {
+	int i;
+
+	for (i = 1; i <= SIM_MOTORS; i++)
+		rc_set_motor(i, duty);
+
+	return 0;
+}
+
+int rc_set_motor_free_spin(int motor) {
+	return rc_set_motor(motor, 0.0f);
+}
+
+int rc_set_motor_free_spin_all(void) {
+	return rc_set_motor_all(0.0f);
+}
+
+int rc_set_motor_brake(int motor) {
+	return rc_set_motor(motor, 0.0f);
+}
+
+int rc_set_motor_brake_all(void) {
+	return rc_set_motor_all(0.0f);
+}
+
+
+// Encoders
+int rc_get_encoder_pos(int ch) {
+	int position;
+
+	if (ch < 1 || ch > SIM_ENCODERS)
+		return -1;
+
+	pthread_mutex_lock(&sim_lock);
+	sim_update_encoders();
+	position = (int)encoder_pos[ch - 1];
+	pthread_mutex_unlock(&sim_lock);
+
+	return position;
+}
+
+int rc_set_encoder_pos(int ch, int value) {
+	if (ch < 1 || ch > SIM_ENCODERS)
+		return -1;
+
+	pthread_mutex_lock(&sim_lock);
+	sim_update_encoders();
+	encoder_pos[ch - 1] = value;
+	pthread_mutex_unlock(&sim_lock);
+
+	return 0;
+}
+
+
+// ADC
+int rc_adc_raw(int ch) {
+	if (ch < 0 || ch >= SIM_ADC_CHANNELS)
+		return -1;
+
+	return adc_raw[ch];
+}
+
+float rc_adc_volt(int ch) {
+	if (ch < 0 || ch >= SIM_ADC_CHANNELS)
+		return -1.0f;
+
+	return adc_raw[ch] * 1.8f / 4095.0f;
+}
+
+float rc_battery_voltage(void) {
+	return rc_adc_volt(SIM_LIPO_ADC_CH) * SIM_V_DIV_RATIO;
+}
+
+float rc_dc_jack_voltage(void) {
+	return rc_adc_volt(SIM_DC_JACK_ADC_CH) * SIM_V_DIV_RATIO;
+}
+
+
+// Servos and ESCs
+int rc_enable_servo_power_rail(void) {
+	pthread_mutex_lock(&sim_lock);
+	servo_rail = 1;
+	pthread_mutex_unlock(&sim_lock);
+
+	return 0;
+}
+
+int rc_disable_servo_power_rail(void) {
+	pthread_mutex_lock(&sim_lock);
+	servo_rail = 0;
+	pthread_mutex_unlock(&sim_lock);
+
+	return 0;
+}
+
+int rc_send_servo_pulse_us(int ch, int us) {
+	if (ch < 1 || ch > SIM_SERVOS)
+		return -1;
+
+	pthread_mutex_lock(&sim_lock);
+	servo_last_us[ch - 1] = us;
+	servo_pulses[ch - 1]++;
+	pthread_mutex_unlock(&sim_lock);
+
+	return 0;
+}
+
+int rc_send_servo_pulse_us_all(int us) {
+	int i;
+
+	for (i = 1; i <= SIM_SERVOS; i++)
+		rc_send_servo_pulse_us(i, us);
+
+	return 0;
+}
+
+int rc_send_servo_pulse_normalized(int ch, float input) {
+	if (input < -1.5f || input > 1.5f)
+		return -1;
+
+	return rc_send_servo_pulse_us(ch, 1500 + (int)(input * 600.0f));
+}
+
+int rc_send_servo_pulse_normalized_all(float input) {
+	int i;
+
+	for (i = 1; i <= SIM_SERVOS; i++)
+		rc_send_servo_pulse_normalized(i, input);
+
+	return 0;
+}
+
+int rc_send_esc_pulse_normalized(int ch, float input) {
+	if (input < -0.1f || input > 1.0f)
+		return -1;
+
+	return rc_send_servo_pulse_us(ch, 1000 + (int)(input * 1000.0f));
+}
+
+int rc_send_esc_pulse_normalized_all(float input) {
+	int i;
+
+	for (i = 1; i <= SIM_SERVOS; i++)
+		rc_send_esc_pulse_normalized(i, input);
+
+	return 0;
+}
+
+int rc_send_oneshot_pulse_normalized(int ch, float input) {
+	if (input < -0.1f || input > 1.0f)
+		return -1;
+
+	return rc_send_servo_pulse_us(ch, 125 + (int)(input * 125.0f));
+}
+
+int rc_send_oneshot_pulse_normalized_all(float input) {
+	int i;
+
+	for (i = 1; i <= SIM_SERVOS; i++)
+		rc_send_oneshot_pulse_normalized(i, input);
+
+	return 0;
+}
+
+
+// DSM radio: a transmitter sweeping every stick sinusoidally
+static void *sim_dsm_thread(void *arg) {
+	uint64_t next = sim_nanos(CLOCK_MONOTONIC);
+	int (*func)(void);
+	double t;
+	int i;
+
+	for (;;) {
+		pthread_mutex_lock(&sim_lock);
+		if (!dsm_running) {
+			pthread_mutex_unlock(&sim_lock);
+			break;
+		}
+		t = (double)dsm_frames * SIM_DSM_PERIOD_NS * 1e-9;
+		for (i = 0; i < SIM_DSM_CHANNELS; i++)
+			dsm_raw[i] = 1500 + (int)(400.0 * sin(2.0 * M_PI * 0.5 * t + i));
+		dsm_frames++;
+		dsm_new_data = 1;
+		dsm_last_packet = sim_nanos(CLOCK_MONOTONIC);
+		func = dsm_data_func;
+		pthread_mutex_unlock(&sim_lock);
+
+		if (func != NULL)
+			func();
+
+		next += SIM_DSM_PERIOD_NS;
+		sim_delay(next > sim_nanos(CLOCK_MONOTONIC) ? next - sim_nanos(CLOCK_MONOTONIC) : 0);
+	}
+
+	return NULL;
+}
+
+int rc_initialize_dsm(void) {
+	pthread_mutex_lock(&sim_lock);
+	if (dsm_running) {
+		pthread_mutex_unlock(&sim_lock);
+		return 0;
+	}
+	dsm_running = 1;
+	pthread_mutex_unlock(&sim_lock);
+
+	if (pthread_create(&dsm_thread, NULL, sim_dsm_thread, NULL) != 0) {
+		pthread_mutex_lock(&sim_lock);
+		dsm_running = 0;
+		pthread_mutex_unlock(&sim_lock);
+		return -1;
+	}
+
+	return 0;
+}
+
+int rc_stop_dsm_service(void) {
+	int running;
+
+	pthread_mutex_lock(&sim_lock);
+	running = dsm_running;
+	dsm_running = 0;
+	pthread_mutex_unlock(&sim_lock);
+
+	if (running)
+		pthread_join(dsm_thread, NULL);
+
+	return 0;
+}
+
+int rc_get_dsm_ch_raw(int channel) {
+	int raw;
+
+	if (channel < 1 || channel > 9)
+		return -1;
+
+	pthread_mutex_lock(&sim_lock);
+	raw = (channel <= SIM_DSM_CHANNELS && dsm_frames > 0) ? dsm_raw[channel - 1] : 0;
+	dsm_new_data = 0;
+	pthread_mutex_unlock(&sim_lock);
+
+	return raw;
+}
+
+float rc_get_dsm_ch_normalized(int channel) {
+	int raw;
+
+	if (channel < 1 || channel > 9)
+		return -1.0f;
+
+	pthread_mutex_lock(&sim_lock);
+	raw = (channel <= SIM_DSM_CHANNELS && dsm_frames > 0) ? dsm_raw[channel - 1] : 0;
+	dsm_new_data = 0;
+	pthread_mutex_unlock(&sim_lock);
+
+	return (raw == 0) ? 0.0f : (raw - 1500) / 400.0f;
+}
+
+int rc_is_new_dsm_data(void) {
+	int new_data;
+
+	pthread_mutex_lock(&sim_lock);
+	new_data = dsm_new_data;
+	pthread_mutex_unlock(&sim_lock);
+
+	return new_data;
+}
+
+int rc_set_dsm_data_func(int (*func)(void)) {
+	pthread_mutex_lock(&sim_lock);
+	dsm_data_func = func;
+	pthread_mutex_unlock(&sim_lock);
+
+	return 0;
+}
+
+int rc_is_dsm_active(void) {
+	return rc_nanos_since_last_dsm_packet() < 4 * (uint64_t)SIM_DSM_PERIOD_NS;
+}
+
+uint64_t rc_nanos_since_last_dsm_packet(void) {
+	uint64_t last;
+
+	pthread_mutex_lock(&sim_lock);
+	last = dsm_last_packet;
+	pthread_mutex_unlock(&sim_lock);
+
+	if (last == 0)
+		return UINT64_MAX;
+
+	return sim_nanos(CLOCK_MONOTONIC) - last;
+}
+
+int rc_get_dsm_resolution(void) {
+	int frames;
+
+	pthread_mutex_lock(&sim_lock);
+	frames = (dsm_frames > 0);
+	pthread_mutex_unlock(&sim_lock);
+
+	return frames ? 11 : 0;
+}
+
+int rc_num_dsm_channels(void) {
+	int frames;
+
+	pthread_mutex_lock(&sim_lock);
+	frames = (dsm_frames > 0);
+	pthread_mutex_unlock(&sim_lock);
+
+	return frames ? SIM_DSM_CHANNELS : 0;
+}
+
+int rc_bind_dsm(void) {
+	return 0;
+}
+
+int rc_calibrate_dsm_routine(void) {
+	return 0;
+}
+
+
+// BMP280 barometer: 25 °C, pressure oscillating 2 Pa around sea level
+int rc_initialize_barometer(rc_bmp_oversample_t oversample, rc_bmp_filter_t filter) {
+	sim_i2c_delay(4);
+
+	pthread_mutex_lock(&sim_lock);
+	bmp_initialized = 1;
+	bmp_oversample = oversample;
+	pthread_mutex_unlock(&sim_lock);
+
+	return 0;
+}
+
+int rc_power_off_barometer(void) {
+	sim_i2c_delay(2);
+
+	pthread_mutex_lock(&sim_lock);
+	bmp_initialized = 0;
+	pthread_mutex_unlock(&sim_lock);
+
+	return 0;
+}
+
+int rc_read_barometer(void) {
+	double t;
+	int initialized;
+
+	pthread_mutex_lock(&sim_lock);
+	initialized = bmp_initialized;
+	pthread_mutex_unlock(&sim_lock);
+
+	if (!initialized)
+		return -1;
+
+	sim_i2c_delay(6);
+
+	t = (double)sim_nanos(CLOCK_MONOTONIC) * 1e-9;
+
+	pthread_mutex_lock(&sim_lock);
+	bmp_temperature = 25.0f;
+	bmp_pressure = 101325.0f + 2.0f * (float)sin(2.0 * M_PI * 0.1 * t);
+	pthread_mutex_unlock(&sim_lock);
+
+	return 0;
+}
+
+float rc_bmp_get_temperature(void) {
+	float celsius;
+
+	pthread_mutex_lock(&sim_lock);
+	celsius = bmp_temperature;
+	pthread_mutex_unlock(&sim_lock);
+
+	return celsius;
+}
+
+float rc_bmp_get_pressure_pa(void) {
+	float pa;
+
+	pthread_mutex_lock(&sim_lock);
+	pa = bmp_pressure;
+	pthread_mutex_unlock(&sim_lock);
+
+	return pa;
+}
+
+float rc_bmp_get_altitude_m(void) {
+	float pa;
+	float sea_level_pa;
+
+	pthread_mutex_lock(&sim_lock);
+	pa = bmp_pressure;
+	sea_level_pa = bmp_sea_level_pa;
+	pthread_mutex_unlock(&sim_lock);
+
+	if (pa <= 0.0f)
+		return 0.0f;
+
+	return 44330.0f * (1.0f - powf(pa / sea_level_pa, 0.1903f));
+}
+
+int rc_set_sea_level_pressure_pa(float pa) {
+	if (pa < 80000.0f || pa > 120000.0f)
+		return -1;
+
+	pthread_mutex_lock(&sim_lock);
+	bmp_sea_level_pa = pa;
+	pthread_mutex_unlock(&sim_lock);
+
+	return 0;
+}
+
+
+// MPU-9250 IMU: a level board yawing at a constant rate
+rc_imu_config_t rc_default_imu_config(void) {
+	rc_imu_config_t conf;
+
+	rc_set_imu_config_to_defaults(&conf);
+
+	return conf;
+}
+
+int rc_set_imu_config_to_defaults(rc_imu_config_t *conf) {
+	conf->accel_fsr = A_FSR_4G;
+	conf->gyro_fsr = G_FSR_1000DPS;
+	conf->accel_dlpf = ACCEL_DLPF_184;
+	conf->gyro_dlpf = GYRO_DLPF_184;
+	conf->enable_magnetometer = 0;
+	conf->dmp_sample_rate = 100;
+	conf->dmp_fetch_accel_gyro = 1;
+	conf->dmp_auto_calibrate_gyro = 0;
+	conf->orientation = ORIENTATION_Z_UP;
+	conf->compass_time_constant = 5.0f;
+	conf->dmp_interrupt_priority = 98;
+	conf->show_warnings = 0;
+
+	return 0;
+}
+
+// Must be called with sim_lock held
+static double sim_imu_yaw_deg(void) {
+	double t = (double)(sim_nanos(CLOCK_MONOTONIC) - imu_start_nanos) * 1e-9;
+
+	return fmod(SIM_IMU_YAW_DEG_S * t + 180.0, 360.0) - 180.0;
+}
+
+// Must be called with sim_lock held
+static void sim_imu_fill_accel(rc_imu_data_t *data) {
+	int i;
+
+	data->accel_to_ms2 = 9.80665f * imu_accel_fsr_g[imu_config.accel_fsr] / 32768.0f;
+	data->accel[0] = 0.0f;
+	data->accel[1] = 0.0f;
+	data->accel[2] = 9.80665f;
+	for (i = 0; i < 3; i++)
+		data->raw_accel[i] = (int16_t)lrintf(data->accel[i] / data->accel_to_ms2);
+}
+
+// Must be called with sim_lock held
+static void sim_imu_fill_gyro(rc_imu_data_t *data) {
+	int i;
+
+	data->gyro_to_degs = imu_gyro_fsr_dps[imu_config.gyro_fsr] / 32768.0f;
+	data->gyro[0] = 0.0f;
+	data->gyro[1] = 0.0f;
+	data->gyro[2] = (float)SIM_IMU_YAW_DEG_S;
+	for (i = 0; i < 3; i++)
+		data->raw_gyro[i] = (int16_t)lrintf(data->gyro[i] / data->gyro_to_degs);
+}
+
+// Must be called with sim_lock held; 20 µT north, 40 µT down
+static void sim_imu_fill_mag(rc_imu_data_t *data, double yaw) {
+	data->mag[0] = (float)(20.0 * cos(yaw));
+	data->mag[1] = (float)(-20.0 * sin(yaw));
+	data->mag[2] = -40.0f;
+}
+
+int rc_initialize_imu(rc_imu_data_t *data, rc_imu_config_t conf) {
+	if (conf.accel_fsr < A_FSR_2G || conf.accel_fsr > A_FSR_16G
+			|| conf.gyro_fsr < G_FSR_250DPS || conf.gyro_fsr > G_FSR_2000DPS)
+		return -1;
+
+	sim_i2c_delay(16);
+
+	pthread_mutex_lock(&sim_lock);
+	if (imu_dmp_running) {
+		pthread_mutex_unlock(&sim_lock);
+		return -1;
+	}
+	imu_config = conf;
+	imu_initialized = 1;
+	imu_start_nanos = sim_nanos(CLOCK_MONOTONIC);
+	sim_load_i2c_regs();
+	i2c_initialized[SIM_IMU_BUS] = 1;
+	i2c_address[SIM_IMU_BUS] = SIM_IMU_ADDR;
+	i2c_regs[SIM_IMU_BUS][SIM_IMU_ADDR][SIM_MPU_SMPLRT_DIV] = 0;
+	i2c_regs[SIM_IMU_BUS][SIM_IMU_ADDR][SIM_MPU_FIFO_EN] = 0;
+	i2c_regs[SIM_IMU_BUS][SIM_IMU_ADDR][SIM_MPU_USER_CTRL] = 0;
+	sim_mpu_fifo_reset();
+	imu_last_read_ok = 1;
+	sim_imu_fill_accel(data);
+	sim_imu_fill_gyro(data);
+	pthread_mutex_unlock(&sim_lock);
+
+	return 0;
+}
+
+int rc_read_accel_data(rc_imu_data_t *data) {
+	int initialized;
+
+	sim_i2c_delay(6);
+
+	pthread_mutex_lock(&sim_lock);
+	initialized = imu_initialized && !imu_dmp_running;
+	if (initialized)
+		sim_imu_fill_accel(data);
+	imu_last_read_ok = initialized;
+	pthread_mutex_unlock(&sim_lock);
+
+	return initialized ? 0 : -1;
+}
+
+int rc_read_gyro_data(rc_imu_data_t *data) {
+	int initialized;
+
+	sim_i2c_delay(6);
+
+	pthread_mutex_lock(&sim_lock);
+	initialized = imu_initialized && !imu_dmp_running;
+	if (initialized)
+		sim_imu_fill_gyro(data);
+	imu_last_read_ok = initialized;
+	pthread_mutex_unlock(&sim_lock);
+
+	return initialized ? 0 : -1;
+}
+
+int rc_read_mag_data(rc_imu_data_t *data) {
+	int initialized;
+
+	sim_i2c_delay(7);
+
+	pthread_mutex_lock(&sim_lock);
+	initialized = imu_initialized && !imu_dmp_running && imu_config.enable_magnetometer;
+	if (initialized)
+		sim_imu_fill_mag(data, sim_imu_yaw_deg() * M_PI / 180.0);
+	imu_last_read_ok = initialized;
+	pthread_mutex_unlock(&sim_lock);
+
+	return initialized ? 0 : -1;
+}
+
+int rc_read_imu_temp(rc_imu_data_t *data) {
+	int initialized;
+
+	sim_i2c_delay(2);
+
+	pthread_mutex_lock(&sim_lock);
+	initialized = imu_initialized && !imu_dmp_running;
+	if (initialized)
+		data->temp = 30.0f;
+	imu_last_read_ok = initialized;
+	pthread_mutex_unlock(&sim_lock);
+
+	return initialized ? 0 : -1;
+}
+
+int rc_calibrate_gyro_routine(void) {
+	sim_delay(500000000ULL);
+
+	pthread_mutex_lock(&sim_lock);
+	imu_gyro_calibrated = 1;
+	pthread_mutex_unlock(&sim_lock);
+
+	return 0;
+}
+
+int rc_calibrate_mag_routine(void) {
+	sim_delay(500000000ULL);
+
+	pthread_mutex_lock(&sim_lock);
+	imu_mag_calibrated = 1;
+	pthread_mutex_unlock(&sim_lock);
+
+	return 0;
+}
+
+int rc_is_gyro_calibrated(void) {
+	int calibrated;
+
+	pthread_mutex_lock(&sim_lock);
+	calibrated = imu_gyro_calibrated;
+	pthread_mutex_unlock(&sim_lock);
+
+	return calibrated;
+}
+
+int rc_is_mag_calibrated(void) {
+	int calibrated;
+
+	pthread_mutex_lock(&sim_lock);
+	calibrated = imu_mag_calibrated;
+	pthread_mutex_unlock(&sim_lock);
+
+	return calibrated;
+}
+
+static void *sim_imu_thread(void *arg) {
+	uint64_t next = sim_nanos(CLOCK_MONOTONIC);
+	uint64_t period;
+	int (*func)(void);
+	rc_imu_data_t *data;
+	double yaw;
+
+	for (;;) {
+		sim_i2c_delay(imu_config.enable_magnetometer ? 35 : 28);
+
+		pthread_mutex_lock(&sim_lock);
+		if (!imu_dmp_running) {
+			pthread_mutex_unlock(&sim_lock);
+			break;
+		}
+		data = imu_dmp_data;
+		yaw = sim_imu_yaw_deg() * M_PI / 180.0;
+		if (imu_config.dmp_fetch_accel_gyro) {
+			sim_imu_fill_accel(data);
+			sim_imu_fill_gyro(data);
+		}
+		data->dmp_quat[0] = (float)cos(yaw / 2.0);
+		data->dmp_quat[1] = 0.0f;
+		data->dmp_quat[2] = 0.0f;
+		data->dmp_quat[3] = (float)sin(yaw / 2.0);
+		data->dmp_TaitBryan[0] = 0.0f;
+		data->dmp_TaitBryan[1] = 0.0f;
+		data->dmp_TaitBryan[2] = (float)yaw;
+		if (imu_config.enable_magnetometer) {
+			sim_imu_fill_mag(data, yaw);
+			memcpy(data->fused_quat, data->dmp_quat, sizeof(data->fused_quat));
+			memcpy(data->fused_TaitBryan, data->dmp_TaitBryan, sizeof(data->fused_TaitBryan));
+			data->compass_heading = (float)yaw;
+			data->compass_heading_raw = (float)yaw;
+		}
+		imu_last_read_ok = 1;
+		imu_last_interrupt = sim_nanos(CLOCK_MONOTONIC);
+		func = imu_interrupt_func;
+		period = 1000000000ULL / (uint64_t)imu_config.dmp_sample_rate;
+		pthread_mutex_unlock(&sim_lock);
+
+		if (func != NULL)
+			func();
+
+		next += period;
+		sim_delay(next > sim_nanos(CLOCK_MONOTONIC) ? next - sim_nanos(CLOCK_MONOTONIC) : 0);
+	}
+
+	return NULL;
+}
+
+int rc_initialize_imu_dmp(rc_imu_data_t *data, rc_imu_config_t conf) {
+	if (conf.dmp_sample_rate < 4 || conf.dmp_sample_rate > 200
+			|| 200 % conf.dmp_sample_rate != 0)
+		return -1;
+
+	if (rc_initialize_imu(data, conf) < 0)
+		return -1;
+
+	// DMP firmware upload
+	sim_i2c_delay(3062);
+
+	// Like the library, start with no interrupt function set
+	pthread_mutex_lock(&sim_lock);
+	imu_dmp_data = data;
+	imu_dmp_running = 1;
+	imu_interrupt_func = NULL;
+	imu_last_interrupt = sim_nanos(CLOCK_MONOTONIC);
+	pthread_mutex_unlock(&sim_lock);
+
+	if (pthread_create(&imu_thread, NULL, sim_imu_thread, NULL) != 0) {
+		pthread_mutex_lock(&sim_lock);
+		imu_dmp_running = 0;
+		pthread_mutex_unlock(&sim_lock);
+		return -1;
+	}
+
+	return 0;
+}
+
+int rc_set_imu_interrupt_func(int (*func)(void)) {
+	pthread_mutex_lock(&sim_lock);
+	imu_interrupt_func = func;
+	pthread_mutex_unlock(&sim_lock);
+
+	return 0;
+}
+
+int rc_stop_imu_interrupt_func(void) {
+	pthread_mutex_lock(&sim_lock);
+	imu_interrupt_func = NULL;
+	pthread_mutex_unlock(&sim_lock);
+
+	return 0;
+}
+
+int rc_power_off_imu(void) {
+	int running;
+
+	pthread_mutex_lock(&sim_lock);
+	running = imu_dmp_running;
+	imu_dmp_running = 0;
+	imu_interrupt_func = NULL;
+	pthread_mutex_unlock(&sim_lock);
+
+	if (running)
+		pthread_join(imu_thread, NULL);
+
+	sim_i2c_delay(2);
+
+	pthread_mutex_lock(&sim_lock);
+	imu_initialized = 0;
+	imu_dmp_data = NULL;
+	i2c_regs[SIM_IMU_BUS][SIM_IMU_ADDR][SIM_MPU_FIFO_EN] = 0;
+	i2c_regs[SIM_IMU_BUS][SIM_IMU_ADDR][SIM_MPU_USER_CTRL] = 0;
+	pthread_mutex_unlock(&sim_lock);
+
+	return 0;
+}
+
+int rc_was_last_imu_read_successful(void) {
+	int ok;
+
+	pthread_mutex_lock(&sim_lock);
+	ok = imu_last_read_ok;
+	pthread_mutex_unlock(&sim_lock);
+
+	return ok;
+}
+
+uint64_t rc_nanos_since_last_imu_interrupt(void) {
+	uint64_t last;
+
+	pthread_mutex_lock(&sim_lock);
+	last = imu_dmp_running ? imu_last_interrupt : 0;
+	pthread_mutex_unlock(&sim_lock);
+
+	if (last == 0)
+		return UINT64_MAX;
+
+	return sim_nanos(CLOCK_MONOTONIC) - last;
+}
+
+
+// I²C: one 256 byte register map per bus and device address
+static int sim_i2c_check(int bus) {
+	if (bus < 1 || bus >= SIM_I2C_BUSSES)
+		return -1;
+
+	return i2c_initialized[bus] ? 0 : -1;
+}
+
+int rc_i2c_init(int bus, uint8_t devAddr) {
+	if (bus < 1 || bus >= SIM_I2C_BUSSES || devAddr > 0x7f)
+		return -1;
+
+	pthread_mutex_lock(&sim_lock);
+	sim_load_i2c_regs();
+	i2c_initialized[bus] = 1;
+	i2c_address[bus] = devAddr;
+	pthread_mutex_unlock(&sim_lock);
+
+	return 0;
+}
+
+int rc_i2c_close(int bus) {
+	if (bus < 1 || bus >= SIM_I2C_BUSSES)
+		return -1;
+
+	pthread_mutex_lock(&sim_lock);
+	i2c_initialized[bus] = 0;
+	pthread_mutex_unlock(&sim_lock);
+
+	return 0;
+}
+
+int rc_i2c_set_device_address(int bus, uint8_t devAddr) {
+	if (bus < 1 || bus >= SIM_I2C_BUSSES || devAddr > 0x7f)
+		return -1;
+
+	pthread_mutex_lock(&sim_lock);
+	i2c_address[bus] = devAddr;
+	pthread_mutex_unlock(&sim_lock);
+
+	return 0;
+}
+
+int rc_i2c_claim_bus(int bus) {
+	if (bus < 1 || bus >= SIM_I2C_BUSSES)
+		return -1;
+
+	pthread_mutex_lock(&sim_lock);
+	i2c_in_use[bus] = 1;
+	pthread_mutex_unlock(&sim_lock);
+
+	return 0;
+}
+
+int rc_i2c_release_bus(int bus) {
+	if (bus < 1 || bus >= SIM_I2C_BUSSES)
+		return -1;
+
+	pthread_mutex_lock(&sim_lock);
+	i2c_in_use[bus] = 0;
+	pthread_mutex_unlock(&sim_lock);
+
+	return 0;
+}
+
+int rc_i2c_get_in_use_state(int bus) {
+	int in_use;
+
+	if (bus < 1 || bus >= SIM_I2C_BUSSES)
+		return -1;
+
+	pthread_mutex_lock(&sim_lock);
+	in_use = i2c_in_use[bus];
+	pthread_mutex_unlock(&sim_lock);
+
+	return in_use;
+}
+
+int rc_i2c_read_bytes(int bus, uint8_t regAddr, uint8_t length, uint8_t *data) {
+	int i;
+
+	pthread_mutex_lock(&sim_lock);
+	if (sim_i2c_check(bus) < 0) {
+		pthread_mutex_unlock(&sim_lock);
+		return -1;
+	}
+	if (bus != SIM_IMU_BUS || i2c_address[bus] != SIM_IMU_ADDR || !sim_mpu_read(regAddr, length, data))
+		for (i = 0; i < length; i++)
+			data[i] = i2c_regs[bus][i2c_address[bus]][(uint8_t)(regAddr + i)];
+	pthread_mutex_unlock(&sim_lock);
+
+	sim_i2c_delay(1 + length);
+
+	return length;
+}
+
+int rc_i2c_read_byte(int bus, uint8_t regAddr, uint8_t *data) {
+	return (rc_i2c_read_bytes(bus, regAddr, 1, data) < 0) ? -1 : 0;
+}
+
+int rc_i2c_read_words(int bus, uint8_t regAddr, uint8_t length, uint16_t *data) {
+	uint8_t bytes[512];
+	int i;
+
+	if (rc_i2c_read_bytes(bus, regAddr, (uint8_t)(2 * length), bytes) < 0)
+		return -1;
+
+	for (i = 0; i < length; i++)
+		data[i] = (uint16_t)((bytes[2 * i] << 8) | bytes[2 * i + 1]);
+
+	return length;
+}
+
+int rc_i2c_read_word(int bus, uint8_t regAddr, uint16_t *data) {
+	return (rc_i2c_read_words(bus, regAddr, 1, data) < 0) ? -1 : 0;
+}
+
+int rc_i2c_read_bit(int bus, uint8_t regAddr, uint8_t bitNum, uint8_t *data) {
+	uint8_t byte;
+
+	if (rc_i2c_read_byte(bus, regAddr, &byte) < 0)
+		return -1;
+
+	*data = (byte >> bitNum) & 0x01;
+
+	return 0;
+}
+
+int rc_i2c_write_bytes(int bus, uint8_t regAddr, uint8_t length, uint8_t *data) {
+	int i;
+
+	pthread_mutex_lock(&sim_lock);
+	if (sim_i2c_check(bus) < 0) {
+		pthread_mutex_unlock(&sim_lock);
+		return -1;
+	}
+	if (bus == SIM_IMU_BUS && i2c_address[bus] == SIM_IMU_ADDR)
+		sim_mpu_fifo_update();
+	for (i = 0; i < length; i++)
+		i2c_regs[bus][i2c_address[bus]][(uint8_t)(regAddr + i)] = data[i];
+	if (bus == SIM_IMU_BUS && i2c_address[bus] == SIM_IMU_ADDR)
+		sim_mpu_write(regAddr, length);
+	pthread_mutex_unlock(&sim_lock);
+
+	sim_i2c_delay(1 + length);
+
+	return 0;
+}
+
+int rc_i2c_write_byte(int bus, uint8_t regAddr, uint8_t data) {
+	return rc_i2c_write_bytes(bus, regAddr, 1, &data);
+}
+
+int rc_i2c_write_words(int bus, uint8_t regAddr, uint8_t length, uint16_t *data) {
+	uint8_t bytes[512];
+	int i;
+
+	for (i = 0; i < length; i++) {
+		bytes[2 * i] = (uint8_t)(data[i] >> 8);
+		bytes[2 * i + 1] = (uint8_t)(data[i] & 0xff);
+	}
+
+	return rc_i2c_write_bytes(bus, regAddr, (uint8_t)(2 * length), bytes);
+}
+
+int rc_i2c_write_word(int bus, uint8_t regAddr, uint16_t data) {
+	return rc_i2c_write_words(bus, regAddr, 1, &data);
+}
+
+int rc_i2c_write_bit(int bus, uint8_t regAddr, uint8_t bitNum, uint8_t data) {
+	uint8_t byte;
+
+	if (rc_i2c_read_byte(bus, regAddr, &byte) < 0)
+		return -1;
+
+	byte = data ? (byte | (1 << bitNum)) : (byte & ~(1 << bitNum));
+
+	return rc_i2c_write_byte(bus, regAddr, byte);
+}
+
+int rc_i2c_send_bytes(int bus, uint8_t length, uint8_t *data) {
+	pthread_mutex_lock(&sim_lock);
+	if (sim_i2c_check(bus) < 0) {
+		pthread_mutex_unlock(&sim_lock);
+		return -1;
+	}
+	pthread_mutex_unlock(&sim_lock);
+
+	sim_i2c_delay(length);
+
+	return 0;
+}
+
+int rc_i2c_send_byte(int bus, uint8_t data) {
+	return rc_i2c_send_bytes(bus, 1, &data);
+}
+
+
+// SPI: MISO looped back to MOSI on both slaves
+static int sim_spi_check(int slave) {
+	if (slave < 1 || slave > SIM_SPI_SLAVES)
+		return -1;
+
+	return spi_initialized[slave] ? 0 : -1;
+}
+
+// Clocks bytes through slave and sleeps for the time the bus needs
+static int sim_spi_clock(int slave, int bytes) {
+	int speed_hz;
+
+	if (bytes < 1)
+		return -1;
+
+	pthread_mutex_lock(&sim_lock);
+	if (sim_spi_check(slave) < 0) {
+		pthread_mutex_unlock(&sim_lock);
+		return -1;
+	}
+	speed_hz = spi_speed_hz[slave];
+	pthread_mutex_unlock(&sim_lock);
+
+	sim_delay(SIM_SPI_SETUP_NS + (uint64_t)bytes * 8ULL * 1000000000ULL / (uint64_t)speed_hz);
+
+	return bytes;
+}
+
+int rc_spi_init(ss_mode_t ss_mode, int spi_mode, int speed_hz, int slave) {
+	if (slave < 1 || slave > SIM_SPI_SLAVES || spi_mode < 0 || spi_mode > 3
+			|| speed_hz < 1000 || speed_hz > 24000000
+			|| (ss_mode != SS_MODE_AUTO && ss_mode != SS_MODE_MANUAL))
+		return -1;
+
+	pthread_mutex_lock(&sim_lock);
+	spi_initialized[slave] = 1;
+	spi_ss_mode[slave] = ss_mode;
+	spi_speed_hz[slave] = speed_hz;
+	spi_selected[slave] = 0;
+	pthread_mutex_unlock(&sim_lock);
+
+	return 0;
+}
+
+int rc_spi_fd(int slave) {
+	int fd;
+
+	pthread_mutex_lock(&sim_lock);
+	fd = (sim_spi_check(slave) < 0) ? -1 : 100 + slave;
+	pthread_mutex_unlock(&sim_lock);
+
+	return fd;
+}
+
+int rc_spi_close(int slave) {
+	if (slave < 1 || slave > SIM_SPI_SLAVES)
+		return -1;
+
+	pthread_mutex_lock(&sim_lock);
+	spi_initialized[slave] = 0;
+	pthread_mutex_unlock(&sim_lock);
+
+	return 0;
+}
+
+static int sim_spi_select(int slave, int selected) {
+	int retval = -1;
+
+	pthread_mutex_lock(&sim_lock);
+	if (sim_spi_check(slave) == 0 && spi_ss_mode[slave] == SS_MODE_MANUAL) {
+		spi_selected[slave] = selected;
+		retval = 0;
+	}
+	pthread_mutex_unlock(&sim_lock);
+
+	return retval;
+}
+
+int rc_manual_select_spi_slave(int slave) {
+	return sim_spi_select(slave, 1);
+}
+
+int rc_manual_deselect_spi_slave(int slave) {
+	return sim_spi_select(slave, 0);
+}
+
+int rc_spi_send_bytes(char *data, int bytes, int slave) {
+	return sim_spi_clock(slave, bytes);
+}
+
+int rc_spi_read_bytes(char *data, int bytes, int slave) {
+	if (sim_spi_clock(slave, bytes) < 0)
+		return -1;
+
+	memset(data, 0, (size_t)bytes);
+
+	return bytes;
+}
+
+int rc_spi_transfer(char *tx_data, int tx_bytes, char *rx_data, int slave) {
+	if (sim_spi_clock(slave, tx_bytes) < 0)
+		return -1;
+
+	memmove(rx_data, tx_data, (size_t)tx_bytes);
+
+	return tx_bytes;
+}
+
+
+// UART: TX is delayed by the time on the wire, then looped back to RX
+static int sim_uart_fd(int bus, int end, int *timeout_ms, int *baudrate) {
+	int fd;
+
+	if (bus < 0 || bus >= SIM_UART_BUSES)
+		return -1;
+
+	pthread_mutex_lock(&sim_lock);
+	fd = uart_pipe[bus][end];
+	if (timeout_ms != NULL)
+		*timeout_ms = uart_timeout_ms[bus];
+	if (baudrate != NULL)
+		*baudrate = uart_baudrate[bus];
+	pthread_mutex_unlock(&sim_lock);
+
+	return fd;
+}
+
+int rc_uart_init(int bus, int baudrate, float timeout) {
+	int fds[2];
+
+	if (bus < 0 || bus >= SIM_UART_BUSES || baudrate <= 0 || timeout < 0.0f || timeout > 25.5f)
+		return -1;
+
+	rc_uart_close(bus);
+
+	if (pipe(fds) < 0)
+		return -1;
+	fcntl(fds[0], F_SETFL, O_NONBLOCK);
+	fcntl(fds[1], F_SETFL, O_NONBLOCK);
+
+	pthread_mutex_lock(&sim_lock);
+	uart_pipe[bus][0] = fds[0];
+	uart_pipe[bus][1] = fds[1];
+	uart_baudrate[bus] = baudrate;
+	uart_timeout_ms[bus] = (int)lrintf(timeout * 10.0f) * 100;
+	pthread_mutex_unlock(&sim_lock);
+
+	return 0;
+}
+
+int rc_uart_close(int bus) {
+	int fds[2];
+
+	if (bus < 0 || bus >= SIM_UART_BUSES)
+		return -1;
+
+	pthread_mutex_lock(&sim_lock);
+	fds[0] = uart_pipe[bus][0];
+	fds[1] = uart_pipe[bus][1];
+	uart_pipe[bus][0] = -1;
+	uart_pipe[bus][1] = -1;
+	pthread_mutex_unlock(&sim_lock);
+
+	if (fds[0] >= 0) {
+		close(fds[0]);
+		close(fds[1]);
+	}
+
+	return 0;
+}
+
+int rc_uart_fd(int bus) {
+	return sim_uart_fd(bus, 0, NULL, NULL);
+}
+
+int rc_uart_flush(int bus) {
+	char discard[256];
+	int fd = sim_uart_fd(bus, 0, NULL, NULL);
+
+	if (fd < 0)
+		return -1;
+
+	while (read(fd, discard, sizeof(discard)) > 0)
+		;
+
+	return 0;
+}
+
+int rc_uart_send_bytes(int bus, int bytes, char *data) {
+	int baudrate;
+	int fd = sim_uart_fd(bus, 1, NULL, &baudrate);
+	ssize_t written;
+
+	if (fd < 0 || bytes < 1)
+		return -1;
+
+	// 8N1: 10 bits per byte
+	sim_delay((uint64_t)bytes * 10ULL * 1000000000ULL / (uint64_t)baudrate);
+
+	// A full RX FIFO drops the rest, like an overrun on the chip
+	written = write(fd, data, (size_t)bytes);
+
+	return (written < 0 && errno != EAGAIN) ? -1 : bytes;
+}
+
+int rc_uart_send_byte(int bus, char data) {
+	return rc_uart_send_bytes(bus, 1, &data);
+}
+
+int rc_uart_read_bytes(int bus, int bytes, char *buf) {
+	struct pollfd pfd;
+	int timeout_ms;
+	int count = 0;
+	ssize_t n;
+
+	pfd.fd = sim_uart_fd(bus, 0, &timeout_ms, NULL);
+	pfd.events = POLLIN;
+	if (pfd.fd < 0 || bytes < 1)
+		return -1;
+
+	while (count < bytes) {
+		n = read(pfd.fd, buf + count, (size_t)(bytes - count));
+		if (n > 0) {
+			count += (int)n;
+			continue;
+		}
+		if (n < 0 && errno != EAGAIN)
+			return -1;
+		if (poll(&pfd, 1, timeout_ms) <= 0)
+			break;
+	}
+
+	return count;
+}
+
+int rc_uart_read_line(int bus, int max_bytes, char *buf) {
+	int count = 0;
+	char c;
+
+	while (count < max_bytes) {
+		if (rc_uart_read_bytes(bus, 1, &c) != 1)
+			break;
+		if (c == '\n')
+			break;
+		buf[count++] = c;
+	}
+
+	return count;
+}
+
+int rc_uart_bytes_available(int bus) {
+	int fd = sim_uart_fd(bus, 0, NULL, NULL);
+	int available;
+
+	if (fd < 0 || ioctl(fd, FIONREAD, &available) < 0)
+		return -1;
+
+	return available;
+}
+
+
+// CPU and board
+int rc_set_cpu_freq(rc_cpu_freq_t freq) {
+	pthread_mutex_lock(&sim_lock);
+	cpu_freq = freq;
+	pthread_mutex_unlock(&sim_lock);
+
+	return 0;
+}
+
+rc_cpu_freq_t rc_get_cpu_freq(void) {
+	rc_cpu_freq_t freq;
+
+	pthread_mutex_lock(&sim_lock);
+	freq = cpu_freq;
+	pthread_mutex_unlock(&sim_lock);
+
+	return freq;
+}
+
+rc_bb_model_t rc_get_bb_model(void) {
+	return BB_BLUE;
+}
+
+
+// Time
+uint64_t rc_nanos_since_epoch(void) {
+	return sim_nanos(CLOCK_REALTIME);
+}
+
+uint64_t rc_nanos_since_boot(void) {
+	return sim_nanos(CLOCK_MONOTONIC);
+}
@@ -0,0 +1,290 @@
+/*
+ * roboticscape.h - Simulated libroboticscape for building and
+ * benchmarking the Python bindings off-target
+ *
+ * Copyright (C) 2017 Torsten Kurbad <beaglebone@tk-webart.de>
+ *
+ * Declares the subset of the libroboticscape API used by
+ * _roboticscapemodule.c with the same names, types and semantics.
+ * rc_sim.c implements it on top of in-memory device models with fixed,
+ * deterministic transaction times.
+ */
+
+#ifndef ROBOTICSCAPE_SIM_H
+#define ROBOTICSCAPE_SIM_H
+
+#include <stdint.h>
+
+#define ROBOTICSCAPE_SIMULATION 1
+
+// Simulated transaction times
+#define SIM_I2C_SETUP_NS		100000	// per I²C transaction
+#define SIM_I2C_BYTE_NS			25000	// per byte at 400 kHz
+#define SIM_DSM_PERIOD_NS		22000000	// DSM frame interval
+#define SIM_ENCODER_COUNTS_PER_S	20000	// encoder speed at duty 1.0
+#define SIM_IMU_YAW_DEG_S		10.0	// constant yaw rate of the board
+#define SIM_SPI_SETUP_NS		20000	// per SPI transfer (ioctl)
+
+
+// Types
+typedef enum rc_state_t {
+	UNINITIALIZED,
+	RUNNING,
+	PAUSED,
+	EXITING
+} rc_state_t;
+
+typedef enum rc_cpu_freq_t {
+	FREQ_ONDEMAND,
+	FREQ_300MHZ,
+	FREQ_600MHZ,
+	FREQ_800MHZ,
+	FREQ_1000MHZ
+} rc_cpu_freq_t;
+
+typedef enum rc_bb_model_t {
+	UNKNOWN_MODEL,
+	BB_BLACK,
+	BB_BLACK_RC,
+	BB_BLACK_W,
+	BB_BLACK_W_RC,
+	BB_GREEN,
+	BB_GREEN_W,
+	BB_BLUE
+} rc_bb_model_t;
+
+typedef enum rc_bmp_oversample_t {
+	BMP_OVERSAMPLE_1	= (1<<2),
+	BMP_OVERSAMPLE_2	= (2<<2),
+	BMP_OVERSAMPLE_4	= (3<<2),
+	BMP_OVERSAMPLE_8	= (4<<2),
+	BMP_OVERSAMPLE_16	= (5<<2)
+} rc_bmp_oversample_t;
+
+typedef enum rc_bmp_filter_t {
+	BMP_FILTER_OFF	= (0<<2),
+	BMP_FILTER_2	= (1<<2),
+	BMP_FILTER_4	= (2<<2),
+	BMP_FILTER_8	= (3<<2),
+	BMP_FILTER_16	= (4<<2)
+} rc_bmp_filter_t;
+
+typedef enum ss_mode_t {
+	SS_MODE_AUTO,
+	SS_MODE_MANUAL
+} ss_mode_t;
+
+typedef enum rc_accel_fsr_t {
+	A_FSR_2G,
+	A_FSR_4G,
+	A_FSR_8G,
+	A_FSR_16G
+} rc_accel_fsr_t;
+
+typedef enum rc_gyro_fsr_t {
+	G_FSR_250DPS,
+	G_FSR_500DPS,
+	G_FSR_1000DPS,
+	G_FSR_2000DPS
+} rc_gyro_fsr_t;
+
+typedef enum rc_accel_dlpf_t {
+	ACCEL_DLPF_OFF,
+	ACCEL_DLPF_184,
+	ACCEL_DLPF_92,
+	ACCEL_DLPF_41,
+	ACCEL_DLPF_20,
+	ACCEL_DLPF_10,
+	ACCEL_DLPF_5
+} rc_accel_dlpf_t;
+
+typedef enum rc_gyro_dlpf_t {
+	GYRO_DLPF_OFF,
+	GYRO_DLPF_184,
+	GYRO_DLPF_92,
+	GYRO_DLPF_41,
+	GYRO_DLPF_20,
+	GYRO_DLPF_10,
+	GYRO_DLPF_5
+} rc_gyro_dlpf_t;
+
+typedef enum rc_imu_orientation_t {
+	ORIENTATION_Z_UP	= 136,
+	ORIENTATION_Z_DOWN	= 396,
+	ORIENTATION_X_UP	= 14,
+	ORIENTATION_X_DOWN	= 266,
+	ORIENTATION_Y_UP	= 112,
+	ORIENTATION_Y_DOWN	= 336,
+	ORIENTATION_X_FORWARD	= 133,
+	ORIENTATION_X_BACK	= 161
+} rc_imu_orientation_t;
+
+typedef struct rc_imu_config_t {
+	rc_accel_fsr_t accel_fsr;
+	rc_gyro_fsr_t gyro_fsr;
+	rc_gyro_dlpf_t gyro_dlpf;
+	rc_accel_dlpf_t accel_dlpf;
+	int enable_magnetometer;
+	int dmp_sample_rate;
+	int dmp_fetch_accel_gyro;
+	int dmp_auto_calibrate_gyro;
+	rc_imu_orientation_t orientation;
+	float compass_time_constant;
+	int dmp_interrupt_priority;
+	int show_warnings;
+} rc_imu_config_t;
+
+typedef struct rc_imu_data_t {
+	float accel[3];			// m/s²
+	float gyro[3];			// °/s
+	float mag[3];			// µT
+	float temp;			// °C
+	int16_t raw_gyro[3];
+	int16_t raw_accel[3];
+	float accel_to_ms2;
+	float gyro_to_degs;
+	float dmp_quat[4];		// DMP mode only
+	float dmp_TaitBryan[3];
+	float fused_quat[4];
+	float fused_TaitBryan[3];
+	float compass_heading;
+	float compass_heading_raw;
+} rc_imu_data_t;
+
+
+// Flow control, LEDs and buttons
+int rc_initialize(void);
+int rc_cleanup(void);
+rc_state_t rc_get_state(void);
+int rc_set_state(rc_state_t new_state);
+int rc_set_led(int led, int state);
+int rc_blink_led(int led, float hz, float period);
+int rc_gpio_get_value_mmap(int pin);
+int rc_get_pause_button(void);
+int rc_get_mode_button(void);
+
+// Motors
+int rc_enable_motors(void);
+int rc_disable_motors(void);
+int rc_set_motor(int motor, float duty);
+int rc_set_motor_all(float duty);
+int rc_set_motor_free_spin(int motor);
+int rc_set_motor_free_spin_all(void);
+int rc_set_motor_brake(int motor);
+int rc_set_motor_brake_all(void);
+
+// Encoders
+int rc_get_encoder_pos(int ch);
+int rc_set_encoder_pos(int ch, int value);
+
+// ADC
+float rc_battery_voltage(void);
+float rc_dc_jack_voltage(void);
+int rc_adc_raw(int ch);
+float rc_adc_volt(int ch);
+
+// Servos and ESCs
+int rc_enable_servo_power_rail(void);
+int rc_disable_servo_power_rail(void);
+int rc_send_servo_pulse_us(int ch, int us);
+int rc_send_servo_pulse_us_all(int us);
+int rc_send_servo_pulse_normalized(int ch, float input);
+int rc_send_servo_pulse_normalized_all(float input);
+int rc_send_esc_pulse_normalized(int ch, float input);
+int rc_send_esc_pulse_normalized_all(float input);
+int rc_send_oneshot_pulse_normalized(int ch, float input);
+int rc_send_oneshot_pulse_normalized_all(float input);
+
+// DSM radio
+int rc_initialize_dsm(void);
+int rc_stop_dsm_service(void);
+int rc_get_dsm_ch_raw(int channel);
+float rc_get_dsm_ch_normalized(int channel);
+int rc_is_new_dsm_data(void);
+int rc_set_dsm_data_func(int (*func)(void));
+int rc_is_dsm_active(void);
+uint64_t rc_nanos_since_last_dsm_packet(void);
+int rc_get_dsm_resolution(void);
+int rc_num_dsm_channels(void);
+int rc_bind_dsm(void);
+int rc_calibrate_dsm_routine(void);
+
+// BMP280 barometer
+int rc_initialize_barometer(rc_bmp_oversample_t oversample, rc_bmp_filter_t filter);
+int rc_power_off_barometer(void);
+int rc_read_barometer(void);
+float rc_bmp_get_temperature(void);
+float rc_bmp_get_pressure_pa(void);
+float rc_bmp_get_altitude_m(void);
+int rc_set_sea_level_pressure_pa(float pa);
+
+// MPU-9250 IMU
+rc_imu_config_t rc_default_imu_config(void);
+int rc_set_imu_config_to_defaults(rc_imu_config_t *conf);
+int rc_initialize_imu(rc_imu_data_t *data, rc_imu_config_t conf);
+int rc_read_accel_data(rc_imu_data_t *data);
+int rc_read_gyro_data(rc_imu_data_t *data);
+int rc_read_mag_data(rc_imu_data_t *data);
+int rc_read_imu_temp(rc_imu_data_t *data);
+int rc_calibrate_gyro_routine(void);
+int rc_calibrate_mag_routine(void);
+int rc_is_gyro_calibrated(void);
+int rc_is_mag_calibrated(void);
+int rc_power_off_imu(void);
+int rc_initialize_imu_dmp(rc_imu_data_t *data, rc_imu_config_t conf);
+int rc_set_imu_interrupt_func(int (*func)(void));
+int rc_stop_imu_interrupt_func(void);
+int rc_was_last_imu_read_successful(void);
+uint64_t rc_nanos_since_last_imu_interrupt(void);
+
+// I²C
+int rc_i2c_init(int bus, uint8_t devAddr);
+int rc_i2c_close(int bus);
+int rc_i2c_set_device_address(int bus, uint8_t devAddr);
+int rc_i2c_claim_bus(int bus);
+int rc_i2c_release_bus(int bus);
+int rc_i2c_get_in_use_state(int bus);
+int rc_i2c_read_byte(int bus, uint8_t regAddr, uint8_t *data);
+int rc_i2c_read_bytes(int bus, uint8_t regAddr, uint8_t length, uint8_t *data);
+int rc_i2c_read_word(int bus, uint8_t regAddr, uint16_t *data);
+int rc_i2c_read_words(int bus, uint8_t regAddr, uint8_t length, uint16_t *data);
+int rc_i2c_read_bit(int bus, uint8_t regAddr, uint8_t bitNum, uint8_t *data);
+int rc_i2c_write_byte(int bus, uint8_t regAddr, uint8_t data);
+int rc_i2c_write_bytes(int bus, uint8_t regAddr, uint8_t length, uint8_t *data);
+int rc_i2c_write_word(int bus, uint8_t regAddr, uint16_t data);
+int rc_i2c_write_words(int bus, uint8_t regAddr, uint8_t length, uint16_t *data);
+int rc_i2c_write_bit(int bus, uint8_t regAddr, uint8_t bitNum, uint8_t data);
+int rc_i2c_send_bytes(int bus, uint8_t length, uint8_t *data);
+int rc_i2c_send_byte(int bus, uint8_t data);
+
+// SPI
+int rc_spi_init(ss_mode_t ss_mode, int spi_mode, int speed_hz, int slave);
+int rc_spi_fd(int slave);
+int rc_spi_close(int slave);
+int rc_manual_select_spi_slave(int slave);
+int rc_manual_deselect_spi_slave(int slave);
+int rc_spi_send_bytes(char *data, int bytes, int slave);
+int rc_spi_read_bytes(char *data, int bytes, int slave);
+int rc_spi_transfer(char *tx_data, int tx_bytes, char *rx_data, int slave);
+
+// UART
+int rc_uart_init(int bus, int baudrate, float timeout);
+int rc_uart_close(int bus);
+int rc_uart_fd(int bus);
+int rc_uart_flush(int bus);
+int rc_uart_send_bytes(int bus, int bytes, char *data);
+int rc_uart_send_byte(int bus, char data);
+int rc_uart_read_bytes(int bus, int bytes, char *buf);
+int rc_uart_read_line(int bus, int max_bytes, char *buf);
+int rc_uart_bytes_available(int bus);
+
+// CPU and board
+int rc_set_cpu_freq(rc_cpu_freq_t freq);
+rc_cpu_freq_t rc_get_cpu_freq(void);
+rc_bb_model_t rc_get_bb_model(void);
+
+// Time
+uint64_t rc_nanos_since_epoch(void);
+uint64_t rc_nanos_since_boot(void);
+
+#endif /* ROBOTICSCAPE_SIM_H */